@@ -0,0 +1,217 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''Streaming latency benchmark for the vampyhost extension.
+
+Audio is delivered to a plugin at the real-time rate, one step at a
+time, and the latency of each block is measured from the moment its
+last sample would have arrived to the moment its features are
+available to the caller. Two paths are measured:
+
+  block    Plugin.process_block(), with the returned features
+  rolling  vamp.RollingProcessor.feed() followed by a snapshot
+
+The 50th, 99th and 99.9th percentile and maximum latencies are
+reported for each, together with the jitter (standard deviation of
+latency) and the number of blocks that missed their real-time
+deadline of one step. Background threads may be run at the same time
+to show how tail latency holds up under concurrent load.
+
+Run it with the test plugin on VAMP_PATH and the extension on
+PYTHONPATH, e.g.
+
+  VAMP_PATH=test/vamp-test-plugin PYTHONPATH=. python bench/latency.py --step 512 --load 2
+'''
+
+import vamp
+import vampyhost
+
+import argparse
+import json
+import sys
+import threading
+import time
+
+import numpy as np
+
+try:
+    clock = time.perf_counter
+except AttributeError:
+    clock = time.time
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+def pace(arrival, realtime):
+    """Wait until the given arrival time, if pacing at real-time rate,
+    and return the time from which latency is measured."""
+    if not realtime:
+        return clock()
+    delay = arrival - clock()
+    if delay > 0:
+        time.sleep(delay)
+    return arrival
+
+def run_block(audio, rate, step, block, output, realtime):
+    plug = vampyhost.load_plugin(plugin_key, rate, vampyhost.ADAPT_NONE)
+    plug.initialise(1, step, block)
+    index = plug.get_output(output)["output_index"]
+    latencies = []
+    start = clock()
+    for i in range(0, len(audio) - block + 1, step):
+        arrival = pace(start + float(i + block) / rate, realtime)
+        fs = plug.process_block(audio[i : i + block].reshape(1, block),
+                                vampyhost.frame_to_realtime(i, rate))
+        fs.get(index)
+        latencies.append(clock() - arrival)
+    plug.unload()
+    return latencies
+
+def run_rolling(audio, rate, step, block, output, realtime):
+    rp = vamp.RollingProcessor(rate, plugin_key, [ output ], seconds = 5,
+                               step_size = step, block_size = block)
+    latencies = []
+    start = clock()
+    for i in range(0, len(audio) - step + 1, step):
+        arrival = pace(start + float(i + step) / rate, realtime)
+        rp.feed(audio[i : i + step])
+        rp.snapshot(output, contiguous = False)
+        latencies.append(clock() - arrival)
+    rp.unload()
+    return latencies
+
+paths = { "block": run_block, "rolling": run_rolling }
+
+class Load(object):
+    """Background threads that keep running batch collection, which
+    competes with the streaming path for the interpreter lock and for
+    CPU time, until stopped."""
+
+    def __init__(self, threads, rate):
+        self.stopping = False
+        self.iterations = 0
+        rng = np.random.RandomState(1)
+        self.audio = rng.uniform(-1, 1, int(rate * 5)).astype(np.float32)
+        self.rate = rate
+        self.threads = [ threading.Thread(target = self.work) for i in range(threads) ]
+
+    def work(self):
+        while not self.stopping:
+            vamp.collect(self.audio, self.rate, plugin_key, "grid-oss",
+                         transforms = [ "db" ])
+            np.dot(self.audio[:65536].reshape(256, 256),
+                   self.audio[65536:131072].reshape(256, 256))
+            self.iterations += 1
+
+    def __enter__(self):
+        for t in self.threads:
+            t.start()
+        return self
+
+    def __exit__(self, *args):
+        self.stopping = True
+        for t in self.threads:
+            t.join()
+
+def summarise(latencies, step_time):
+    ms = np.array(latencies) * 1000.0
+    return { "blocks": len(ms),
+             "p50": float(np.percentile(ms, 50)),
+             "p99": float(np.percentile(ms, 99)),
+             "p99.9": float(np.percentile(ms, 99.9)),
+             "max": float(ms.max()),
+             "mean": float(ms.mean()),
+             "jitter": float(ms.std()),
+             "missed": int((ms > step_time * 1000.0).sum()) }
+
+def main():
+    parser = argparse.ArgumentParser(description = __doc__.split("\n\n")[0])
+    parser.add_argument("--rate", type = float, default = 44100.0,
+                        help = "sample rate (default 44100)")
+    parser.add_argument("--step", type = int, default = 1024,
+                        help = "step size in samples (default 1024)")
+    parser.add_argument("--block", type = int, default = 0,
+                        help = "block size in samples (default: the step size)")
+    parser.add_argument("--seconds", type = float, default = 20.0,
+                        help = "length of the stream in seconds (default 20)")
+    parser.add_argument("--output", default = "input-summary",
+                        help = "plugin output to read (default input-summary)")
+    parser.add_argument("--path", choices = sorted(paths.keys()) + [ "all" ],
+                        default = "all", help = "path to measure (default all)")
+    parser.add_argument("--load", type = int, default = 0,
+                        help = "number of background load threads (default 0)")
+    parser.add_argument("--no-pace", action = "store_true",
+                        help = "deliver blocks as fast as possible rather than in real time")
+    parser.add_argument("--json", action = "store_true",
+                        help = "print results as JSON")
+    parser.add_argument("--max-p99", type = float, default = 0.0,
+                        help = "fail if any p99 latency exceeds this many milliseconds")
+    args = parser.parse_args()
+
+    block = args.block or args.step
+    if block < args.step:
+        parser.error("block size must be at least the step size")
+
+    rng = np.random.RandomState(0)
+    audio = rng.uniform(-1, 1, int(args.rate * args.seconds)).astype(np.float32)
+    step_time = float(args.step) / args.rate
+
+    names = sorted(paths.keys()) if args.path == "all" else [ args.path ]
+    results = {}
+
+    with Load(args.load, args.rate):
+        for name in names:
+            latencies = paths[name](audio, args.rate, args.step, block,
+                                    args.output, not args.no_pace)
+            results[name] = summarise(latencies, step_time)
+
+    if args.json:
+        print(json.dumps({ "step": args.step, "block": block,
+                           "load": args.load, "results": results },
+                         indent = 2, sort_keys = True))
+    else:
+        print("step %d, block %d (%.2f ms per step), %d load thread(s)%s" %
+              (args.step, block, step_time * 1000.0, args.load,
+               ", unpaced" if args.no_pace else ""))
+        print("%-8s %8s %9s %9s %9s %9s %9s %7s" %
+              ("path", "blocks", "p50 ms", "p99 ms", "p99.9 ms",
+               "max ms", "jitter", "missed"))
+        for name in names:
+            r = results[name]
+            print("%-8s %8d %9.3f %9.3f %9.3f %9.3f %9.3f %7d" %
+                  (name, r["blocks"], r["p50"], r["p99"], r["p99.9"],
+                   r["max"], r["jitter"], r["missed"]))
+
+    if args.max_p99 > 0:
+        worst = max(r["p99"] for r in results.values())
+        if worst > args.max_p99:
+            print("FAILED: p99 latency %.3f ms exceeds %.3f ms" % (worst, args.max_p99))
+            sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''Training workload for profile-guided optimisation of the vampyhost
+extension (see the "pgo" target in Makefile.inc and the
+VAMPYHOST_OPTIMISE modes in setup.py).
+
+This exercises the per-block paths that real analyses spend their
+time in, using the Vamp test plugin: whole-buffer collection of
+dense and list outputs, with and without transforms, the generator
+interface, direct process_block calls, and rolling collection. Run
+it with the test plugin on VAMP_PATH and the instrumented extension
+on PYTHONPATH.'''
+
+import vamp
+import vampyhost
+
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+freq_key = "vamp-test-plugin:vamp-test-plugin-freq"
+
+rate = 44100.0
+seconds = 60
+repeats = 3
+
+def main():
+    rng = np.random.RandomState(0)
+    mono = rng.uniform(-1, 1, int(rate * seconds)).astype(np.float32)
+    stereo = np.vstack([ mono, mono[::-1] ])
+
+    for i in range(repeats):
+
+        for data in [ mono, stereo ]:
+            vamp.collect(data, rate, plugin_key, [ "input-summary", "grid-oss", "curve-vsr", "notes-regions" ])
+            vamp.collect(data, rate, plugin_key, "grid-oss", transforms = [ "db", "delta" ])
+            vamp.collect(data, rate, freq_key, "input-summary")
+
+        for f in vamp.process_audio(mono, rate, plugin_key, "input-timestamp"):
+            pass
+
+        plug = vampyhost.load_plugin(plugin_key, rate, vampyhost.ADAPT_NONE)
+        plug.initialise(1, 1024, 1024)
+        for j in range(0, len(mono) - 1024, 1024):
+            plug.process_block(mono[j : j + 1024].reshape(1, 1024),
+                               vampyhost.frame_to_realtime(j, rate))
+        plug.get_remaining_features()
+        plug.unload()
+
+        rp = vamp.RollingProcessor(rate, plugin_key, [ "input-summary", "grid-oss" ], seconds = 5)
+        for j in range(0, len(mono), 4410):
+            rp.feed(mono[j : j + 4410])
+            if j % 44100 == 0:
+                rp.snapshot("grid-oss")
+        rp.finish()
+        rp.unload()
+
+if __name__ == "__main__":
+    main()
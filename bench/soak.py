@@ -0,0 +1,300 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''Long-running soak test for the vampyhost extension, to catch memory
+leaks before they reach long-lived worker processes.
+
+This repeatedly loads, runs, and unloads the Vamp test plugin through
+every public entry point of the vamp and vampyhost modules, including
+their error paths, until a given number of process blocks have been
+run. Resident set size, native heap in use (where glibc's mallinfo2
+is available), traced Python allocations, and the number of live
+Python objects are sampled as it goes. After a warm-up period, any
+growth in resident size or native heap beyond the threshold is
+reported as a failure, with a nonzero exit status.
+
+It needs Python 3.4 or newer, for tracemalloc. Run it with the test
+plugin on VAMP_PATH and the extension on PYTHONPATH, e.g.
+
+  VAMP_PATH=test/vamp-test-plugin PYTHONPATH=. python bench/soak.py --blocks 1000000
+'''
+
+import vamp
+import vampyhost
+
+import argparse
+import ctypes
+import gc
+import os
+import pickle
+import resource
+import sys
+import time
+
+try:
+    import tracemalloc
+except ImportError:
+    sys.exit("bench/soak.py requires Python 3.4 or newer (for tracemalloc): "
+             "build the module for Python 3 and run it with that")
+
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+freq_key = "vamp-test-plugin:vamp-test-plugin-freq"
+
+rate = 44100.0
+blocksize = 1024
+
+def rss_bytes():
+    """Current resident set size. Where /proc is unavailable, this
+    falls back to the peak resident size, which still shows growth."""
+    try:
+        with open("/proc/self/statm") as f:
+            return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+    except (IOError, OSError):
+        peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        # kilobytes on Linux, bytes on macOS
+        return peak if sys.platform == "darwin" else peak * 1024
+
+class Mallinfo2(ctypes.Structure):
+    _fields_ = [ (name, ctypes.c_size_t) for name in
+                 [ "arena", "ordblks", "smblks", "hblks", "hblkhd",
+                   "usmblks", "fsmblks", "uordblks", "fordblks",
+                   "keepcost" ] ]
+
+def native_heap_function():
+    try:
+        libc = ctypes.CDLL(None)
+        mallinfo2 = libc.mallinfo2
+    except (OSError, AttributeError):
+        return None
+    mallinfo2.restype = Mallinfo2
+    # in-use bytes, both from the arena and from mmapped chunks
+    return lambda: mallinfo2().uordblks + mallinfo2().hblkhd
+
+native_heap_bytes = native_heap_function()
+
+def expect_error(fn, *args):
+    try:
+        fn(*args)
+    except Exception:
+        return
+    raise AssertionError("Expected " + fn.__name__ + " to fail")
+
+class Workload(object):
+    """One iteration of the soak workload. Each call to run() returns
+    the number of process blocks it ran."""
+
+    def __init__(self, seconds):
+        rng = np.random.RandomState(0)
+        self.mono = rng.uniform(-1, 1, int(rate * seconds)).astype(np.float32)
+        self.stereo = np.vstack([ self.mono, self.mono[::-1] ])
+        self.blocks = (len(self.mono) + blocksize - 1) // blocksize
+        self.admission = vamp.Admission(2, max_queued = 0)
+
+    def metadata(self):
+        vamp.list_plugins()
+        vamp.list_plugins(include = [ "vamp-test-*" ], exclude = [ "none" ])
+        vampyhost.get_plugin_path()
+        vamp.get_outputs_of(plugin_key)
+        vamp.get_category_of(plugin_key)
+        vamp.get_parameters_of(plugin_key)
+        vampyhost.get_library_for(plugin_key)
+        expect_error(vamp.get_outputs_of, "nonexistent:plugin")
+        expect_error(vampyhost.load_plugin, "nonexistent:plugin", rate, 0)
+        expect_error(vampyhost.get_outputs_of, 1)
+        return 0
+
+    def realtime(self):
+        for i in range(100):
+            t = vampyhost.frame_to_realtime(i * blocksize, rate)
+            u = vampyhost.RealTime('seconds', 0.5) + t - t
+            t < u and t <= u and t == t and t != u
+            str(t)
+            repr(t)
+            t.to_float()
+            t.values()
+            t.sec + t.nsec
+            pickle.loads(pickle.dumps(t))
+        t == 1
+        expect_error(lambda: t < 1)
+        expect_error(lambda: t + 1)
+        expect_error(vampyhost.RealTime, "weeks", 3)
+        expect_error(vampyhost.RealTime, "x", "y", "z")
+        return 0
+
+    def blockwise(self):
+        plug = vampyhost.load_plugin(plugin_key, rate, vampyhost.ADAPT_NONE)
+        plug.get_outputs()
+        plug.get_output("input-summary")
+        plug.set_parameter_value("produce_output", 1)
+        plug.set_parameter_values({ "produce_output": 1 })
+        plug.get_parameter_value("produce_output")
+        expect_error(plug.get_output, "nonexistent")
+        expect_error(plug.process_block, self.mono[:blocksize].reshape(1, -1),
+                     vampyhost.RealTime())
+        plug.initialise(1, blocksize, blocksize)
+        plug.attach_rolling(9, 256, [])
+        n = 0
+        for i in range(0, len(self.mono) - blocksize, blocksize):
+            plug.process_block(self.mono[i : i + blocksize].reshape(1, -1),
+                               vampyhost.frame_to_realtime(i, rate))
+            n += 1
+        plug.rolling_snapshot(9, False)
+        plug.rolling_snapshot(9, True)
+        plug.get_remaining_features()
+        expect_error(plug.process_block, self.stereo[:, :blocksize],
+                     vampyhost.RealTime())
+        expect_error(plug.collect, self.mono, 100)
+        plug.reset()
+        plug.detach_rolling(9)
+        plug.unload()
+        expect_error(plug.get_outputs)
+        return n
+
+    def collect(self):
+        vamp.collect(self.mono, rate, plugin_key, "input-summary")
+        vamp.collect(self.stereo, rate, plugin_key,
+                     [ "grid-oss", "curve-vsr", "notes-regions", "instants" ])
+        vamp.collect(self.mono, rate, plugin_key, "grid-oss",
+                     transforms = [ ("db", 1e-6), "l2", "delta2" ])
+        vamp.collect(self.mono, rate, plugin_key, "grid-oss",
+                     memory_limit = 4096)
+        vamp.collect(self.mono, rate, freq_key, "input-summary")
+        expect_error(vamp.collect, self.mono, rate, plugin_key, "grid-oss",
+                     {}, [ "nonexistent" ])
+        return 5 * self.blocks
+
+    def process(self):
+        for f in vamp.process_audio(self.mono, rate, plugin_key, "input-timestamp"):
+            pass
+        for f in vamp.process_audio_multiple_outputs(self.stereo, rate, plugin_key,
+                                                     [ "input-summary", "instants" ]):
+            pass
+        return 2 * self.blocks
+
+    def analysis(self):
+        dense = vamp.collect(self.mono, rate, plugin_key, "grid-oss")
+        segments = vamp.collect(self.mono, rate, plugin_key, "notes-regions")
+        vamp.pool(dense, segments, "mean")
+        vamp.self_similarity(dense, "cosine", band = 16)
+        vamp.cascade(self.mono, rate, plugin_key, "input-summary",
+                     plugin_key, "input-timestamp", condition = 0, pre_roll = 0.1)
+        expect_error(vamp.self_similarity, dense, "nonexistent")
+        return 4 * self.blocks
+
+    def streaming(self):
+        rp = vamp.RollingProcessor(rate, plugin_key, [ "input-summary", "grid-oss" ],
+                                   seconds = 2)
+        for i in range(0, len(self.mono), 4410):
+            rp.feed(self.mono[i : i + 4410])
+        rp.snapshot("grid-oss")
+        rp.snapshot("input-summary", contiguous = False)
+        rp.finish()
+        rp.unload()
+        return self.blocks
+
+    def admission_control(self):
+        with self.admission.admit(plugin_key, "batch"):
+            with self.admission.admit(plugin_key):
+                expect_error(self.admission.control.acquire, plugin_key, 0, 0.0)
+        self.admission.metrics()
+        return 0
+
+    def run(self):
+        return (self.metadata() + self.realtime() + self.blockwise() +
+                self.collect() + self.process() + self.analysis() +
+                self.streaming() + self.admission_control())
+
+def mb(n):
+    return n / (1024.0 * 1024.0)
+
+def main():
+    parser = argparse.ArgumentParser(description = __doc__.split("\n\n")[0])
+    parser.add_argument("--blocks", type = int, default = 1000000,
+                        help = "total number of process blocks to run (default 1000000)")
+    parser.add_argument("--seconds", type = float, default = 10.0,
+                        help = "length of the test audio in seconds (default 10)")
+    parser.add_argument("--warmup", type = float, default = 0.1,
+                        help = "fraction of the run to treat as warm-up (default 0.1)")
+    parser.add_argument("--samples", type = int, default = 20,
+                        help = "number of measurements to report (default 20)")
+    parser.add_argument("--max-growth", type = float, default = 8.0,
+                        help = "largest growth in MB allowed after warm-up (default 8)")
+    args = parser.parse_args()
+
+    tracemalloc.start()
+
+    work = Workload(args.seconds)
+    warmup_blocks = int(args.blocks * args.warmup)
+    interval = max(1, (args.blocks - warmup_blocks) // args.samples)
+
+    print("%10s %8s %10s %10s %10s %10s" %
+          ("blocks", "secs", "rss MB", "heap MB", "py MB", "objects"))
+
+    start = time.time()
+    blocks = 0
+    next_sample = warmup_blocks
+    samples = []
+
+    while blocks < args.blocks:
+        blocks += work.run()
+        if blocks >= next_sample:
+            gc.collect()
+            sample = (blocks,
+                      rss_bytes(),
+                      native_heap_bytes() if native_heap_bytes else 0,
+                      tracemalloc.get_traced_memory()[0],
+                      len(gc.get_objects()))
+            samples.append(sample)
+            print("%10d %8.1f %10.2f %10.2f %10.2f %10d" %
+                  (blocks, time.time() - start, mb(sample[1]),
+                   mb(sample[2]), mb(sample[3]), sample[4]))
+            sys.stdout.flush()
+            next_sample = blocks + interval
+
+    first, last = samples[0], samples[-1]
+    growth = [ ("resident size", last[1] - first[1]),
+               ("native heap", last[2] - first[2]),
+               ("Python heap", last[3] - first[3]) ]
+
+    failed = False
+    for (name, g) in growth:
+        print("%s growth after warm-up: %.2f MB" % (name, mb(g)))
+        if mb(g) > args.max_growth:
+            failed = True
+    print("live object growth after warm-up: %d" % (last[4] - first[4]))
+
+    if failed:
+        print("FAILED: growth exceeds %.2f MB" % args.max_growth)
+        sys.exit(1)
+    print("OK")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "AdmissionControl.h"
+
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+AdmissionControl::AdmissionControl(size_t maxRunning,
+                                   size_t maxRunningPerKey,
+                                   long maxQueued,
+                                   size_t interactiveReserve) :
+    m_maxRunning(max(maxRunning, size_t(1))),
+    m_maxRunningPerKey(maxRunningPerKey),
+    m_maxQueued(maxQueued),
+    m_interactiveReserve(min(interactiveReserve, m_maxRunning - 1)),
+    m_running(0),
+    m_nextTicket(0)
+{
+}
+
+bool
+AdmissionControl::hasCapacity(const string &key, Lane lane) const
+{
+    if (m_running >= m_maxRunning) return false;
+
+    if (lane == Batch &&
+        m_metrics[Batch].running >= m_maxRunning - m_interactiveReserve) {
+        return false;
+    }
+
+    if (m_maxRunningPerKey > 0) {
+        map<string, size_t>::const_iterator i = m_runningPerKey.find(key);
+        if (i != m_runningPerKey.end() && i->second >= m_maxRunningPerKey) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+AdmissionControl::mayProceed(const Waiter &waiter) const
+{
+    if (!hasCapacity(waiter.key, waiter.lane)) return false;
+
+    // Defer to any waiter ahead of us that could itself run now
+    for (size_t i = 0; i < m_waiting.size(); ++i) {
+        const Waiter *other = m_waiting[i];
+        if (other == &waiter) continue;
+        bool ahead = (other->lane < waiter.lane ||
+                      (other->lane == waiter.lane &&
+                       other->ticket < waiter.ticket));
+        if (ahead && hasCapacity(other->key, other->lane)) return false;
+    }
+
+    return true;
+}
+
+void
+AdmissionControl::admit(const string &key, Lane lane, double waited)
+{
+    ++m_running;
+    ++m_runningPerKey[key];
+
+    LaneMetrics &metrics = m_metrics[lane];
+    ++metrics.running;
+    ++metrics.admitted;
+    metrics.totalWait += waited;
+    if (waited > metrics.maxWait) metrics.maxWait = waited;
+}
+
+void
+AdmissionControl::removeWaiter(const Waiter *waiter)
+{
+    m_waiting.erase(find(m_waiting.begin(), m_waiting.end(), waiter));
+    --m_metrics[waiter->lane].queued;
+}
+
+AdmissionControl::Outcome
+AdmissionControl::acquire(const string &key, Lane lane, double timeout,
+                          double &waited)
+{
+    typedef chrono::steady_clock Clock;
+
+    waited = 0.0;
+
+    unique_lock<mutex> lock(m_mutex);
+
+    Waiter waiter;
+    waiter.ticket = m_nextTicket++;
+    waiter.key = key;
+    waiter.lane = lane;
+
+    if (mayProceed(waiter)) {
+        admit(key, lane, 0.0);
+        return Admitted;
+    }
+
+    if (m_maxQueued >= 0 && m_metrics[lane].queued >= size_t(m_maxQueued)) {
+        ++m_metrics[lane].rejected;
+        return Rejected;
+    }
+
+    m_waiting.push_back(&waiter);
+    ++m_metrics[lane].queued;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start;
+    if (timeout >= 0.0) {
+        deadline += chrono::duration_cast<Clock::duration>
+            (chrono::duration<double>(timeout));
+    }
+
+    while (!mayProceed(waiter)) {
+        if (timeout < 0.0) {
+            m_condition.wait(lock);
+        } else if (m_condition.wait_until(lock, deadline) ==
+                   cv_status::timeout && !mayProceed(waiter)) {
+            removeWaiter(&waiter);
+            ++m_metrics[lane].timedOut;
+            m_condition.notify_all();
+            waited = chrono::duration<double>(Clock::now() - start).count();
+            return TimedOut;
+        }
+    }
+
+    removeWaiter(&waiter);
+    waited = chrono::duration<double>(Clock::now() - start).count();
+    admit(key, lane, waited);
+
+    // Waiters behind us may have been deferring to us, and there may
+    // be capacity left for them
+    m_condition.notify_all();
+    return Admitted;
+}
+
+void
+AdmissionControl::release(const string &key, Lane lane)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    map<string, size_t>::iterator i = m_runningPerKey.find(key);
+    if (i == m_runningPerKey.end() || m_metrics[lane].running == 0) {
+        return; // not admitted: ignore
+    }
+    if (--i->second == 0) m_runningPerKey.erase(i);
+    --m_running;
+    --m_metrics[lane].running;
+
+    m_condition.notify_all();
+}
+
+AdmissionControl::LaneMetrics
+AdmissionControl::getMetrics(Lane lane) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_metrics[lane];
+}
@@ -0,0 +1,132 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  AdmissionControl: Limit the number of processing calls running at
+  once, globally and per plugin key, queueing the rest in two
+  priority lanes (interactive ahead of batch) up to a maximum queue
+  depth per lane beyond which calls are rejected at once.
+*/
+
+#ifndef VAMPYHOST_ADMISSION_CONTROL_H
+#define VAMPYHOST_ADMISSION_CONTROL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+class AdmissionControl
+{
+public:
+    enum Lane { Interactive = 0, Batch = 1 };
+    enum { LaneCount = 2 };
+
+    enum Outcome { Admitted, Rejected, TimedOut };
+
+    struct LaneMetrics {
+        LaneMetrics() :
+            admitted(0), rejected(0), timedOut(0), queued(0), running(0),
+            totalWait(0.0), maxWait(0.0) { }
+        size_t admitted;
+        size_t rejected;
+        size_t timedOut;
+        size_t queued;
+        size_t running;
+        double totalWait; // seconds
+        double maxWait;   // seconds
+    };
+
+    /**
+     * Construct with the maximum number of calls that may run at
+     * once (at least 1); the maximum that may run at once for any
+     * one key (0 for no per-key limit); the maximum number of calls
+     * that may wait in each lane's queue, so that a batch backlog
+     * cannot shut out interactive calls (negative for no limit, 0 to
+     * reject any call that cannot run at once); and the number of
+     * running slots reserved for the interactive lane, which batch
+     * calls may not take.
+     */
+    AdmissionControl(size_t maxRunning, size_t maxRunningPerKey,
+                     long maxQueued, size_t interactiveReserve);
+
+    /**
+     * Wait until a call for the given key in the given lane may run,
+     * and admit it. Interactive calls are admitted ahead of batch
+     * calls, and calls in the same lane in the order they arrived,
+     * except that a call held back only by its key's limit does not
+     * hold back calls for other keys. If the queues are full, return
+     * Rejected at once; if timeout is non-negative and that many
+     * seconds pass without admission, return TimedOut. On return,
+     * waited holds the time spent waiting in seconds. An admitted
+     * call must later be released with release().
+     */
+    Outcome acquire(const std::string &key, Lane lane, double timeout,
+                    double &waited);
+
+    void release(const std::string &key, Lane lane);
+
+    LaneMetrics getMetrics(Lane lane) const;
+
+private:
+    struct Waiter {
+        unsigned long long ticket;
+        std::string key;
+        Lane lane;
+    };
+
+    size_t m_maxRunning;
+    size_t m_maxRunningPerKey;
+    long m_maxQueued;
+    size_t m_interactiveReserve;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<const Waiter *> m_waiting;
+    std::map<std::string, size_t> m_runningPerKey;
+    size_t m_running;
+    unsigned long long m_nextTicket;
+    LaneMetrics m_metrics[LaneCount];
+
+    bool hasCapacity(const std::string &key, Lane lane) const;
+    bool mayProceed(const Waiter &waiter) const;
+    void admit(const std::string &key, Lane lane, double waited);
+    void removeWaiter(const Waiter *waiter);
+};
+
+#endif
@@ -0,0 +1,628 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "FeatureCollector.h"
+
+// define a unique API pointer 
+#define PY_ARRAY_UNIQUE_SYMBOL VAMPYHOST_ARRAY_API
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#define NO_IMPORT_ARRAY
+#include "numpy/arrayobject.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAMPYHOST_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace Vamp;
+
+static const char *valuesCapsuleName = "vampyhost.FeatureCollector.values";
+static const char *indicesCapsuleName = "vampyhost.FeatureCollector.indices";
+
+static void
+deleteValues(PyObject *capsule)
+{
+    delete (vector<float> *)PyCapsule_GetPointer(capsule, valuesCapsuleName);
+}
+
+static void
+deleteIndices(PyObject *capsule)
+{
+    delete (vector<int32_t> *)PyCapsule_GetPointer(capsule, indicesCapsuleName);
+}
+
+static double
+toSeconds(const RealTime &rt)
+{
+    return rt.sec + double(rt.nsec) / 1000000000.0;
+}
+
+// Return a one-dimensional array that takes ownership of the given
+// vector, which is deleted when the array is
+template <typename T>
+static PyObject *
+adoptVector(vector<T> *v, int typenum, const char *capsuleName,
+            PyCapsule_Destructor destructor)
+{
+    npy_intp dims[1];
+    dims[0] = v->size();
+
+    if (v->empty()) {
+        delete v;
+        return PyArray_SimpleNew(1, dims, typenum);
+    }
+
+    PyObject *capsule = PyCapsule_New(v, capsuleName, destructor);
+    if (!capsule) {
+        delete v;
+        return 0;
+    }
+
+    PyObject *arr = PyArray_SimpleNewFromData(1, dims, typenum, &(*v)[0]);
+    if (!arr) {
+        Py_DECREF(capsule);
+        return 0;
+    }
+
+    if (PyArray_SetBaseObject((PyArrayObject *)arr, capsule) < 0) {
+        Py_DECREF(arr);
+        return 0;
+    }
+
+    return arr;
+}
+
+FeatureCollector::FeatureCollector(const Plugin::OutputDescriptor &desc) :
+    m_shape(deduceShape(desc)),
+    m_bins(0),
+    m_width(0),
+    m_count(0),
+    m_values(new vector<float>),
+    m_spillFile(0),
+    m_spillFd(-1),
+    m_spillThreshold(0),
+    m_spilledRows(0),
+    m_spillFailed(false),
+    m_sparse(false),
+    m_sparseData(0),
+    m_sparseIndices(0),
+    m_sparseIndptr(0),
+    m_sampleType(desc.sampleType),
+    m_sampleRate(desc.sampleRate),
+    m_lastTime(0.0),
+    m_out(0),
+    m_outTimes(0),
+    m_outData(0),
+    m_outTimesData(0),
+    m_outRows(0),
+    m_outTimesRows(0)
+{
+    if (m_shape != ListShape) {
+        m_bins = desc.binCount;
+        m_width = m_bins;
+    }
+}
+
+FeatureCollector::~FeatureCollector()
+{
+    delete m_values;
+    delete m_sparseData;
+    delete m_sparseIndices;
+    delete m_sparseIndptr;
+    Py_XDECREF(m_spillFile);
+    Py_XDECREF(m_out);
+    Py_XDECREF(m_outTimes);
+}
+
+FeatureCollector::Shape
+FeatureCollector::deduceShape(const Plugin::OutputDescriptor &desc)
+{
+    if (desc.hasDuration) return ListShape;
+    if (desc.sampleType == Plugin::OutputDescriptor::VariableSampleRate) {
+        return ListShape;
+    }
+    if (!desc.hasFixedBinCount) return ListShape;
+    if (desc.binCount == 0) return ListShape;
+    if (desc.binCount == 1) return VectorShape;
+    return MatrixShape;
+}
+
+bool
+FeatureCollector::setTransforms(const FeatureTransform &transforms)
+{
+    if (!transforms.empty() && m_shape == ListShape) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Transforms can only be applied to outputs with vector or matrix shape");
+        return false;
+    }
+    m_transforms = transforms;
+    m_transforms.reset();
+    m_width = m_transforms.getOutputWidth(m_bins);
+    return true;
+}
+
+bool
+FeatureCollector::setSpillFile(size_t memoryLimit, PyObject *file)
+{
+    if (m_shape == ListShape) return true;
+
+    int fd = PyObject_AsFileDescriptor(file);
+    if (fd < 0) return false;
+
+    Py_INCREF(file);
+    Py_XDECREF(m_spillFile);
+    m_spillFile = file;
+    m_spillFd = fd;
+    m_spillThreshold = memoryLimit / sizeof(float);
+
+    // Values are spilled as soon as a whole row takes them to the
+    // threshold, so reserving that many rows up front means the
+    // buffer never reallocates, and never overshoots the threshold
+    // by the doubling of a growing vector
+    size_t rows = max((m_spillThreshold + m_width - 1) / m_width, size_t(1));
+    m_values->reserve(rows * m_width);
+    return true;
+}
+
+bool
+FeatureCollector::setSparse(bool sparse)
+{
+    if (sparse && m_spillFd >= 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Sparse collection cannot be combined with a memory limit");
+        return false;
+    }
+
+    m_sparse = (sparse && m_shape != ListShape && m_width > 1);
+
+    if (m_sparse && !m_sparseIndptr) {
+        m_sparseData = new vector<float>;
+        m_sparseIndices = new vector<int32_t>;
+        m_sparseIndptr = new vector<int32_t>(1, 0);
+    }
+    return true;
+}
+
+// Check that an out array is a writeable C-contiguous array of the
+// given type, number of dimensions and (if ndim is 2) width
+static bool
+checkOutArray(PyObject *obj, int type, int ndim, size_t width,
+              const char *name)
+{
+    if (!PyArray_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "%s must be a NumPy array", name);
+        return false;
+    }
+    PyArrayObject *arr = (PyArrayObject *)obj;
+    if (PyArray_TYPE(arr) != type) {
+        PyErr_Format(PyExc_TypeError, "%s must have dtype %s", name,
+                     type == NPY_FLOAT ? "float32" : "float64");
+        return false;
+    }
+    if (!PyArray_ISCARRAY(arr)) {
+        PyErr_Format(PyExc_ValueError,
+                     "%s must be a writeable C-contiguous array", name);
+        return false;
+    }
+    if (PyArray_NDIM(arr) != ndim ||
+        (ndim == 2 && size_t(PyArray_DIMS(arr)[1]) != width)) {
+        if (ndim == 2) {
+            PyErr_Format(PyExc_ValueError,
+                         "%s must be two-dimensional with %d columns",
+                         name, int(width));
+        } else {
+            PyErr_Format(PyExc_ValueError,
+                         "%s must be one-dimensional", name);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool
+FeatureCollector::setOutputArrays(PyObject *out, PyObject *outTimes)
+{
+    if (out == Py_None) out = 0;
+    if (outTimes == Py_None) outTimes = 0;
+    if (!out && !outTimes) return true;
+
+    if (m_shape == ListShape) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Out arrays can only be used for outputs with vector or matrix shape");
+        return false;
+    }
+    if (m_spillFd >= 0 || m_sparse) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Out arrays cannot be combined with a memory limit or sparse collection");
+        return false;
+    }
+
+    if (out && !checkOutArray(out, NPY_FLOAT, m_width == 1 ? 1 : 2,
+                              m_width, "out")) {
+        return false;
+    }
+    if (outTimes && !checkOutArray(outTimes, NPY_DOUBLE, 1, 0, "out_times")) {
+        return false;
+    }
+
+    Py_XINCREF(out);
+    Py_XDECREF(m_out);
+    m_out = out;
+    m_outData = (out ? (float *)PyArray_DATA((PyArrayObject *)out) : 0);
+    m_outRows = (out ? PyArray_DIMS((PyArrayObject *)out)[0] : 0);
+
+    Py_XINCREF(outTimes);
+    Py_XDECREF(m_outTimes);
+    m_outTimes = outTimes;
+    m_outTimesData = (outTimes ? (double *)PyArray_DATA((PyArrayObject *)outTimes) : 0);
+    m_outTimesRows = (outTimes ? PyArray_DIMS((PyArrayObject *)outTimes)[0] : 0);
+
+    return true;
+}
+
+static bool
+writeAll(int fd, const char *data, size_t bytes)
+{
+    while (bytes > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, unsigned(min(bytes, size_t(1) << 30)));
+#else
+        ssize_t n = write(fd, data, bytes);
+#endif
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+void
+FeatureCollector::spill()
+{
+    if (m_values->empty() || m_spillFailed) return;
+
+    if (!writeAll(m_spillFd, (const char *)&(*m_values)[0],
+                  m_values->size() * sizeof(float))) {
+        m_error = string("Failed to write collected values to spill file: ") +
+            strerror(errno);
+        m_spillFailed = true;
+        return;
+    }
+
+    m_spilledRows += m_values->size() / m_width;
+    m_values->clear(); // keeps its capacity for the next chunk
+}
+
+void
+FeatureCollector::add(const Plugin::FeatureList &features,
+                      const RealTime &blockTimestamp)
+{
+    if (m_shape == ListShape) {
+        m_features.insert(m_features.end(), features.begin(), features.end());
+        m_count += features.size();
+        return;
+    }
+
+    for (size_t i = 0; i < features.size(); ++i) {
+
+        const vector<float> &v = features[i].values;
+
+        if (v.size() != m_bins) {
+            if (m_error.empty()) {
+                ostringstream os;
+                os << "Feature " << m_count << " has " << v.size()
+                   << " values, but output has bin count " << m_bins;
+                m_error = os.str();
+            }
+            continue;
+        }
+
+        if (m_outTimesData) {
+            const Plugin::Feature &f = features[i];
+            double t;
+            if (m_sampleType == Plugin::OutputDescriptor::OneSamplePerStep) {
+                t = toSeconds(blockTimestamp);
+            } else if (f.hasTimestamp) {
+                t = toSeconds(f.timestamp);
+            } else if (m_count > 0 && m_sampleRate > 0.f) {
+                t = m_lastTime + 1.0 / m_sampleRate;
+            } else {
+                t = toSeconds(blockTimestamp);
+            }
+            m_lastTime = t;
+            if (m_count < m_outTimesRows) {
+                m_outTimesData[m_count] = t;
+            } else if (m_error.empty()) {
+                m_error = "More features than elements in the out_times array";
+            }
+        }
+
+        if (m_out) {
+            if (m_count >= m_outRows) {
+                if (m_error.empty()) {
+                    m_error = "More features than rows in the out array";
+                }
+                ++m_count;
+                continue;
+            }
+            float *row = m_outData + m_count * m_width;
+            if (m_transforms.empty()) {
+                for (size_t j = 0; j < m_bins; ++j) {
+                    row[j] = v[j];
+                }
+            } else {
+                m_transforms.apply(&v[0], m_bins, row);
+            }
+            ++m_count;
+            continue;
+        }
+
+        if (m_sparse) {
+            const float *row = &v[0];
+            if (!m_transforms.empty()) {
+                m_row.resize(m_width);
+                m_transforms.apply(&v[0], m_bins, &m_row[0]);
+                row = &m_row[0];
+            }
+            addSparse(row);
+            ++m_count;
+            continue;
+        }
+
+        size_t base = m_values->size();
+        m_values->resize(base + m_width);
+
+        if (m_transforms.empty()) {
+            for (size_t j = 0; j < m_bins; ++j) {
+                (*m_values)[base + j] = v[j];
+            }
+        } else {
+            m_transforms.apply(&v[0], m_bins, &(*m_values)[base]);
+        }
+
+        ++m_count;
+
+        if (m_spillFd >= 0 && m_values->size() >= m_spillThreshold) {
+            spill();
+        }
+    }
+}
+
+// Count the values that are not zero (NaN counting as not zero), four
+// at a time where SSE2 is available
+static size_t
+countNonZero(const float *row, size_t n)
+{
+    size_t nnz = 0;
+    size_t j = 0;
+#ifdef VAMPYHOST_SSE2
+    // Each comparison gives -1 in the lanes that are not zero, so
+    // subtracting it counts them, with no branches
+    const __m128 zero = _mm_setzero_ps();
+    __m128i counts = _mm_setzero_si128();
+    for (; j + 4 <= n; j += 4) {
+        __m128 nz = _mm_cmpneq_ps(_mm_loadu_ps(row + j), zero);
+        counts = _mm_sub_epi32(counts, _mm_castps_si128(nz));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, counts);
+    nnz = size_t(unsigned(lanes[0])) + unsigned(lanes[1]) +
+        unsigned(lanes[2]) + unsigned(lanes[3]);
+#endif
+    for (; j < n; ++j) {
+        nnz += (row[j] != 0.f);
+    }
+    return nnz;
+}
+
+void
+FeatureCollector::addSparse(const float *row)
+{
+    // Count the non-zero values first, so that an all-zero row (the
+    // common case for activations) costs just the one pass
+    size_t nnz = countNonZero(row, m_width);
+
+    if (nnz > 0) {
+
+        size_t base = m_sparseData->size();
+
+        if (base + nnz > size_t(INT32_MAX)) {
+            if (m_error.empty()) {
+                m_error = "Too many non-zero values for sparse collection";
+            }
+            m_sparseIndptr->push_back(int32_t(base));
+            return;
+        }
+
+        m_sparseData->resize(base + nnz);
+        m_sparseIndices->resize(base + nnz);
+
+        float *data = &(*m_sparseData)[base];
+        int32_t *indices = &(*m_sparseIndices)[base];
+
+        size_t k = 0;
+        for (size_t j = 0; j < m_width; ++j) {
+            if (row[j] != 0.f) {
+                data[k] = row[j];
+                indices[k] = int32_t(j);
+                ++k;
+            }
+        }
+    }
+
+    m_sparseIndptr->push_back(int32_t(m_sparseData->size()));
+}
+
+PyObject *
+FeatureCollector::takeSparse()
+{
+    Py_ssize_t rows = Py_ssize_t(m_sparseIndptr->size() - 1);
+
+    // The arrays take over our storage
+    PyObject *data = adoptVector(m_sparseData, NPY_FLOAT,
+                                 valuesCapsuleName, deleteValues);
+    PyObject *indices = adoptVector(m_sparseIndices, NPY_INT32,
+                                    indicesCapsuleName, deleteIndices);
+    PyObject *indptr = adoptVector(m_sparseIndptr, NPY_INT32,
+                                   indicesCapsuleName, deleteIndices);
+
+    m_sparseData = new vector<float>;
+    m_sparseIndices = new vector<int32_t>;
+    m_sparseIndptr = new vector<int32_t>(1, 0);
+
+    if (!data || !indices || !indptr) {
+        Py_XDECREF(data);
+        Py_XDECREF(indices);
+        Py_XDECREF(indptr);
+        return 0;
+    }
+
+    return Py_BuildValue("(NNN(nn))", data, indices, indptr,
+                         rows, Py_ssize_t(m_width));
+}
+
+PyObject *
+FeatureCollector::mapSpilled()
+{
+    spill();
+    if (m_spillFailed) {
+        PyErr_SetString(PyExc_IOError, m_error.c_str());
+        return 0;
+    }
+
+    PyObject *shape = (m_width == 1 ?
+                       Py_BuildValue("(n)", Py_ssize_t(m_spilledRows)) :
+                       Py_BuildValue("(nn)", Py_ssize_t(m_spilledRows),
+                                     Py_ssize_t(m_width)));
+    if (!shape) return 0;
+
+    PyObject *numpy = PyImport_ImportModule("numpy");
+    if (!numpy) {
+        Py_DECREF(shape);
+        return 0;
+    }
+
+    // Copy-on-write, so that the result is writable like an ordinary
+    // collected array without writing back to the file
+    PyObject *args = Py_BuildValue("(O)", m_spillFile);
+    PyObject *kwargs = Py_BuildValue("{s:s,s:s,s:N}",
+                                     "dtype", "float32",
+                                     "mode", "c",
+                                     "shape", shape);
+    PyObject *memmap = PyObject_GetAttrString(numpy, "memmap");
+
+    PyObject *mapped = 0;
+    if (args && kwargs && memmap) {
+        mapped = PyObject_Call(memmap, args, kwargs);
+    }
+
+    // Return a plain ndarray view of the memmap, which keeps the
+    // mapping alive as its base. Unlike the numpy.memmap subclass, a
+    // plain array can be pickled with its data out-of-band
+    PyObject *arr = 0;
+    if (mapped) {
+        arr = PyArray_View((PyArrayObject *)mapped, 0, &PyArray_Type);
+        Py_DECREF(mapped);
+    }
+
+    Py_XDECREF(memmap);
+    Py_XDECREF(kwargs);
+    Py_XDECREF(args);
+    Py_DECREF(numpy);
+    return arr;
+}
+
+PyObject *
+FeatureCollector::takeValues()
+{
+    if (m_sparse) {
+        return takeSparse();
+    }
+
+    if (m_spilledRows > 0 || m_spillFailed) {
+        return mapSpilled();
+    }
+
+    if (m_out) {
+        return PySequence_GetSlice(m_out, 0, m_count);
+    }
+
+    size_t rows = (m_width > 0 ? m_values->size() / m_width : 0);
+
+    npy_intp dims[2];
+    dims[0] = rows;
+    dims[1] = m_width;
+    int ndim = (m_width == 1 ? 1 : 2);
+
+    if (rows == 0) {
+        return PyArray_SimpleNew(ndim, dims, NPY_FLOAT);
+    }
+
+    // Hand our storage over to the array rather than copying it
+    PyObject *capsule = PyCapsule_New(m_values, valuesCapsuleName, deleteValues);
+    if (!capsule) return 0;
+
+    vector<float> *values = m_values;
+    m_values = new vector<float>;
+
+    PyObject *arr = PyArray_SimpleNewFromData(ndim, dims, NPY_FLOAT, &(*values)[0]);
+    if (!arr) {
+        Py_DECREF(capsule);
+        return 0;
+    }
+
+    if (PyArray_SetBaseObject((PyArrayObject *)arr, capsule) < 0) {
+        Py_DECREF(arr);
+        return 0;
+    }
+
+    return arr;
+}
@@ -0,0 +1,213 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  FeatureCollector: Accumulate the features returned through a
+  single plugin output into the structure vamp.collect returns for
+  that output, i.e. a vector or matrix of values for dense outputs or
+  a list of features otherwise.
+*/
+
+#ifndef VAMPYHOST_FEATURE_COLLECTOR_H
+#define VAMPYHOST_FEATURE_COLLECTOR_H
+
+#include <Python.h>
+#include <vamp-hostsdk/Plugin.h>
+
+#include "FeatureTransform.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+class FeatureCollector
+{
+public:
+    enum Shape { VectorShape, MatrixShape, ListShape };
+
+    FeatureCollector(const Vamp::Plugin::OutputDescriptor &desc);
+    ~FeatureCollector();
+
+    /**
+     * Return the result shape appropriate to the given output. This
+     * follows the same rules as vamp.collect.deduce_shape().
+     */
+    static Shape deduceShape(const Vamp::Plugin::OutputDescriptor &desc);
+
+    Shape getShape() const { return m_shape; }
+
+    /**
+     * Set the transform pipeline to be applied to each row of values
+     * as it is collected. Only vector and matrix shapes can be
+     * transformed. Return false and set a Python exception if this
+     * collector cannot take transforms.
+     */
+    bool setTransforms(const FeatureTransform &transforms);
+
+    /**
+     * Bound the memory used to hold collected values to roughly
+     * memoryLimit bytes, by writing them out to the given file
+     * whenever that much has accumulated. The file may be any Python
+     * object with a fileno() method, open for reading and writing and
+     * positioned at its start. If any values were written out, the
+     * array returned by takeValues() is mapped from the file (as a
+     * view of a copy-on-write numpy.memmap). Has no effect for the
+     * list shape. Return false and set a Python exception if the file
+     * has no usable descriptor. Call this after setTransforms, as the
+     * buffer is sized in rows.
+     */
+    bool setSpillFile(size_t memoryLimit, PyObject *file);
+
+    /**
+     * Collect values in compressed sparse row (CSR) form, keeping
+     * only those that are non-zero, rather than as a dense array.
+     * Only takes effect for outputs with more than one value per
+     * feature (after any transforms, so call this after
+     * setTransforms). Cannot be combined with a spill file. Return
+     * false and set a Python exception if a spill file has been set.
+     */
+    bool setSparse(bool sparse);
+
+    bool isSparse() const { return m_sparse; }
+
+    /**
+     * Write collected values straight into the caller's array out
+     * (if not null or None), rather than into storage of our own, and
+     * the timestamp in seconds of each feature into outTimes (if not
+     * null or None). The out array must be a writeable C-contiguous
+     * float32 array with the dimensions takeValues() would return
+     * (after any transforms, so call this after setTransforms) and
+     * at least as many rows as there will be features; outTimes must
+     * be a writeable contiguous one-dimensional float64 array with at
+     * least as many elements. Only for the vector and matrix shapes,
+     * and cannot be combined with a spill file or sparse collection.
+     * Return false and set a Python exception if the arrays are
+     * unsuitable.
+     */
+    bool setOutputArrays(PyObject *out, PyObject *outTimes);
+
+    /**
+     * Return the number of values stored per feature, after any
+     * transforms. This is 0 for the list shape.
+     */
+    size_t getWidth() const { return m_width; }
+
+    /**
+     * Add a list of features returned from the process call for the
+     * block with the given timestamp. For the vector and matrix
+     * shapes, only the values are kept (and their timestamps, if an
+     * outTimes array has been set, timed as vamp.collect would time
+     * them). Does not touch any Python objects, so may be called
+     * without the GIL.
+     */
+    void add(const Vamp::Plugin::FeatureList &features,
+             const Vamp::RealTime &blockTimestamp);
+
+    /**
+     * Return true if a feature has been received whose values do not
+     * match the output's bin count.
+     */
+    bool hasError() const { return !m_error.empty(); }
+    std::string getError() const { return m_error; }
+
+    /**
+     * Return true if the error was a failure to write to the spill
+     * file, rather than a problem with the features themselves.
+     */
+    bool hasSpillError() const { return m_spillFailed; }
+
+    size_t getFeatureCount() const { return m_count; }
+
+    /**
+     * Return the collected values for the vector or matrix shape as
+     * a new float32 NumPy array, one-dimensional if there is one
+     * value per feature and two-dimensional otherwise. The array
+     * takes over the collector's storage, leaving it empty. If values
+     * have been spilled to a file, the array is mapped from the file
+     * instead. If collecting sparse values, return instead a tuple
+     * of CSR data (float32), column indices (int32) and row pointer
+     * (int32) arrays, and a (rows, columns) shape tuple, in the form
+     * scipy.sparse.csr_matrix accepts without copying. If an out
+     * array has been set, return a view of its first rows, those
+     * that were written.
+     */
+    PyObject *takeValues();
+
+    /**
+     * Return the collected features for the list shape.
+     */
+    const Vamp::Plugin::FeatureList &getFeatures() const { return m_features; }
+
+private:
+    Shape m_shape;
+    size_t m_bins;
+    size_t m_width;
+    size_t m_count;
+    FeatureTransform m_transforms;
+    std::vector<float> *m_values;
+    Vamp::Plugin::FeatureList m_features;
+    std::string m_error;
+    PyObject *m_spillFile;
+    int m_spillFd;
+    size_t m_spillThreshold; // in values
+    size_t m_spilledRows;
+    bool m_spillFailed;
+    bool m_sparse;
+    std::vector<float> *m_sparseData;
+    std::vector<int32_t> *m_sparseIndices;
+    std::vector<int32_t> *m_sparseIndptr;
+    std::vector<float> m_row;
+    Vamp::Plugin::OutputDescriptor::SampleType m_sampleType;
+    float m_sampleRate;
+    double m_lastTime;
+    PyObject *m_out;
+    PyObject *m_outTimes;
+    float *m_outData;
+    double *m_outTimesData;
+    size_t m_outRows;
+    size_t m_outTimesRows;
+
+    void spill();
+    PyObject *mapSpilled();
+    void addSparse(const float *row);
+    PyObject *takeSparse();
+
+    FeatureCollector(const FeatureCollector &); // not provided
+    FeatureCollector &operator=(const FeatureCollector &); // not provided
+};
+
+#endif
@@ -0,0 +1,329 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "FeatureTransform.h"
+#include "FloatConversion.h"
+#include "StringConversion.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAMPYHOST_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+static const float defaultFloor = 1e-10f;
+
+// Clipping, scaling, differencing and the L2 sum of squares work four
+// values at a time where SSE2 is available, with a scalar loop for
+// the tail. The log and dB stages are scalar throughout
+
+static void
+clip(float *v, size_t n, float lo, float hi)
+{
+    size_t i = 0;
+#ifdef VAMPYHOST_SSE2
+    // With lo and hi as the first operands, a NaN passes through
+    // unchanged, as in the scalar loop
+    const __m128 vlo = _mm_set1_ps(lo), vhi = _mm_set1_ps(hi);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_max_ps(vlo, _mm_loadu_ps(v + i));
+        _mm_storeu_ps(v + i, _mm_min_ps(vhi, x));
+    }
+#endif
+    for (; i < n; ++i) {
+        float x = v[i];
+        x = (x < lo ? lo : x);
+        v[i] = (x > hi ? hi : x);
+    }
+}
+
+static void
+scale(float *v, size_t n, float factor)
+{
+    size_t i = 0;
+#ifdef VAMPYHOST_SSE2
+    const __m128 f = _mm_set1_ps(factor);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), f));
+    }
+#endif
+    for (; i < n; ++i) {
+        v[i] *= factor;
+    }
+}
+
+static void
+difference(const float *a, const float *b, size_t n, float *out)
+{
+    size_t i = 0;
+#ifdef VAMPYHOST_SSE2
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_sub_ps(_mm_loadu_ps(a + i),
+                                          _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+static float
+sumOfSquares(const float *v, size_t n)
+{
+    float sum = 0.f;
+    size_t i = 0;
+#ifdef VAMPYHOST_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(v + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(x, x));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) {
+        sum += v[i] * v[i];
+    }
+    return sum;
+}
+
+FeatureTransform::FeatureTransform()
+{
+}
+
+FeatureTransform::~FeatureTransform()
+{
+}
+
+bool
+FeatureTransform::parse(PyObject *list)
+{
+    m_stages.clear();
+
+    if (!list || list == Py_None) return true;
+
+    if (!PyList_Check(list) && !PyTuple_Check(list)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Transforms must be given as a list");
+        return false;
+    }
+
+    PyObject *seq = PySequence_Fast(list, "Transforms must be given as a list");
+    if (!seq) return false;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+
+    for (Py_ssize_t i = 0; i < n; ++i) {
+
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        PyObject *pyName = item;
+        vector<float> args;
+
+        if (PyTuple_Check(item)) {
+            if (PyTuple_GET_SIZE(item) == 0) {
+                pyName = 0;
+            } else {
+                pyName = PyTuple_GET_ITEM(item, 0);
+                for (Py_ssize_t j = 1; j < PyTuple_GET_SIZE(item); ++j) {
+                    PyObject *arg = PyTuple_GET_ITEM(item, j);
+                    if (!FloatConversion::check(arg)) {
+                        PyErr_SetString(PyExc_TypeError,
+                                        "Transform arguments must be numbers");
+                        Py_DECREF(seq);
+                        return false;
+                    }
+                    args.push_back(FloatConversion::convert(arg));
+                }
+            }
+        }
+
+#if PY_MAJOR_VERSION >= 3
+        if (!pyName || !PyUnicode_Check(pyName)) {
+#else
+        if (!pyName || !PyString_Check(pyName)) {
+#endif
+            PyErr_SetString(PyExc_TypeError,
+                            "Each transform must be a name or a tuple of name and arguments");
+            Py_DECREF(seq);
+            return false;
+        }
+
+        string name = StringConversion().py2string(pyName);
+
+        Stage stage;
+        stage.a = 0.f;
+        stage.b = 0.f;
+        stage.primed = false;
+
+        size_t maxArgs = 0, minArgs = 0;
+
+        if (name == "log" || name == "db") {
+            stage.type = (name == "log" ? Log : Decibels);
+            stage.a = (args.empty() ? defaultFloor : args[0]);
+            maxArgs = 1;
+        } else if (name == "clip") {
+            stage.type = Clip;
+            minArgs = maxArgs = 2;
+            if (args.size() == 2) {
+                stage.a = args[0];
+                stage.b = args[1];
+            }
+        } else if (name == "l2") {
+            stage.type = L2Normalise;
+        } else if (name == "delta") {
+            stage.type = Delta;
+        } else if (name == "delta2") {
+            stage.type = DeltaDelta;
+        } else {
+            PyErr_SetString(PyExc_ValueError,
+                            (string("Unknown transform \"") + name +
+                             "\": expected one of log, db, clip, l2, delta, delta2").c_str());
+            Py_DECREF(seq);
+            return false;
+        }
+
+        if (args.size() < minArgs || args.size() > maxArgs) {
+            PyErr_SetString(PyExc_ValueError,
+                            (string("Wrong number of arguments for transform \"") +
+                             name + "\"").c_str());
+            Py_DECREF(seq);
+            return false;
+        }
+
+        if (stage.type == Clip && stage.a > stage.b) {
+            PyErr_SetString(PyExc_ValueError,
+                            "Clip transform minimum must not exceed maximum");
+            Py_DECREF(seq);
+            return false;
+        }
+
+        m_stages.push_back(stage);
+    }
+
+    Py_DECREF(seq);
+    return true;
+}
+
+size_t
+FeatureTransform::getOutputWidth(size_t width) const
+{
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        if (m_stages[i].type == Delta) width *= 2;
+        else if (m_stages[i].type == DeltaDelta) width *= 3;
+    }
+    return width;
+}
+
+void
+FeatureTransform::apply(const float *in, size_t n, float *out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = in[i];
+    }
+
+    for (size_t s = 0; s < m_stages.size(); ++s) {
+
+        Stage &stage = m_stages[s];
+
+        switch (stage.type) {
+
+        case Log:
+        {
+            const float minimum = stage.a;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = logf(out[i] > minimum ? out[i] : minimum);
+            }
+            break;
+        }
+
+        case Decibels:
+        {
+            const float minimum = stage.a;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = 10.f * log10f(out[i] > minimum ? out[i] : minimum);
+            }
+            break;
+        }
+
+        case Clip:
+        {
+            clip(out, n, stage.a, stage.b);
+            break;
+        }
+
+        case L2Normalise:
+        {
+            float sum = sumOfSquares(out, n);
+            if (sum > 0.f) {
+                scale(out, n, 1.f / sqrtf(sum));
+            }
+            break;
+        }
+
+        case Delta:
+        case DeltaDelta:
+        {
+            if (!stage.primed || stage.previous.size() != n) {
+                stage.previous.assign(out, out + n);
+                stage.previousDelta.assign(n, 0.f);
+                stage.primed = true;
+            }
+            float *delta = out + n;
+            difference(out, &stage.previous[0], n, delta);
+            if (stage.type == DeltaDelta) {
+                difference(delta, &stage.previousDelta[0], n, out + 2 * n);
+                stage.previousDelta.assign(delta, delta + n);
+            }
+            stage.previous.assign(out, out + n);
+            n *= (stage.type == Delta ? 2 : 3);
+            break;
+        }
+        }
+    }
+}
+
+void
+FeatureTransform::reset()
+{
+    for (size_t s = 0; s < m_stages.size(); ++s) {
+        m_stages[s].primed = false;
+    }
+}
@@ -0,0 +1,108 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  FeatureTransform: A small pipeline of built-in transforms (log and
+  dB scaling, clipping, L2 normalisation, delta features) applied to
+  each feature row as it is collected.
+*/
+
+#ifndef VAMPYHOST_FEATURE_TRANSFORM_H
+#define VAMPYHOST_FEATURE_TRANSFORM_H
+
+#include <Python.h>
+
+#include <vector>
+#include <string>
+
+class FeatureTransform
+{
+public:
+    FeatureTransform();
+    ~FeatureTransform();
+
+    /**
+     * Set up the pipeline from a Python list, each element of which
+     * is either a transform name or a tuple of name followed by
+     * numeric arguments:
+     *
+     *  "log" or ("log", floor)         natural log of max(x, floor)
+     *  "db" or ("db", floor)           10 log10 of max(x, floor)
+     *  ("clip", min, max)              clamp to [min, max]
+     *  "l2"                            normalise row to unit L2 norm
+     *  "delta"                         append first difference
+     *  "delta2"                        append first and second difference
+     *
+     * Return false and set a Python exception if the list is not
+     * valid.
+     */
+    bool parse(PyObject *list);
+
+    bool empty() const { return m_stages.empty(); }
+
+    /**
+     * Return the number of values per row produced by the pipeline
+     * from an input row of the given width.
+     */
+    size_t getOutputWidth(size_t inputWidth) const;
+
+    /**
+     * Run the pipeline over one row of input values, writing
+     * getOutputWidth(n) values to out. Delta stages difference
+     * against the previous row passed to this function; the first
+     * row after a reset() has zero deltas.
+     */
+    void apply(const float *in, size_t n, float *out);
+
+    void reset();
+
+private:
+    enum Type { Log, Decibels, Clip, L2Normalise, Delta, DeltaDelta };
+
+    struct Stage {
+        Type type;
+        float a;
+        float b;
+        std::vector<float> previous; // for deltas: last input row
+        std::vector<float> previousDelta; // for delta2: last delta row
+        bool primed;
+    };
+
+    std::vector<Stage> m_stages;
+};
+
+#endif
@@ -0,0 +1,575 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "FeatureWriter.h"
+
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const size_t bufferSize = 65536;
+
+bool
+FeatureWriter::formatFromName(string name, Format &format)
+{
+    if (name == "csv") format = CSV;
+    else if (name == "jsonl") format = JSONLines;
+    else return false;
+    return true;
+}
+
+FeatureWriter::FeatureWriter(int fd, Format format) :
+    m_fd(fd),
+    m_format(format),
+    m_sourceWritten(false),
+    m_written(0),
+    m_failed(false)
+{
+    m_buffer.reserve(bufferSize);
+}
+
+void
+FeatureWriter::setSource(string source)
+{
+    m_source = source;
+    m_sourceWritten = false;
+}
+
+// Powers of ten from 1e-64 to 1e64. Those beyond 1e22 are not exact
+// in a double, but formatFloat checks what it produces by reading it
+// back, so they need only be close
+static double
+powerOfTen(int e)
+{
+    static struct Table {
+        double v[129];
+        Table() {
+            v[64] = 1.0;
+            for (int i = 1; i <= 64; ++i) {
+                v[64 + i] = v[64 + i - 1] * 10.0;
+                v[64 - i] = 1.0 / v[64 + i];
+            }
+        }
+    } table;
+    return table.v[e + 64];
+}
+
+static int
+putDigits(unsigned long long v, char *out)
+{
+    char tmp[24];
+    int n = 0;
+    do {
+        tmp[n++] = char('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    for (int i = 0; i < n; ++i) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+int
+FeatureWriter::formatFloat(float value, char *out)
+{
+    if (value != value) {
+        memcpy(out, "nan", 3);
+        return 3;
+    }
+
+    int n = 0;
+    if (value < 0.f) {
+        out[n++] = '-';
+        value = -value;
+    }
+    if (value == 0.f) {
+        out[n++] = '0';
+        return n;
+    }
+    if (value > 3.4028235e38f) {
+        memcpy(out + n, "inf", 3);
+        return n + 3;
+    }
+
+    // Decimal exponent of the leading digit
+    double d = value;
+    int bexp;
+    frexp(d, &bexp);
+    int e = int(floor((bexp - 1) * 0.30102999566398120));
+    while (e > -64 && powerOfTen(e) > d) --e;
+    while (e < 63 && powerOfTen(e + 1) <= d) ++e;
+
+    // Find the fewest significant digits that read back as the same
+    // float. Nine are always enough
+    unsigned long long digits = 0;
+    int precision = 1;
+    for (; precision <= 9; ++precision) {
+        int k = precision - 1 - e;
+        double scaled = (k >= 0 ? d * powerOfTen(k) : d / powerOfTen(-k));
+        digits = (unsigned long long)(scaled + 0.5);
+        double back = (k >= 0 ? digits / powerOfTen(k) : digits * powerOfTen(-k));
+        if (float(back) == value) break;
+    }
+    if (precision > 9) precision = 9;
+
+    // Rounding may have carried into a new leading digit
+    if (digits >= (unsigned long long)powerOfTen(precision)) {
+        digits /= 10;
+        ++e;
+    }
+
+    char ds[24];
+    int nd = putDigits(digits, ds);
+    while (nd > 1 && ds[nd - 1] == '0') --nd;
+
+    if (e < -5 || e >= 16) {
+        out[n++] = ds[0];
+        if (nd > 1) {
+            out[n++] = '.';
+            memcpy(out + n, ds + 1, nd - 1);
+            n += nd - 1;
+        }
+        out[n++] = 'e';
+        out[n++] = (e < 0 ? '-' : '+');
+        int ae = (e < 0 ? -e : e);
+        if (ae < 10) out[n++] = '0';
+        n += putDigits(ae, out + n);
+    } else if (e < 0) {
+        out[n++] = '0';
+        out[n++] = '.';
+        for (int i = -1; i > e; --i) out[n++] = '0';
+        memcpy(out + n, ds, nd);
+        n += nd;
+    } else {
+        for (int i = 0; i <= e; ++i) {
+            out[n++] = (i < nd ? ds[i] : '0');
+        }
+        if (nd > e + 1) {
+            out[n++] = '.';
+            memcpy(out + n, ds + e + 1, nd - e - 1);
+            n += nd - e - 1;
+        }
+    }
+    return n;
+}
+
+int
+FeatureWriter::formatTime(double seconds, char *out)
+{
+    int n = 0;
+    double ns = floor(seconds * 1e9 + 0.5);
+    if (ns < 0) {
+        out[n++] = '-';
+        ns = -ns;
+    }
+    unsigned long long total = (unsigned long long)ns;
+    n += putDigits(total / 1000000000ULL, out + n);
+    out[n++] = '.';
+    unsigned long long frac = total % 1000000000ULL;
+    for (int i = 8; i >= 0; --i) {
+        out[n + i] = char('0' + frac % 10);
+        frac /= 10;
+    }
+    return n + 9;
+}
+
+static bool
+writeAll(int fd, const char *data, size_t bytes)
+{
+    while (bytes > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, unsigned(min(bytes, size_t(1) << 30)));
+#else
+        ssize_t n = write(fd, data, bytes);
+#endif
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+void
+FeatureWriter::drain()
+{
+    if (m_buffer.empty()) return;
+    if (!m_failed) {
+        if (writeAll(m_fd, &m_buffer[0], m_buffer.size())) {
+            m_written += m_buffer.size();
+        } else {
+            m_error = string("Failed to write features: ") + strerror(errno);
+            m_failed = true;
+        }
+    }
+    m_buffer.clear();
+}
+
+bool
+FeatureWriter::flush()
+{
+    drain();
+    return !m_failed;
+}
+
+void
+FeatureWriter::put(const char *data, size_t bytes)
+{
+    while (bytes > 0) {
+        if (m_buffer.size() == m_buffer.capacity()) drain();
+        size_t n = min(bytes, m_buffer.capacity() - m_buffer.size());
+        m_buffer.insert(m_buffer.end(), data, data + n);
+        data += n;
+        bytes -= n;
+    }
+}
+
+void
+FeatureWriter::putFloat(float value)
+{
+    if (m_format == JSONLines && !(fabsf(value) <= 3.4028235e38f)) {
+        put("null", 4); // JSON has no NaN or infinity
+        return;
+    }
+    char tmp[24];
+    put(tmp, formatFloat(value, tmp));
+}
+
+void
+FeatureWriter::putTime(double seconds)
+{
+    char tmp[32];
+    put(tmp, formatTime(seconds, tmp));
+}
+
+void
+FeatureWriter::putQuoted(const string &s)
+{
+    put('"');
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '"') put('"');
+        put(s[i]);
+    }
+    put('"');
+}
+
+void
+FeatureWriter::putJsonString(const string &s)
+{
+    static const char *hex = "0123456789abcdef";
+    put('"');
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(char(c));
+        } else if (c < 0x20) {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            put(esc, 6);
+        } else {
+            put(char(c));
+        }
+    }
+    put('"');
+}
+
+void
+FeatureWriter::writeFeature(const double *timestamp, const double *duration,
+                            const float *values, size_t count,
+                            const string *label)
+{
+    bool haveLabel = (label && !label->empty());
+
+    if (m_format == CSV) {
+        if (m_source != "") {
+            if (!m_sourceWritten) {
+                putQuoted(m_source);
+                m_sourceWritten = true;
+            }
+            put(',');
+        }
+        if (timestamp) putTime(*timestamp);
+        if (duration) {
+            put(',');
+            putTime(*duration);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            put(',');
+            putFloat(values[i]);
+        }
+        if (haveLabel) {
+            put(',');
+            putQuoted(*label);
+        }
+        put('\n');
+        return;
+    }
+
+    put('{');
+    bool first = true;
+    if (timestamp) {
+        put("\"timestamp\":", 12);
+        putTime(*timestamp);
+        first = false;
+    }
+    if (duration) {
+        if (!first) put(',');
+        put("\"duration\":", 11);
+        putTime(*duration);
+        first = false;
+    }
+    if (count > 0) {
+        if (!first) put(',');
+        put("\"values\":[", 10);
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) put(',');
+            putFloat(values[i]);
+        }
+        put(']');
+        first = false;
+    }
+    if (haveLabel) {
+        if (!first) put(',');
+        put("\"label\":", 8);
+        putJsonString(*label);
+    }
+    put("}\n", 2);
+}
+
+void
+FeatureWriter::writeRows(const double *times, const float *values,
+                         size_t rows, size_t columns)
+{
+    for (size_t i = 0; i < rows && !m_failed; ++i) {
+        writeFeature(times + i, 0, values + i * columns, columns, 0);
+    }
+}
+
+string
+FeatureWriter::npyHeader(const Array &array)
+{
+    const unsigned one = 1;
+    bool little = (*(const char *)&one == 1);
+
+    string dict = "{'descr': '";
+    dict += (array.itemSize == 1 ? '|' : little ? '<' : '>');
+    dict += array.kind;
+    char tmp[24];
+    dict += string(tmp, putDigits(array.itemSize, tmp));
+    dict += "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < array.shape.size(); ++i) {
+        dict += string(tmp, putDigits(array.shape[i], tmp));
+        if (i + 1 < array.shape.size() || array.shape.size() == 1) {
+            dict += ", ";
+        }
+    }
+    dict += "), }";
+
+    // Pad with spaces and a newline so that the data is 64-byte
+    // aligned, as numpy does
+    size_t total = 10 + dict.size() + 1;
+    dict += string((64 - total % 64) % 64, ' ');
+    dict += '\n';
+
+    string header = "\x93NUMPY";
+    header += char(1);
+    header += char(0);
+    header += char(dict.size() & 0xff);
+    header += char(dict.size() >> 8);
+    return header + dict;
+}
+
+static size_t
+dataBytes(const FeatureWriter::Array &array)
+{
+    size_t bytes = array.itemSize;
+    for (size_t i = 0; i < array.shape.size(); ++i) {
+        bytes *= array.shape[i];
+    }
+    return bytes;
+}
+
+void
+FeatureWriter::writeNpy(const Array &array)
+{
+    putString(npyHeader(array));
+    put((const char *)array.data, dataBytes(array));
+}
+
+static unsigned long
+crc32(unsigned long crc, const unsigned char *data, size_t bytes)
+{
+    static struct Table {
+        unsigned long v[256];
+        Table() {
+            for (unsigned long i = 0; i < 256; ++i) {
+                unsigned long c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : (c >> 1);
+                }
+                v[i] = c;
+            }
+        }
+    } table;
+    crc = crc ^ 0xffffffffUL;
+    for (size_t i = 0; i < bytes; ++i) {
+        crc = table.v[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffUL;
+}
+
+void
+FeatureWriter::putU16(unsigned v)
+{
+    char b[2] = { char(v & 0xff), char((v >> 8) & 0xff) };
+    put(b, 2);
+}
+
+void
+FeatureWriter::putU32(unsigned long v)
+{
+    char b[4] = { char(v & 0xff), char((v >> 8) & 0xff),
+                  char((v >> 16) & 0xff), char((v >> 24) & 0xff) };
+    put(b, 4);
+}
+
+void
+FeatureWriter::writeNpz(const vector<Array> &arrays)
+{
+    // A stored (uncompressed) zip archive, as numpy.savez writes. The
+    // sizes and checksum of each member go in its header, so they
+    // are worked out before it is written
+    const unsigned long long limit = 0xffffffffULL;
+    const unsigned dosDate = (1 << 5) | 1; // 1980-01-01
+
+    struct Member {
+        string name;
+        string header;
+        size_t bytes;
+        unsigned long crc;
+        unsigned long size;
+        unsigned long offset;
+    };
+    vector<Member> members;
+
+    unsigned long long offset = 0;
+
+    for (size_t i = 0; i < arrays.size(); ++i) {
+        Member m;
+        m.name = arrays[i].name + ".npy";
+        m.header = npyHeader(arrays[i]);
+        m.bytes = dataBytes(arrays[i]);
+        unsigned long long size = m.header.size() + (unsigned long long)m.bytes;
+        m.size = (unsigned long)size;
+        m.offset = (unsigned long)offset;
+        offset += 30 + m.name.size() + size;
+        members.push_back(m);
+    }
+
+    unsigned long long directoryStart = offset;
+
+    for (size_t i = 0; i < members.size(); ++i) {
+        offset += 46 + members[i].name.size();
+    }
+
+    if (offset + 22 > limit) {
+        if (!m_failed) {
+            m_error = "Arrays are too large for an NPZ archive without ZIP64 extensions";
+            m_failed = true;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < members.size(); ++i) {
+        Member &m = members[i];
+        m.crc = crc32(0, (const unsigned char *)m.header.data(), m.header.size());
+        m.crc = crc32(m.crc, (const unsigned char *)arrays[i].data, m.bytes);
+
+        putU32(0x04034b50UL);
+        putU16(20);             // version needed to extract
+        putU16(0);              // flags
+        putU16(0);              // method: stored
+        putU16(0);              // time
+        putU16(dosDate);
+        putU32(m.crc);
+        putU32(m.size);         // compressed
+        putU32(m.size);         // uncompressed
+        putU16((unsigned)m.name.size());
+        putU16(0);              // extra field length
+        putString(m.name);
+        putString(m.header);
+        put((const char *)arrays[i].data, m.bytes);
+    }
+
+    for (size_t i = 0; i < members.size(); ++i) {
+        const Member &m = members[i];
+        putU32(0x02014b50UL);
+        putU16(20);             // version made by
+        putU16(20);             // version needed to extract
+        putU16(0);              // flags
+        putU16(0);              // method
+        putU16(0);              // time
+        putU16(dosDate);
+        putU32(m.crc);
+        putU32(m.size);
+        putU32(m.size);
+        putU16((unsigned)m.name.size());
+        putU16(0);              // extra field length
+        putU16(0);              // comment length
+        putU16(0);              // disk number
+        putU16(0);              // internal attributes
+        putU32(0);              // external attributes
+        putU32(m.offset);
+        putString(m.name);
+    }
+
+    putU32(0x06054b50UL);
+    putU16(0);                  // disk number
+    putU16(0);                  // disk with directory
+    putU16((unsigned)members.size());
+    putU16((unsigned)members.size());
+    putU32((unsigned long)(offset - directoryStart));
+    putU32((unsigned long)directoryStart);
+    putU16(0);                  // comment length
+}
@@ -0,0 +1,168 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  FeatureWriter: Write features to a file descriptor as CSV (in the
+  column layout used by Sonic Annotator), JSON Lines, or NumPy
+  NPY/NPZ, formatting numbers without going through printf or
+  Python.
+*/
+
+#ifndef VAMPYHOST_FEATURE_WRITER_H
+#define VAMPYHOST_FEATURE_WRITER_H
+
+#include <vector>
+#include <string>
+
+class FeatureWriter
+{
+public:
+    enum Format { CSV, JSONLines };
+
+    /**
+     * Look up a text format by name ("csv" or "jsonl"). Return false
+     * if the name is not recognised.
+     */
+    static bool formatFromName(std::string name, Format &format);
+
+    /**
+     * Construct a writer that writes text rows in the given format to
+     * fd, which it does not close. Output is buffered, and written
+     * whenever the buffer fills and on flush(). Does not use Python,
+     * and may be used without the GIL.
+     */
+    FeatureWriter(int fd, Format format);
+
+    /**
+     * Set the source (e.g. audio file name) to be written in the
+     * first column of CSV output. As in Sonic Annotator, it appears
+     * quoted on the first row and is left empty on the rows after;
+     * with no source the column is omitted.
+     */
+    void setSource(std::string source);
+
+    /**
+     * Write one feature as a row. The timestamp and duration (in
+     * seconds) are optional and omitted if null; so is the label if
+     * null or empty.
+     */
+    void writeFeature(const double *timestamp, const double *duration,
+                      const float *values, size_t count,
+                      const std::string *label);
+
+    /**
+     * Write a row for each row of a row-major matrix of rows x
+     * columns values, with the corresponding timestamp from times.
+     */
+    void writeRows(const double *times, const float *values,
+                   size_t rows, size_t columns);
+
+    struct Array {
+        std::string name;       // used for the NPZ member name
+        const void *data;       // C-contiguous, native byte order
+        char kind;              // NumPy type kind, e.g. 'f'
+        size_t itemSize;
+        std::vector<size_t> shape;
+    };
+
+    /**
+     * Write an array in NPY format.
+     */
+    void writeNpy(const Array &array);
+
+    /**
+     * Write arrays as an uncompressed NPZ archive with members named
+     * after them (plus ".npy"). The archive has no ZIP64 extensions,
+     * so it must come to less than 4GB.
+     */
+    void writeNpz(const std::vector<Array> &arrays);
+
+    /**
+     * Write out anything buffered. Return false if this or any
+     * earlier write failed; getError() then describes why.
+     */
+    bool flush();
+
+    bool failed() const { return m_failed; }
+    std::string getError() const { return m_error; }
+    unsigned long long getBytesWritten() const { return m_written; }
+
+    /**
+     * Format a float as the shortest decimal string that reads back
+     * as the same float, writing at most 24 characters (and no
+     * terminator) to out and returning the number written. NaN and
+     * infinities are written as "nan", "inf" and "-inf".
+     */
+    static int formatFloat(float value, char *out);
+
+    /**
+     * Format a time in seconds with nine decimal places, as Sonic
+     * Annotator does, writing at most 32 characters (and no
+     * terminator) to out and returning the number written.
+     */
+    static int formatTime(double seconds, char *out);
+
+private:
+    int m_fd;
+    Format m_format;
+    std::string m_source;
+    bool m_sourceWritten;
+    std::vector<char> m_buffer;
+    unsigned long long m_written;
+    bool m_failed;
+    std::string m_error;
+
+    void put(const char *data, size_t bytes);
+    void put(char c) {
+        if (m_buffer.size() == m_buffer.capacity()) drain();
+        m_buffer.push_back(c);
+    }
+    void putString(const std::string &s) { put(s.data(), s.size()); }
+    void putFloat(float value);
+    void putTime(double seconds);
+    void putQuoted(const std::string &s);
+    void putJsonString(const std::string &s);
+    void putU16(unsigned v);
+    void putU32(unsigned long v);
+    void drain();
+    static std::string npyHeader(const Array &array);
+
+    FeatureWriter(const FeatureWriter &); // not provided
+    FeatureWriter &operator=(const FeatureWriter &); // not provided
+};
+
+#endif
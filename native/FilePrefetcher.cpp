@@ -0,0 +1,473 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "FilePrefetcher.h"
+
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct FilePrefetcher::File
+{
+    File(string path) : fd(-1), size(0), charge(0), chunksLeft(0),
+                        ready(false) {
+        result.path = path;
+        result.channels = 0;
+        result.frames = 0;
+        result.sampleRate = 0.f;
+    }
+    Result result;
+    int fd;
+    size_t size;
+    size_t charge;              // counted against maxBytes until taken
+    vector<char> bytes;
+    size_t chunksLeft;
+    bool ready;
+};
+
+FilePrefetcher::FilePrefetcher(const vector<string> &paths, int threads,
+                               size_t maxBytes, size_t chunkSize) :
+    m_maxBytes(maxBytes),
+    m_chunkSize(max(chunkSize, size_t(4096))),
+    m_nextToOpen(0),
+    m_nextToTake(0),
+    m_bytesHeld(0),
+    m_opening(false),
+    m_stopping(false)
+{
+    for (size_t i = 0; i < paths.size(); ++i) {
+        m_files.push_back(new File(paths[i]));
+    }
+
+    if (threads <= 0) {
+        threads = int(thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        m_workers.push_back(thread(&FilePrefetcher::run, this));
+    }
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i].join();
+    }
+
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        if (!m_files[i]) continue;
+        if (m_files[i]->fd >= 0) {
+#ifdef _WIN32
+            _close(m_files[i]->fd);
+#else
+            ::close(m_files[i]->fd);
+#endif
+        }
+        delete m_files[i];
+    }
+}
+
+// Read length bytes at offset, without moving any shared file
+// position, so that several threads may read one file at once
+static bool
+readAt(int fd, char *data, size_t length, size_t offset)
+{
+    while (length > 0) {
+#ifdef _WIN32
+        OVERLAPPED ov;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset = DWORD(offset & 0xffffffffULL);
+        ov.OffsetHigh = DWORD((unsigned long long)offset >> 32);
+        DWORD n = 0;
+        if (!ReadFile((HANDLE)_get_osfhandle(fd), data,
+                      DWORD(min(length, size_t(1) << 30)), &n, &ov)) {
+            return false;
+        }
+#else
+        ssize_t n = pread(fd, data, length, off_t(offset));
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) {
+            if (n == 0) errno = EIO; // the file has shrunk
+            return false;
+        }
+        data += n;
+        length -= n;
+        offset += n;
+    }
+    return true;
+}
+
+static unsigned
+le16(const unsigned char *p)
+{
+    return p[0] | (unsigned(p[1]) << 8);
+}
+
+static unsigned long
+le32(const unsigned char *p)
+{
+    return p[0] | (unsigned long)(p[1]) << 8 |
+        (unsigned long)(p[2]) << 16 | (unsigned long)(p[3]) << 24;
+}
+
+// Return an upper bound on the size of the float samples a WAV file
+// of the given size decodes to, from the sample size in its header if
+// that can be found near the start, or else assuming 8-bit samples,
+// which grow the most
+static size_t
+decodedSizeBound(int fd, size_t size)
+{
+    unsigned char b[4096];
+    size_t n = min(size, sizeof(b));
+    unsigned bits = 8;
+
+    if (n >= 12 && readAt(fd, (char *)b, n, 0) &&
+        !memcmp(b, "RIFF", 4) && !memcmp(b + 8, "WAVE", 4)) {
+        size_t pos = 12;
+        while (pos + 8 <= n) {
+            size_t length = le32(b + pos + 4);
+            if (!memcmp(b + pos, "fmt ", 4)) {
+                if (pos + 24 <= n && le16(b + pos + 22) >= 8) {
+                    bits = le16(b + pos + 22);
+                }
+                break;
+            }
+            pos += 8 + length + (length & 1);
+        }
+    }
+
+    return (size / (bits / 8)) * sizeof(float);
+}
+
+void
+FilePrefetcher::open(File *file)
+{
+    const char *path = file->result.path.c_str();
+#ifdef _WIN32
+    int fd = _open(path, _O_RDONLY | _O_BINARY);
+#else
+    int fd = ::open(path, O_RDONLY);
+#endif
+    if (fd < 0) {
+        file->result.error = string("Failed to open \"") + path + "\": " +
+            strerror(errno);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        file->result.error = string("Failed to examine \"") + path + "\": " +
+            strerror(errno);
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        return;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    file->fd = fd;
+    file->size = size_t(st.st_size);
+
+    // While it is decoded, a file holds both its bytes and samples
+    file->charge = file->size + decodedSizeBound(fd, file->size);
+}
+
+void
+FilePrefetcher::finish(File *file)
+{
+    if (file->fd >= 0) {
+#ifdef _WIN32
+        _close(file->fd);
+#else
+        ::close(file->fd);
+#endif
+        file->fd = -1;
+    }
+    if (file->result.error.empty()) {
+        decodeWav(file->bytes, file->result);
+    }
+    vector<char>().swap(file->bytes);
+}
+
+void
+FilePrefetcher::settle(File *file)
+{
+    // Once decoded, a file holds only its samples until taken
+    m_bytesHeld -= file->charge;
+    file->charge = file->result.channels * file->result.frames * sizeof(float);
+    m_bytesHeld += file->charge;
+    m_work.notify_all();
+}
+
+void
+FilePrefetcher::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+
+        // Reading the chunks already queued comes first, then opening
+        // the next file, one at a time so that files are admitted in
+        // order: next() waits for them in that order, and a later
+        // file taking the space an earlier one needs would deadlock
+
+        if (!m_chunks.empty()) {
+
+            Chunk c = m_chunks.front();
+            m_chunks.pop_front();
+
+            lock.unlock();
+            string error;
+            if (!readAt(c.file->fd, &c.file->bytes[c.offset], c.length,
+                        c.offset)) {
+                error = string("Failed to read \"") + c.file->result.path +
+                    "\": " + strerror(errno);
+            }
+            lock.lock();
+
+            if (error != "" && c.file->result.error == "") {
+                c.file->result.error = error;
+            }
+            if (--c.file->chunksLeft == 0) {
+                lock.unlock();
+                finish(c.file);
+                lock.lock();
+                settle(c.file);
+                c.file->ready = true;
+                m_done.notify_all();
+            }
+            continue;
+        }
+
+        if (!m_opening && m_nextToOpen < m_files.size()) {
+
+            File *file = m_files[m_nextToOpen++];
+            m_opening = true;
+
+            lock.unlock();
+            open(file);
+            lock.lock();
+
+            if (file->fd < 0) {
+                m_opening = false;
+                file->ready = true;
+                m_done.notify_all();
+                m_work.notify_all();
+                continue;
+            }
+
+            while (!m_stopping && m_bytesHeld > 0 &&
+                   m_bytesHeld + file->charge > m_maxBytes) {
+                m_work.wait(lock);
+            }
+            m_opening = false;
+            if (m_stopping) break;
+
+            m_bytesHeld += file->charge;
+            file->bytes.resize(file->size);
+
+            for (size_t offset = 0; offset < file->size;
+                 offset += m_chunkSize) {
+                Chunk c;
+                c.file = file;
+                c.offset = offset;
+                c.length = min(m_chunkSize, file->size - offset);
+                m_chunks.push_back(c);
+                ++file->chunksLeft;
+            }
+
+            if (file->chunksLeft == 0) { // empty file
+                lock.unlock();
+                finish(file);
+                lock.lock();
+                settle(file);
+                file->ready = true;
+                m_done.notify_all();
+            }
+
+            m_work.notify_all();
+            continue;
+        }
+
+        m_work.wait(lock);
+    }
+}
+
+bool
+FilePrefetcher::next(Result &result)
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    if (m_nextToTake >= m_files.size()) return false;
+
+    File *file = m_files[m_nextToTake];
+    while (!file->ready) {
+        m_done.wait(lock);
+    }
+
+    result = std::move(file->result);
+    m_bytesHeld -= file->charge; // zero if it was never admitted
+    m_files[m_nextToTake] = 0;
+    ++m_nextToTake;
+
+    lock.unlock();
+    m_work.notify_all();
+
+    delete file;
+    return true;
+}
+
+void
+FilePrefetcher::decodeWav(const vector<char> &bytes, Result &result)
+{
+    size_t n = bytes.size();
+    const unsigned char *b = (const unsigned char *)(n ? &bytes[0] : 0);
+
+    if (n < 12 || memcmp(b, "RIFF", 4) || memcmp(b + 8, "WAVE", 4)) {
+        result.error = "\"" + result.path + "\" is not a WAV file";
+        return;
+    }
+
+    unsigned format = 0, channels = 0, bits = 0;
+    unsigned long rate = 0;
+    size_t dataStart = 0, dataSize = 0;
+    bool haveFormat = false, haveData = false;
+
+    size_t pos = 12;
+    while (pos + 8 <= n && !haveData) {
+        const unsigned char *id = b + pos;
+        size_t size = le32(b + pos + 4);
+        size_t body = pos + 8;
+        if (!memcmp(id, "fmt ", 4) && size >= 16 && body + 16 <= n) {
+            format = le16(b + body);
+            channels = le16(b + body + 2);
+            rate = le32(b + body + 4);
+            bits = le16(b + body + 14);
+            if (format == 0xfffe && size >= 26 && body + 26 <= n) {
+                format = le16(b + body + 24); // WAVE_FORMAT_EXTENSIBLE subformat
+            }
+            haveFormat = true;
+        } else if (!memcmp(id, "data", 4)) {
+            dataStart = body;
+            dataSize = min(size, n - body); // streamed files may overstate it
+            haveData = true;
+        }
+        if (size > n - body) break;
+        pos = body + size + (size & 1);
+    }
+
+    bool supported =
+        (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+        (format == 3 && (bits == 32 || bits == 64));
+
+    if (!haveFormat || !haveData || channels == 0 || rate == 0) {
+        result.error = "\"" + result.path + "\" is not a valid WAV file";
+        return;
+    }
+    if (!supported) {
+        result.error = "\"" + result.path +
+            "\" has a sample format that cannot be read";
+        return;
+    }
+
+    size_t bytesPerSample = bits / 8;
+    size_t frames = dataSize / (bytesPerSample * channels);
+
+    result.channels = channels;
+    result.frames = frames;
+    result.sampleRate = float(rate);
+    result.data.resize(channels * frames);
+
+    const unsigned char *p = b + dataStart;
+    for (size_t i = 0; i < frames; ++i) {
+        for (size_t c = 0; c < channels; ++c) {
+            float v;
+            if (format == 3) {
+                if (bits == 32) {
+                    uint32_t u = uint32_t(le32(p));
+                    memcpy(&v, &u, 4);
+                } else {
+                    uint64_t u = uint64_t(le32(p)) |
+                        (uint64_t(le32(p + 4)) << 32);
+                    double d;
+                    memcpy(&d, &u, 8);
+                    v = float(d);
+                }
+            } else if (bits == 8) {
+                v = (int(p[0]) - 128) / 128.f;
+            } else if (bits == 16) {
+                v = int16_t(le16(p)) / 32768.f;
+            } else if (bits == 24) {
+                int32_t s = int32_t(uint32_t(p[0]) << 8 | uint32_t(p[1]) << 16 |
+                                    uint32_t(p[2]) << 24) >> 8;
+                v = s / 8388608.f;
+            } else {
+                v = float(int32_t(uint32_t(le32(p))) / 2147483648.0);
+            }
+            result.data[c * frames + i] = v;
+            p += bytesPerSample;
+        }
+    }
+}
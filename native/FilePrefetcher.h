@@ -0,0 +1,140 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  FilePrefetcher: Read and decode many audio files concurrently
+  ahead of their use. The files are divided into chunks, which a
+  pool of worker threads read with positional reads, so that many
+  reads are in flight at once across several files; each file is
+  decoded by the worker that completes its last chunk, and files are
+  handed over in the order given. The data held by files read but
+  not yet taken is bounded, so reading runs only a limited distance
+  ahead of processing.
+
+  Only WAV files (integer PCM of 8 to 32 bits, or 32- or 64-bit
+  float) are decoded. None of this touches Python objects, so it
+  runs without the GIL.
+*/
+
+#ifndef VAMPYHOST_FILE_PREFETCHER_H
+#define VAMPYHOST_FILE_PREFETCHER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class FilePrefetcher
+{
+public:
+    struct Result {
+        std::string path;
+        std::vector<float> data; // channels x frames, one channel after another
+        size_t channels;
+        size_t frames;
+        float sampleRate;
+        std::string error;      // empty unless the file could not be read
+    };
+
+    /**
+     * Start reading the given files with the given number of worker
+     * threads (0 for one per hardware thread), in chunks of
+     * chunkSize bytes. A file is begun only if the memory held for
+     * files read or being read but not yet taken comes to no more
+     * than maxBytes with it, unless there are no such files. A file
+     * is charged its own size plus a bound on the size of its decoded
+     * samples while it is read and decoded, and then the size of its
+     * samples until taken.
+     */
+    FilePrefetcher(const std::vector<std::string> &paths, int threads,
+                   size_t maxBytes, size_t chunkSize);
+
+    /**
+     * Stop the workers, abandoning any files not yet taken. Reads in
+     * progress are completed first.
+     */
+    ~FilePrefetcher();
+
+    /**
+     * Wait for the next file in order and move it into result.
+     * Return false if all files have been taken.
+     */
+    bool next(Result &result);
+
+    size_t getThreadCount() const { return m_workers.size(); }
+
+    /**
+     * Decode a WAV file held in memory into result, setting its
+     * error field if it cannot be decoded.
+     */
+    static void decodeWav(const std::vector<char> &bytes, Result &result);
+
+private:
+    struct File;
+    struct Chunk {
+        File *file;
+        size_t offset;
+        size_t length;
+    };
+
+    std::vector<File *> m_files;
+    size_t m_maxBytes;
+    size_t m_chunkSize;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::condition_variable m_done;
+    std::deque<Chunk> m_chunks;
+    std::vector<std::thread> m_workers;
+    size_t m_nextToOpen;
+    size_t m_nextToTake;
+    size_t m_bytesHeld;
+    bool m_opening;
+    bool m_stopping;
+
+    void run();
+    void open(File *file);
+    void finish(File *file);
+    void settle(File *file);
+
+    FilePrefetcher(const FilePrefetcher &); // not provided
+    FilePrefetcher &operator=(const FilePrefetcher &); // not provided
+};
+
+#endif
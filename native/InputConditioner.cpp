@@ -0,0 +1,190 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "InputConditioner.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAMPYHOST_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+#define VAMPYHOST_AARCH64 1
+#endif
+
+static const unsigned int exponentMask = 0x7f800000u;
+static const unsigned int mantissaMask = 0x007fffffu;
+
+InputConditioner::InputConditioner(bool flushDenormals, bool scrub) :
+    m_flushDenormals(flushDenormals),
+    m_scrub(scrub),
+    m_blocks(0),
+    m_nonFinite(0),
+    m_denormals(0)
+{
+}
+
+// Scrub one sample, counting it if it is replaced
+static inline float
+scrubSample(float f, size_t &nonFinite, size_t &denormals)
+{
+    unsigned int bits;
+    memcpy(&bits, &f, sizeof(bits));
+    unsigned int exponent = bits & exponentMask;
+    if (exponent == exponentMask) {
+        ++nonFinite;
+        return 0.f;
+    }
+    if (exponent == 0 && (bits & mantissaMask) != 0) {
+        ++denormals;
+        return 0.f;
+    }
+    return f;
+}
+
+#ifdef VAMPYHOST_SSE2
+
+static inline int
+popcount4(int mask)
+{
+    return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+}
+
+// Scrub four samples, using integer comparisons on their bit patterns
+// so that the result does not depend on the floating-point mode
+static inline __m128
+scrubFour(__m128 v, size_t &nonFinite, size_t &denormals)
+{
+    const __m128i exponents = _mm_set1_epi32(int(exponentMask));
+    const __m128i mantissas = _mm_set1_epi32(int(mantissaMask));
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i bits = _mm_castps_si128(v);
+    __m128i exponent = _mm_and_si128(bits, exponents);
+    __m128i nf = _mm_cmpeq_epi32(exponent, exponents);
+    __m128i dn = _mm_andnot_si128
+        (_mm_cmpeq_epi32(_mm_and_si128(bits, mantissas), zero),
+         _mm_cmpeq_epi32(exponent, zero));
+    __m128i bad = _mm_or_si128(nf, dn);
+
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(bad));
+    if (mask == 0) return v;
+
+    nonFinite += popcount4(_mm_movemask_ps(_mm_castsi128_ps(nf)));
+    denormals += popcount4(_mm_movemask_ps(_mm_castsi128_ps(dn)));
+    return _mm_castsi128_ps(_mm_andnot_si128(bad, bits));
+}
+
+#endif
+
+void
+InputConditioner::convert(const float *src, float *dst, size_t n)
+{
+    if (!m_scrub) {
+        if (src != dst) memcpy(dst, src, n * sizeof(float));
+        return;
+    }
+
+    size_t i = 0;
+#ifdef VAMPYHOST_SSE2
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dst + i, scrubFour(_mm_loadu_ps(src + i),
+                                         m_nonFinite, m_denormals));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = scrubSample(src[i], m_nonFinite, m_denormals);
+    }
+}
+
+void
+InputConditioner::convert(const double *src, float *dst, size_t n)
+{
+    size_t i = 0;
+
+    if (!m_scrub) {
+        for (; i < n; ++i) dst[i] = float(src[i]);
+        return;
+    }
+
+    // A finite double may still become infinite or denormal as a
+    // float, so it is the converted value that is scrubbed
+#ifdef VAMPYHOST_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, scrubFour(_mm_movelh_ps(lo, hi),
+                                         m_nonFinite, m_denormals));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = scrubSample(float(src[i]), m_nonFinite, m_denormals);
+    }
+}
+
+InputConditioner::FloatModeGuard::FloatModeGuard(const InputConditioner *c) :
+    m_set(false),
+    m_saved(0)
+{
+    if (!c || !c->m_flushDenormals) return;
+#if defined(VAMPYHOST_SSE2)
+    unsigned int csr = _mm_getcsr();
+    m_saved = csr;
+    _mm_setcsr(csr | 0x8040); // FTZ and DAZ
+    m_set = true;
+#elif defined(VAMPYHOST_AARCH64)
+    unsigned long fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    m_saved = fpcr;
+    fpcr |= (1UL << 24); // FZ
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+    m_set = true;
+#endif
+}
+
+InputConditioner::FloatModeGuard::~FloatModeGuard()
+{
+    if (!m_set) return;
+#if defined(VAMPYHOST_SSE2)
+    _mm_setcsr((unsigned int)m_saved);
+#elif defined(VAMPYHOST_AARCH64)
+    unsigned long fpcr = m_saved;
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#endif
+}
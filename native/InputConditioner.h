@@ -0,0 +1,107 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  InputConditioner: Optional conditioning of the audio passed to a
+  plugin, for plugins that slow down badly on denormal input or
+  misbehave on NaNs. The processor may be switched into flush-to-zero
+  and denormals-are-zero mode while the plugin runs, and the input
+  may be scrubbed, replacing NaN, infinite and denormal samples with
+  zero as it is converted to float, in the same pass.
+*/
+
+#ifndef VAMPYHOST_INPUT_CONDITIONER_H
+#define VAMPYHOST_INPUT_CONDITIONER_H
+
+#include <cstddef>
+
+class InputConditioner
+{
+public:
+    /**
+     * Construct a conditioner that sets flush-to-zero mode while the
+     * plugin runs (if flushDenormals is true) and scrubs the input
+     * (if scrub is true). Does not use Python, and may be used
+     * without the GIL, though not from more than one thread at once.
+     */
+    InputConditioner(bool flushDenormals, bool scrub);
+
+    bool flushesDenormals() const { return m_flushDenormals; }
+    bool scrubs() const { return m_scrub; }
+
+    /**
+     * Convert n samples from src to dst, scrubbing them if scrubbing
+     * is enabled. The float version may be used in place (with src
+     * equal to dst).
+     */
+    void convert(const float *src, float *dst, size_t n);
+    void convert(const double *src, float *dst, size_t n);
+
+    /**
+     * Count a block passed to the plugin.
+     */
+    void addBlock() { ++m_blocks; }
+
+    size_t getBlockCount() const { return m_blocks; }
+    size_t getNonFiniteCount() const { return m_nonFinite; }
+    size_t getDenormalCount() const { return m_denormals; }
+
+    /**
+     * Set flush-to-zero and denormals-are-zero mode on the current
+     * thread for the lifetime of the guard, if the conditioner asks
+     * for it, restoring the previous mode afterwards. Does nothing
+     * on processors for which it is not supported.
+     */
+    class FloatModeGuard
+    {
+    public:
+        FloatModeGuard(const InputConditioner *conditioner);
+        ~FloatModeGuard();
+    private:
+        bool m_set;
+        unsigned long m_saved;
+    };
+
+private:
+    bool m_flushDenormals;
+    bool m_scrub;
+    size_t m_blocks;
+    size_t m_nonFinite;
+    size_t m_denormals;
+};
+
+#endif
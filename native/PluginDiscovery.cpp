@@ -0,0 +1,191 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "PluginDiscovery.h"
+
+#include "vamp-hostsdk/PluginHostAdapter.h"
+#include "vamp-hostsdk/PluginLoader.h"
+
+#include <set>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#define PLUGIN_SUFFIX ".dll"
+#else
+#include <dirent.h>
+#ifdef __APPLE__
+#define PLUGIN_SUFFIX ".dylib"
+#else
+#define PLUGIN_SUFFIX ".so"
+#endif
+#endif
+
+using namespace std;
+using namespace Vamp;
+using namespace Vamp::HostExt;
+
+// Return the names of the files in the given directory
+static vector<string>
+listDirectory(const string &dir)
+{
+    vector<string> names;
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE fh = FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (fh == INVALID_HANDLE_VALUE) return names;
+    do {
+        names.push_back(data.cFileName);
+    } while (FindNextFileA(fh, &data));
+    FindClose(fh);
+#else
+    DIR *d = opendir(dir.c_str());
+    if (!d) return names;
+    while (struct dirent *e = readdir(d)) {
+        names.push_back(e->d_name);
+    }
+    closedir(d);
+#endif
+
+    return names;
+}
+
+// Return the lower-case names (without extension) of the plugin
+// libraries on the Vamp path, as PluginLoader names them in plugin
+// keys, in path order and without duplicates. Only the directories
+// are read: no library is opened.
+static vector<string>
+listLibraryNames()
+{
+    vector<string> libraries;
+    set<string> seen;
+    vector<string> path = PluginHostAdapter::getPluginPath();
+    string suffix = PLUGIN_SUFFIX;
+
+    for (size_t i = 0; i < path.size(); ++i) {
+        vector<string> files = listDirectory(path[i]);
+        for (size_t j = 0; j < files.size(); ++j) {
+            string name = files[j];
+            for (size_t k = 0; k < name.size(); ++k) {
+                name[k] = char(tolower((unsigned char)name[k]));
+            }
+            if (name.size() <= suffix.size() ||
+                name.compare(name.size() - suffix.size(), suffix.size(),
+                             suffix) != 0) {
+                continue;
+            }
+            name = name.substr(0, name.size() - suffix.size());
+            if (seen.insert(name).second) libraries.push_back(name);
+        }
+    }
+
+    return libraries;
+}
+
+bool
+PluginDiscovery::matches(const string &pattern, const string &name)
+{
+    // Iterative wildcard match, backtracking to the most recent *
+    size_t p = 0, n = 0, star = string::npos, mark = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() &&
+            (pattern[p] == '?' ||
+             tolower((unsigned char)pattern[p]) ==
+             tolower((unsigned char)name[n]))) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            mark = n;
+        } else if (star != string::npos) {
+            p = star + 1;
+            n = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+static bool
+matchesAny(const vector<string> &patterns, const string &name)
+{
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        if (PluginDiscovery::matches(patterns[i], name)) return true;
+    }
+    return false;
+}
+
+vector<string>
+PluginDiscovery::listPlugins(const vector<string> &include,
+                             const vector<string> &exclude)
+{
+    PluginLoader *loader = PluginLoader::getInstance();
+
+    if (include.empty() && exclude.empty()) {
+        return loader->listPlugins();
+    }
+
+    vector<string> libraries = listLibraryNames();
+    vector<string> wanted;
+    for (size_t i = 0; i < libraries.size(); ++i) {
+        if (!include.empty() && !matchesAny(include, libraries[i])) continue;
+        if (matchesAny(exclude, libraries[i])) continue;
+        wanted.push_back(libraries[i]);
+    }
+
+    if (wanted.empty()) return vector<string>();
+
+#if (VAMP_SDK_MINOR_VERSION >= 9)
+    // Only the wanted libraries are opened
+    return loader->listPluginsIn(wanted);
+#else
+    // Older SDKs cannot enumerate some libraries only, so all are
+    // opened and the keys filtered by library name afterwards
+    set<string> names(wanted.begin(), wanted.end());
+    vector<string> all = loader->listPlugins();
+    vector<string> keys;
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (names.find(all[i].substr(0, all[i].find(':'))) != names.end()) {
+            keys.push_back(all[i]);
+        }
+    }
+    return keys;
+#endif
+}
@@ -0,0 +1,78 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  PluginDiscovery: List the keys of installed plugins, as
+  PluginLoader::listPlugins does, but optionally only from those
+  plugin libraries on the Vamp path whose names match given patterns,
+  so that the rest need not be opened.
+*/
+
+#ifndef VAMPYHOST_PLUGIN_DISCOVERY_H
+#define VAMPYHOST_PLUGIN_DISCOVERY_H
+
+#include <vector>
+#include <string>
+
+class PluginDiscovery
+{
+public:
+    /**
+     * Return the keys of all plugins found in libraries on the Vamp
+     * path, in the same order as PluginLoader::listPlugins. Only
+     * libraries whose lower-case base names (without extension)
+     * match at least one of the include patterns, if any are given,
+     * and none of the exclude patterns are examined. Patterns may
+     * contain the wildcards * and ? and are matched without regard
+     * to case. Libraries are opened through the shared PluginLoader,
+     * so this must not be called while another thread may be using
+     * it (in vampyhost, hold the GIL). With SDK versions before 2.9,
+     * which cannot enumerate only some libraries, every library is
+     * opened and the keys are filtered afterwards.
+     */
+    static std::vector<std::string> listPlugins
+    (const std::vector<std::string> &include,
+     const std::vector<std::string> &exclude);
+
+    /**
+     * Return true if the given name matches the given wildcard
+     * pattern, ignoring case.
+     */
+    static bool matches(const std::string &pattern, const std::string &name);
+};
+
+#endif
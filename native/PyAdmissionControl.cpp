@@ -0,0 +1,295 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "PyAdmissionControl.h"
+#include "AdmissionControl.h"
+#include "StringConversion.h"
+
+#include <string>
+
+using namespace std;
+
+PyObject *PyAdmissionControl_Error = 0;
+
+static PyObject *
+AdmissionControl_new(PyTypeObject *type, PyObject *args, PyObject *kw)
+{
+    Py_ssize_t maxRunning;
+    Py_ssize_t maxRunningPerKey = 0;
+    Py_ssize_t maxQueued = -1;
+    Py_ssize_t interactiveReserve = 0;
+
+    if (!PyArg_ParseTuple(args, "n|nnn:AdmissionControl.new ",
+                          &maxRunning,
+                          &maxRunningPerKey,
+                          &maxQueued,
+                          &interactiveReserve)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "AdmissionControl constructor takes maximum running (int), and optional maximum running per key (int), maximum queued (int), and interactive reserve (int) arguments");
+        return NULL;
+    }
+
+    if (maxRunning < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Maximum running must be at least 1");
+        return NULL;
+    }
+    if (maxRunningPerKey < 0 || interactiveReserve < 0 ||
+        interactiveReserve >= maxRunning) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Per-key limit must not be negative, and interactive reserve must be less than maximum running");
+        return NULL;
+    }
+
+    AdmissionControlObject *self =
+        PyObject_New(AdmissionControlObject, &AdmissionControl_Type);
+    if (self == NULL) return NULL;
+
+    self->control = new AdmissionControl(maxRunning, maxRunningPerKey,
+                                         long(maxQueued), interactiveReserve);
+
+    return (PyObject *)self;
+}
+
+static void
+AdmissionControlObject_dealloc(AdmissionControlObject *self)
+{
+    delete self->control;
+    PyObject_Del(self);
+}
+
+static bool
+convertLane(int lane, AdmissionControl::Lane &result)
+{
+    if (lane == AdmissionControl::Interactive ||
+        lane == AdmissionControl::Batch) {
+        result = AdmissionControl::Lane(lane);
+        return true;
+    }
+    PyErr_SetString(PyExc_ValueError,
+                    "Lane must be LANE_INTERACTIVE or LANE_BATCH");
+    return false;
+}
+
+static PyObject *
+AdmissionControl_acquire(AdmissionControlObject *self, PyObject *args)
+{
+    PyObject *pyKey;
+    int laneNo = AdmissionControl::Interactive;
+    double timeout = -1.0;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "U|id",
+#else
+                          "S|id",
+#endif
+                          &pyKey,
+                          &laneNo,
+                          &timeout)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "acquire() takes plugin key (string), and optional lane (int) and timeout (float) arguments");
+        return NULL;
+    }
+
+    AdmissionControl::Lane lane;
+    if (!convertLane(laneNo, lane)) return NULL;
+
+    string key = StringConversion().py2string(pyKey);
+
+    AdmissionControl::Outcome outcome;
+    double waited = 0.0;
+
+    Py_BEGIN_ALLOW_THREADS
+    outcome = self->control->acquire(key, lane, timeout, waited);
+    Py_END_ALLOW_THREADS
+
+    switch (outcome) {
+    case AdmissionControl::Admitted:
+        return PyFloat_FromDouble(waited);
+    case AdmissionControl::Rejected:
+        PyErr_SetString(PyAdmissionControl_Error,
+                        "Admission queue is full");
+        return NULL;
+    case AdmissionControl::TimedOut:
+    default:
+        PyErr_SetString(PyAdmissionControl_Error,
+                        "Timed out waiting for admission");
+        return NULL;
+    }
+}
+
+static PyObject *
+AdmissionControl_release(AdmissionControlObject *self, PyObject *args)
+{
+    PyObject *pyKey;
+    int laneNo = AdmissionControl::Interactive;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "U|i",
+#else
+                          "S|i",
+#endif
+                          &pyKey,
+                          &laneNo)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "release() takes plugin key (string) and optional lane (int) arguments");
+        return NULL;
+    }
+
+    AdmissionControl::Lane lane;
+    if (!convertLane(laneNo, lane)) return NULL;
+
+    self->control->release(StringConversion().py2string(pyKey), lane);
+
+    Py_RETURN_NONE;
+}
+
+static int
+setsize(PyObject *d, const char *name, size_t value)
+{
+    PyObject *v = PyLong_FromSize_t(value);
+    int err = PyDict_SetItemString(d, name, v);
+    Py_XDECREF(v);
+    return err;
+}
+
+static int
+setfloat(PyObject *d, const char *name, double value)
+{
+    PyObject *v = PyFloat_FromDouble(value);
+    int err = PyDict_SetItemString(d, name, v);
+    Py_XDECREF(v);
+    return err;
+}
+
+static PyObject *
+AdmissionControl_metrics(AdmissionControlObject *self)
+{
+    static const char *laneNames[AdmissionControl::LaneCount] = {
+        "interactive", "batch"
+    };
+
+    PyObject *result = PyDict_New();
+    if (!result) return NULL;
+
+    for (int i = 0; i < AdmissionControl::LaneCount; ++i) {
+
+        AdmissionControl::LaneMetrics m =
+            self->control->getMetrics(AdmissionControl::Lane(i));
+
+        PyObject *d = PyDict_New();
+        if (!d) {
+            Py_DECREF(result);
+            return NULL;
+        }
+
+        setsize(d, "admitted", m.admitted);
+        setsize(d, "rejected", m.rejected);
+        setsize(d, "timed_out", m.timedOut);
+        setsize(d, "queued", m.queued);
+        setsize(d, "running", m.running);
+        setfloat(d, "wait_total", m.totalWait);
+        setfloat(d, "wait_max", m.maxWait);
+        setfloat(d, "wait_mean", m.admitted > 0 ? m.totalWait / m.admitted : 0.0);
+
+        PyDict_SetItemString(result, laneNames[i], d);
+        Py_DECREF(d);
+    }
+
+    return result;
+}
+
+static PyMethodDef AdmissionControl_methods[] =
+{
+    {"acquire", (PyCFunction)AdmissionControl_acquire, METH_VARARGS,
+     PyDoc_STR("acquire(key, lane=LANE_INTERACTIVE, timeout=-1) -> Wait until a processing call for the given plugin key may run in the given lane, and return the time spent waiting, in seconds. Raises AdmissionError at once if the queue is full, or after timeout seconds if timeout is not negative and the call has not been admitted. Every successful acquire() must be followed by a release() with the same key and lane.")},
+
+    {"release", (PyCFunction)AdmissionControl_release, METH_VARARGS,
+     PyDoc_STR("release(key, lane=LANE_INTERACTIVE) -> Mark a call admitted by acquire() as finished, allowing a waiting call to run.")},
+
+    {"metrics", (PyCFunction)AdmissionControl_metrics, METH_NOARGS,
+     PyDoc_STR("metrics() -> Return a dictionary mapping each lane name (\"interactive\", \"batch\") to a dictionary of counts of calls admitted, rejected, timed_out, currently queued and currently running, and the total, maximum, and mean time in seconds that admitted calls spent waiting.")},
+
+    {NULL, NULL}           /* sentinel */
+};
+
+/* Doc:: 10.3 Type Objects */ /* static */ 
+PyTypeObject AdmissionControl_Type = 
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "vampyhost.AdmissionControl",       /*tp_name*/
+    sizeof(AdmissionControlObject),     /*tp_basicsize*/
+    0,                                  /*tp_itemsize*/
+    (destructor)AdmissionControlObject_dealloc, /*tp_dealloc*/
+    0,                                  /*tp_print*/
+    0,                                  /*tp_getattr*/
+    0,                                  /*tp_setattr*/
+    0,                                  /*tp_compare*/
+    0,                                  /*tp_repr*/
+    0,                                  /*tp_as_number*/
+    0,                                  /*tp_as_sequence*/
+    0,                                  /*tp_as_mapping*/
+    0,                                  /*tp_hash*/
+    0,                                  /*tp_call*/
+    0,                                  /*tp_str*/
+    PyObject_GenericGetAttr,            /*tp_getattro*/
+    0,                                  /*tp_setattro*/
+    0,                                  /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,                 /*tp_flags*/
+    "AdmissionControl(max_running, max_running_per_key=0, max_queued=-1, interactive_reserve=0) -> Admission control for processing calls: at most max_running calls run at once, and at most max_running_per_key for any one plugin key (if not 0). Calls beyond those limits wait in one of two priority lanes, interactive calls being admitted ahead of batch calls, with interactive_reserve running slots kept for interactive calls only. If max_queued is not negative, calls that would take the number waiting in their lane beyond it are rejected at once.", /*tp_doc*/
+    0,                                  /*tp_traverse*/
+    0,                                  /*tp_clear*/
+    0,                                  /*tp_richcompare*/
+    0,                                  /*tp_weaklistoffset*/
+    0,                                  /*tp_iter*/
+    0,                                  /*tp_iternext*/
+    AdmissionControl_methods,           /*tp_methods*/
+    0,                                  /*tp_members*/
+    0,                                  /*tp_getset*/
+    0,                                  /*tp_base*/
+    0,                                  /*tp_dict*/
+    0,                                  /*tp_descr_get*/
+    0,                                  /*tp_descr_set*/
+    0,                                  /*tp_dictoffset*/
+    0,                                  /*tp_init*/
+    0,                                  /*tp_alloc*/
+    AdmissionControl_new,               /*tp_new*/
+    0,                                  /*tp_free*/
+    0,                                  /*tp_is_gc*/
+};
@@ -0,0 +1,234 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "PyFilePrefetcher.h"
+#include "FilePrefetcher.h"
+#include "StringConversion.h"
+
+// define a unique API pointer 
+#define PY_ARRAY_UNIQUE_SYMBOL VAMPYHOST_ARRAY_API
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#define NO_IMPORT_ARRAY
+#include "numpy/arrayobject.h"
+
+using namespace std;
+
+static const char *samplesCapsuleName = "vampyhost.FilePrefetcher.samples";
+
+static void
+deleteSamples(PyObject *capsule)
+{
+    delete (vector<float> *)PyCapsule_GetPointer(capsule, samplesCapsuleName);
+}
+
+static PyObject *
+FilePrefetcher_new(PyTypeObject *type, PyObject *args, PyObject *kw)
+{
+    PyObject *pyPaths;
+    int threads = 0;
+    Py_ssize_t maxBytes = Py_ssize_t(256) << 20;
+    Py_ssize_t chunkSize = Py_ssize_t(1) << 20;
+
+    if (!PyArg_ParseTuple(args, "O|inn:FilePrefetcher.new ",
+                          &pyPaths,
+                          &threads,
+                          &maxBytes,
+                          &chunkSize)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "FilePrefetcher constructor takes paths (list of strings), and optional thread count (int), read-ahead limit in bytes (int) and chunk size in bytes (int) arguments");
+        return NULL;
+    }
+
+    if (threads < 0 || maxBytes < 1 || chunkSize < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Thread count must not be negative, and read-ahead limit and chunk size must be at least 1");
+        return NULL;
+    }
+
+    PyObject *seq = PySequence_Fast(pyPaths, "Paths must be a list of strings");
+    if (!seq) return NULL;
+
+    vector<string> paths;
+    StringConversion conv;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); ++i) {
+        PyObject *p = PySequence_Fast_GET_ITEM(seq, i);
+#if (PY_MAJOR_VERSION >= 3)
+        bool isString = PyUnicode_Check(p);
+#else
+        bool isString = PyString_Check(p);
+#endif
+        if (!isString) {
+            PyErr_SetString(PyExc_TypeError, "Paths must be a list of strings");
+            Py_DECREF(seq);
+            return NULL;
+        }
+        paths.push_back(conv.py2string(p));
+    }
+    Py_DECREF(seq);
+
+    FilePrefetcherObject *self =
+        PyObject_New(FilePrefetcherObject, &FilePrefetcher_Type);
+    if (self == NULL) return NULL;
+
+    self->prefetcher = new FilePrefetcher(paths, threads, maxBytes, chunkSize);
+
+    return (PyObject *)self;
+}
+
+static void
+FilePrefetcherObject_dealloc(FilePrefetcherObject *self)
+{
+    // Waits for the workers to complete any reads in progress
+    FilePrefetcher *prefetcher = self->prefetcher;
+    Py_BEGIN_ALLOW_THREADS
+    delete prefetcher;
+    Py_END_ALLOW_THREADS
+    PyObject_Del(self);
+}
+
+static PyObject *
+FilePrefetcher_iternext(FilePrefetcherObject *self)
+{
+    FilePrefetcher::Result result;
+    bool found;
+
+    Py_BEGIN_ALLOW_THREADS
+    found = self->prefetcher->next(result);
+    Py_END_ALLOW_THREADS
+
+    if (!found) return NULL; // StopIteration
+
+    if (result.error != "") {
+        PyErr_SetString(PyExc_IOError, result.error.c_str());
+        return NULL;
+    }
+
+    // Hand the decoded samples over to the array rather than copying
+    vector<float> *samples = new vector<float>;
+    samples->swap(result.data);
+
+    npy_intp dims[2];
+    dims[0] = result.channels;
+    dims[1] = result.frames;
+
+    PyObject *arr;
+    if (samples->empty()) {
+        delete samples;
+        arr = PyArray_ZEROS(2, dims, NPY_FLOAT, 0);
+        if (!arr) return NULL;
+    } else {
+        PyObject *capsule = PyCapsule_New(samples, samplesCapsuleName,
+                                          deleteSamples);
+        if (!capsule) {
+            delete samples;
+            return NULL;
+        }
+        arr = PyArray_SimpleNewFromData(2, dims, NPY_FLOAT, &(*samples)[0]);
+        if (!arr) {
+            Py_DECREF(capsule);
+            return NULL;
+        }
+        if (PyArray_SetBaseObject((PyArrayObject *)arr, capsule) < 0) {
+            Py_DECREF(arr);
+            return NULL;
+        }
+    }
+
+    return Py_BuildValue("(NNd)",
+                         StringConversion().string2py(result.path),
+                         arr,
+                         double(result.sampleRate));
+}
+
+static PyObject *
+FilePrefetcher_threads(FilePrefetcherObject *self, PyObject *)
+{
+    return PyLong_FromSize_t(self->prefetcher->getThreadCount());
+}
+
+static PyMethodDef FilePrefetcher_methods[] =
+{
+    {"threads", (PyCFunction)FilePrefetcher_threads, METH_NOARGS,
+     PyDoc_STR("threads() -> Return the number of worker threads reading files.")},
+
+    {NULL, NULL}           /* sentinel */
+};
+
+/* Doc:: 10.3 Type Objects */ /* static */ 
+PyTypeObject FilePrefetcher_Type = 
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "vampyhost.FilePrefetcher",         /*tp_name*/
+    sizeof(FilePrefetcherObject),       /*tp_basicsize*/
+    0,                                  /*tp_itemsize*/
+    (destructor)FilePrefetcherObject_dealloc, /*tp_dealloc*/
+    0,                                  /*tp_print*/
+    0,                                  /*tp_getattr*/
+    0,                                  /*tp_setattr*/
+    0,                                  /*tp_compare*/
+    0,                                  /*tp_repr*/
+    0,                                  /*tp_as_number*/
+    0,                                  /*tp_as_sequence*/
+    0,                                  /*tp_as_mapping*/
+    0,                                  /*tp_hash*/
+    0,                                  /*tp_call*/
+    0,                                  /*tp_str*/
+    PyObject_GenericGetAttr,            /*tp_getattro*/
+    0,                                  /*tp_setattro*/
+    0,                                  /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,                 /*tp_flags*/
+    "FilePrefetcher(paths, threads=0, max_bytes=268435456, chunk_size=1048576) -> Read and decode the WAV files at the given paths ahead of their use, on a pool of worker threads (one per hardware thread if threads is 0). Files are read in chunks of chunk_size bytes with positional reads, so that many reads are in flight at once across several files, and no more than about max_bytes of memory is held ahead of the file last taken, counting both the bytes of files being read and decoded and the samples they decode to. Iterating yields a tuple of path, samples (a 2D float32 array with one row per channel) and sample rate for each file, in the order given, waiting without the GIL for each to be ready. A file that cannot be read or decoded raises IOError when its turn comes; iteration may continue past it.", /*tp_doc*/
+    0,                                  /*tp_traverse*/
+    0,                                  /*tp_clear*/
+    0,                                  /*tp_richcompare*/
+    0,                                  /*tp_weaklistoffset*/
+    PyObject_SelfIter,                  /*tp_iter*/
+    (iternextfunc)FilePrefetcher_iternext, /*tp_iternext*/
+    FilePrefetcher_methods,             /*tp_methods*/
+    0,                                  /*tp_members*/
+    0,                                  /*tp_getset*/
+    0,                                  /*tp_base*/
+    0,                                  /*tp_dict*/
+    0,                                  /*tp_descr_get*/
+    0,                                  /*tp_descr_set*/
+    0,                                  /*tp_dictoffset*/
+    0,                                  /*tp_init*/
+    0,                                  /*tp_alloc*/
+    FilePrefetcher_new,                 /*tp_new*/
+    0,                                  /*tp_free*/
+    0,                                  /*tp_is_gc*/
+};
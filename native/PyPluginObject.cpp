@@ -53,6 +53,11 @@
 #include "VectorConversion.h"
 #include "StringConversion.h"
 #include "PyRealTime.h"
+#include "FeatureCollector.h"
+#include "FeatureTransform.h"
+#include "RollingCollector.h"
+#include "SlowBlockMonitor.h"
+#include "InputConditioner.h"
 
 #include "vamp-hostsdk/PluginWrapper.h"
 #include "vamp-hostsdk/PluginInputDomainAdapter.h"
@@ -60,6 +65,7 @@
 #include <string>
 #include <vector>
 #include <cstddef>
+#include <cstring>
 #include <set>
 
 using namespace std;
@@ -78,6 +84,10 @@ getPluginObject(PyObject *pyPluginHandle)
         PyErr_SetString(PyExc_AttributeError,
                         "Invalid or already deleted plugin handle.");
         return 0;
+    } else if (pd->busy) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Plugin is in use by another thread.");
+        return 0;
     } else {
         return pd;
     }
@@ -121,12 +131,14 @@ setstring(PyObject *d, const char *name, string value)
 }
 
 PyObject *
-PyPluginObject_From_Plugin(Plugin *plugin)
+PyPluginObject_From_Plugin(Plugin *plugin, string pluginKey,
+                           float inputSampleRate)
 {
     PyPluginObject *pd = PyObject_New(PyPluginObject, &Plugin_Type);
     if (!pd) return 0;
     
     pd->plugin = plugin;
+    pd->inputSampleRate = inputSampleRate;
     pd->isInitialised = false;
     pd->channels = 0;
     pd->blockSize = 0;
@@ -134,12 +146,18 @@ PyPluginObject_From_Plugin(Plugin *plugin)
     pd->info = 0;
     pd->parameters = 0;
     pd->programs = 0;
+    pd->rolling = 0;
+    pd->lastTimestamp = RealTime::zeroTime;
+    pd->busy = false;
+    pd->slowBlocks = 0;
+    pd->conditioner = 0;
 
     StringConversion strconv;
     
     PyObject *infodict = PyDict_New();
     setint(infodict, "apiVersion", plugin->getVampApiVersion());
     setint(infodict, "pluginVersion", plugin->getPluginVersion());
+    setstring(infodict, "pluginKey", pluginKey);
     setstring(infodict, "identifier", plugin->getIdentifier());
     setstring(infodict, "name", plugin->getName());
     setstring(infodict, "description", plugin->getDescription());
@@ -192,12 +210,27 @@ PyPluginObject_From_Plugin(Plugin *plugin)
     return (PyObject *)pd;
 }
 
+static void
+deleteRolling(PyPluginObject *pd)
+{
+    if (!pd->rolling) return;
+    for (map<int, RollingCollector *>::iterator i = pd->rolling->begin();
+         i != pd->rolling->end(); ++i) {
+        delete i->second;
+    }
+    delete pd->rolling;
+    pd->rolling = 0;
+}
+
 static void
 PyPluginObject_dealloc(PyPluginObject *self)
 {
 //    cerr << "PyPluginObject_dealloc: plugin object " << self << ", plugin " << self->plugin << endl;
 
     delete self->plugin;
+    deleteRolling(self);
+    delete self->slowBlocks;
+    delete self->conditioner;
     Py_XDECREF(self->info);
     Py_XDECREF(self->parameters);
     Py_XDECREF(self->programs);
@@ -390,6 +423,14 @@ reset(PyObject *self, PyObject *)
     }
         
     pd->plugin->reset();
+
+    if (pd->rolling) {
+        for (map<int, RollingCollector *>::iterator i = pd->rolling->begin();
+             i != pd->rolling->end(); ++i) {
+            i->second->clear();
+        }
+    }
+
     Py_RETURN_TRUE;
 }
 
@@ -554,52 +595,58 @@ select_program(PyObject *self, PyObject *args)
     Py_RETURN_TRUE;
 }
 
-static
 PyObject *
-convertFeatureSet(const Plugin::FeatureSet &fs)
+convertFeatureList(const Plugin::FeatureList &fl)
 {
     VectorConversion conv;
-    
-    PyObject *pyFs = PyDict_New();
 
-    for (Plugin::FeatureSet::const_iterator fsi = fs.begin();
-         fsi != fs.end(); ++fsi) {
+    PyObject *pyFl = PyList_New(fl.size());
 
-        int fno = fsi->first;
-        const Plugin::FeatureList &fl = fsi->second;
+    for (int fli = 0; fli < (int)fl.size(); ++fli) {
 
-        if (!fl.empty()) {
+        const Plugin::Feature &f = fl[fli];
+        PyObject *pyF = PyDict_New();
 
-            PyObject *pyFl = PyList_New(fl.size());
+        if (f.hasTimestamp) {
+            PyObject *rt = PyRealTime_FromRealTime(f.timestamp);
+            PyDict_SetItemString(pyF, "timestamp", rt);
+            Py_DECREF(rt);
+        }
+        if (f.hasDuration) {
+            PyObject *rt = PyRealTime_FromRealTime(f.duration);
+            PyDict_SetItemString(pyF, "duration", rt);
+            Py_DECREF(rt);
+        }
 
-            for (int fli = 0; fli < (int)fl.size(); ++fli) {
+        setstring(pyF, "label", f.label);
 
-                const Plugin::Feature &f = fl[fli];
-                PyObject *pyF = PyDict_New();
+        if (!f.values.empty()) {
+            PyObject *vv = conv.PyArray_From_FloatVector(f.values);
+            PyDict_SetItemString(pyF, "values", vv);
+            Py_DECREF(vv);
+        }
 
-                if (f.hasTimestamp) {
-                    PyObject *rt = PyRealTime_FromRealTime(f.timestamp);
-                    PyDict_SetItemString(pyF, "timestamp", rt);
-                    Py_DECREF(rt);
-                }
-                if (f.hasDuration) {
-                    PyObject *rt = PyRealTime_FromRealTime(f.duration);
-                    PyDict_SetItemString(pyF, "duration", rt);
-                    Py_DECREF(rt);
-                }
+        PyList_SET_ITEM(pyFl, fli, pyF);
+    }
 
-                StringConversion strconv;
+    return pyFl;
+}
 
-                setstring(pyF, "label", f.label);
+static
+PyObject *
+convertFeatureSet(const Plugin::FeatureSet &fs)
+{
+    PyObject *pyFs = PyDict_New();
 
-                if (!f.values.empty()) {
-                    PyObject *vv = conv.PyArray_From_FloatVector(f.values);
-                    PyDict_SetItemString(pyF, "values", vv);
-                    Py_DECREF(vv);
-                }
+    for (Plugin::FeatureSet::const_iterator fsi = fs.begin();
+         fsi != fs.end(); ++fsi) {
 
-                PyList_SET_ITEM(pyFl, fli, pyF);
-            }
+        int fno = fsi->first;
+        const Plugin::FeatureList &fl = fsi->second;
+
+        if (!fl.empty()) {
+
+            PyObject *pyFl = convertFeatureList(fl);
 
             PyObject *pyN = PyLong_FromLong(fno);
             PyDict_SetItem(pyFs, pyN, pyFl);
@@ -611,16 +658,56 @@ convertFeatureSet(const Plugin::FeatureSet &fs)
     return pyFs;
 }
 
+// Convert a contiguous float32 or float64 array straight into the
+// plugin input, scrubbing it in the same pass. Return false if the
+// array is of any other type or layout.
+static bool
+convertConditionedInput(PyObject *pyBuffer, InputConditioner *conditioner,
+                        vector<vector<float> > &data)
+{
+    PyArrayObject *arr = (PyArrayObject *)pyBuffer;
+    if (PyArray_NDIM(arr) != 2) return false;
+
+    int type = PyArray_TYPE(arr);
+    size_t itemSize = (type == NPY_FLOAT ? sizeof(float) :
+                       type == NPY_DOUBLE ? sizeof(double) : 0);
+    if (itemSize == 0 || size_t(PyArray_STRIDES(arr)[1]) != itemSize) {
+        return false;
+    }
+
+    size_t n = PyArray_DIMS(arr)[1];
+    data.resize(PyArray_DIMS(arr)[0]);
+    for (size_t c = 0; c < data.size(); ++c) {
+        data[c].resize(n);
+        void *row = PyArray_GETPTR2(arr, c, 0);
+        if (type == NPY_FLOAT) {
+            conditioner->convert((const float *)row, &data[c][0], n);
+        } else {
+            conditioner->convert((const double *)row, &data[c][0], n);
+        }
+    }
+    return true;
+}
+
 static vector<vector<float> >
-convertPluginInput(PyObject *pyBuffer, int channels, int blockSize)
+convertPluginInput(PyObject *pyBuffer, int channels, int blockSize,
+                   InputConditioner *conditioner)
 {
     vector<vector<float> > data;
 
     VectorConversion conv;
 
+    bool conditioned = false;
+
     if (PyArray_CheckExact(pyBuffer)) {
 
-        data = conv.Py2DArray_To_FloatVector(pyBuffer);
+        if (conditioner && conditioner->scrubs() &&
+            convertConditionedInput(pyBuffer, conditioner, data)) {
+            conditioned = true;
+        } else {
+            data = conv.Py2DArray_To_FloatVector(pyBuffer);
+        }
+
 
         if (conv.error) {
             PyErr_SetString(PyExc_TypeError, conv.getError().str().c_str());
@@ -663,10 +750,30 @@ convertPluginInput(PyObject *pyBuffer, int channels, int blockSize)
             return vector<vector<float> >();
         }
     }
+
+    if (conditioner && conditioner->scrubs() && !conditioned) {
+        for (int c = 0; c < channels; ++c) {
+            conditioner->convert(&data[c][0], &data[c][0], blockSize);
+        }
+    }
     
     return data;
 }
 
+// Pass the features in a feature set to any rolling collectors
+// attached to their outputs
+void
+feedRolling(PyPluginObject *pd, const Plugin::FeatureSet &fs,
+            const RealTime &timestamp)
+{
+    if (!pd->rolling) return;
+    for (map<int, RollingCollector *>::iterator i = pd->rolling->begin();
+         i != pd->rolling->end(); ++i) {
+        Plugin::FeatureSet::const_iterator fi = fs.find(i->first);
+        if (fi != fs.end()) i->second->add(fi->second, timestamp);
+    }
+}
+
 static PyObject *
 process_block(PyObject *self, PyObject *args)
 {
@@ -695,7 +802,7 @@ process_block(PyObject *self, PyObject *args)
 
     int channels = pd->channels;
     vector<vector<float> > data =
-        convertPluginInput(pyBuffer, channels, pd->blockSize);
+        convertPluginInput(pyBuffer, channels, pd->blockSize, pd->conditioner);
     if (data.empty()) return 0;
 
     float **inbuf = new float *[channels];
@@ -703,9 +810,22 @@ process_block(PyObject *self, PyObject *args)
         inbuf[c] = &data[c][0];
     }
     RealTime timeStamp = *PyRealTime_AsRealTime(pyRealTime);
-    Plugin::FeatureSet fs = pd->plugin->process(inbuf, timeStamp);
+    double started = (pd->slowBlocks ? SlowBlockMonitor::now() : 0.0);
+    Plugin::FeatureSet fs;
+    {
+        InputConditioner::FloatModeGuard guard(pd->conditioner);
+        fs = pd->plugin->process(inbuf, timeStamp);
+    }
+    if (pd->conditioner) pd->conditioner->addBlock();
+    if (pd->slowBlocks) {
+        pd->slowBlocks->check(inbuf, channels, pd->blockSize, timeStamp,
+                              SlowBlockMonitor::now() - started);
+    }
     delete[] inbuf;
 
+    pd->lastTimestamp = timeStamp;
+    feedRolling(pd, fs, timeStamp);
+
     return convertFeatureSet(fs);
 }
 
@@ -723,9 +843,953 @@ get_remaining_features(PyObject *self, PyObject *)
 
     Plugin::FeatureSet fs = pd->plugin->getRemainingFeatures();
 
+    // Remaining features belong after the last block processed
+    feedRolling(pd, fs, pd->lastTimestamp +
+                RealTime::frame2RealTime(pd->stepSize, pd->inputSampleRate));
+
     return convertFeatureSet(fs);
 }
 
+static PyArrayObject *
+convertCollectInput(PyObject *pyBuffer, int channels)
+{
+    PyArrayObject *data = (PyArrayObject *)
+        PyArray_FROM_OTF(pyBuffer, NPY_FLOAT,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!data) return 0;
+
+    int ndim = PyArray_NDIM(data);
+    if (ndim != 1 && ndim != 2) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Audio data must be a one- or two-dimensional array");
+        Py_DECREF(data);
+        return 0;
+    }
+
+    if ((ndim == 1 ? 1 : PyArray_DIMS(data)[0]) != channels) {
+        PyErr_SetString(PyExc_TypeError, "Wrong number of channels");
+        Py_DECREF(data);
+        return 0;
+    }
+
+    return data;
+}
+
+// Run the frames from start to end of the given audio (n frames per
+// channel, with the channels one after another) through the plugin,
+// from a reset, in the same way as vamp.process does, passing the
+// features from each of the given outputs to the corresponding
+// collector. Timestamps are those of the frames within the whole
+// audio. Every block that lies within it is passed to the plugin
+// directly without copying; the last block of a range may extend past
+// end into the following audio. If the input is to be scrubbed, each
+// block is instead scrubbed into a block-sized window as it is
+// reached, moving along the frames it shares with the previous block
+// so that every frame is scrubbed (and counted) once. Each block is
+// timed if a slow block monitor is set. Called without the GIL, with
+// the plugin object marked busy.
+static void
+processRange(PyPluginObject *pd, const float *base, size_t n,
+             size_t start, size_t end,
+             const vector<int> &outputs,
+             const vector<FeatureCollector *> &collectors)
+{
+    Plugin *plugin = pd->plugin;
+    SlowBlockMonitor *monitor = pd->slowBlocks;
+    int channels = pd->channels;
+    size_t blockSize = pd->blockSize;
+    size_t stepSize = pd->stepSize;
+
+    if (end > n) end = n;
+
+    vector<vector<float> > padded;
+    vector<const float *> inbuf(channels);
+
+    InputConditioner *conditioner = pd->conditioner;
+    bool scrub = (conditioner && conditioner->scrubs());
+    vector<vector<float> > window;
+    size_t windowStart = start;
+    size_t windowFrames = 0;
+    if (scrub) window.resize(channels, vector<float>(blockSize, 0.f));
+
+    plugin->reset();
+
+    size_t next = start;
+
+    for (size_t i = start; i < end; i += stepSize) {
+
+        if (scrub) {
+            size_t frames = min(blockSize, n - i);
+            size_t keep = 0;
+            if (i < windowStart + windowFrames) {
+                keep = windowStart + windowFrames - i;
+            }
+            for (int c = 0; c < channels; ++c) {
+                float *w = &window[c][0];
+                if (keep > 0) {
+                    memmove(w, w + (i - windowStart), keep * sizeof(float));
+                }
+                conditioner->convert(base + c * n + i + keep, w + keep,
+                                     frames - keep);
+                fill(w + frames, w + blockSize, 0.f);
+                inbuf[c] = w;
+            }
+            windowStart = i;
+            windowFrames = frames;
+        } else if (i + blockSize <= n) {
+            for (int c = 0; c < channels; ++c) {
+                inbuf[c] = base + c * n + i;
+            }
+        } else {
+            padded.resize(channels);
+            for (int c = 0; c < channels; ++c) {
+                padded[c].assign(blockSize, 0.f);
+                for (size_t j = 0; j < n - i; ++j) {
+                    padded[c][j] = base[c * n + i + j];
+                }
+                inbuf[c] = &padded[c][0];
+            }
+        }
+
+        RealTime timestamp = RealTime::frame2RealTime(i, pd->inputSampleRate);
+        double started = (monitor ? SlowBlockMonitor::now() : 0.0);
+        Plugin::FeatureSet fs = plugin->process(&inbuf[0], timestamp);
+        if (conditioner) conditioner->addBlock();
+        if (monitor) {
+            monitor->check(&inbuf[0], channels, blockSize, timestamp,
+                           SlowBlockMonitor::now() - started);
+        }
+
+        for (size_t k = 0; k < outputs.size(); ++k) {
+            Plugin::FeatureSet::const_iterator fi = fs.find(outputs[k]);
+            if (fi != fs.end()) collectors[k]->add(fi->second, timestamp);
+        }
+
+        next = i + stepSize;
+    }
+
+    // Remaining features belong after the last block processed
+    Plugin::FeatureSet fs = plugin->getRemainingFeatures();
+    RealTime timestamp = RealTime::frame2RealTime(next, pd->inputSampleRate);
+
+    for (size_t k = 0; k < outputs.size(); ++k) {
+        Plugin::FeatureSet::const_iterator fi = fs.find(outputs[k]);
+        if (fi != fs.end()) collectors[k]->add(fi->second, timestamp);
+    }
+}
+
+// Process a range of the given audio (a C-contiguous float array with
+// one row per channel) as processRange does. The GIL is released
+// throughout, so that other threads (such as those handling live
+// streams) are not held up by a long collection; the plugin object is
+// marked busy meanwhile so that they cannot use it.
+static void
+processArray(PyPluginObject *pd, PyArrayObject *data,
+             size_t start, size_t end,
+             const vector<int> &outputs,
+             const vector<FeatureCollector *> &collectors)
+{
+    size_t n = PyArray_DIMS(data)[PyArray_NDIM(data) - 1];
+    const float *base = (const float *)PyArray_DATA(data);
+
+    pd->busy = true;
+    Py_BEGIN_ALLOW_THREADS
+
+    InputConditioner::FloatModeGuard guard(pd->conditioner);
+    processRange(pd, base, n, start, end, outputs, collectors);
+
+    Py_END_ALLOW_THREADS
+    pd->busy = false;
+}
+
+static void
+deleteCollectors(vector<FeatureCollector *> &collectors)
+{
+    for (size_t k = 0; k < collectors.size(); ++k) {
+        delete collectors[k];
+    }
+    collectors.clear();
+}
+
+// Find the out array for output k of n from an out argument, which is
+// a single array (or None) for a single output, or a list with one
+// array (or None) per output. Return false and set an exception if it
+// is malformed.
+static bool
+pickOutArray(PyObject *spec, size_t k, size_t n, bool multiple,
+             PyObject *&arr)
+{
+    arr = 0;
+    if (!spec || spec == Py_None) return true;
+    if (!multiple) {
+        arr = spec;
+        return true;
+    }
+    if (!PyList_Check(spec) || PyList_GET_SIZE(spec) != Py_ssize_t(n)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "A list of outputs requires a list of out arrays of the same length");
+        return false;
+    }
+    arr = PyList_GET_ITEM(spec, k);
+    return true;
+}
+
+static PyObject *
+collect(PyObject *self, PyObject *args)
+{
+    PyObject *pyBuffer;
+    PyObject *pyOutput;
+    PyObject *pyTransforms = 0;
+    ssize_t memoryLimit = 0;
+    PyObject *pySpillFile = 0;
+    int sparse = 0;
+    PyObject *pyOut = 0;
+    PyObject *pyOutTimes = 0;
+
+    if (!PyArg_ParseTuple(args, "OO|OnOiOO",
+                          &pyBuffer,
+                          &pyOutput,
+                          &pyTransforms,
+                          &memoryLimit,
+                          &pySpillFile,
+                          &sparse,
+                          &pyOut,
+                          &pyOutTimes)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "collect() takes buffer (1D or 2D array, one row per channel), output index (int or list of ints), and optional transforms (list), memory limit (int), spill file (file object or list of them), sparse (bool), out (array or list of them), and out_times (array or list of them) arguments");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->isInitialised || pd->stepSize == 0) {
+        PyErr_SetString(PyExc_Exception,
+                        "Plugin has not been initialised.");
+        return 0;
+    }
+
+    // A list of outputs gets a list of results, one per output, with
+    // transforms applied only to those outputs that can take them
+    bool multiple = PyList_Check(pyOutput);
+
+    vector<PyObject *> pyOutputs;
+    if (multiple) {
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pyOutput); ++i) {
+            pyOutputs.push_back(PyList_GET_ITEM(pyOutput, i));
+        }
+    } else {
+        pyOutputs.push_back(pyOutput);
+    }
+
+    vector<PyObject *> pySpillFiles(pyOutputs.size(), (PyObject *)0);
+    if (memoryLimit > 0 && pySpillFile && pySpillFile != Py_None) {
+        if (multiple) {
+            if (!PyList_Check(pySpillFile) ||
+                PyList_GET_SIZE(pySpillFile) != Py_ssize_t(pyOutputs.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                                "A list of outputs requires a list of spill files of the same length");
+                return 0;
+            }
+            for (size_t k = 0; k < pyOutputs.size(); ++k) {
+                pySpillFiles[k] = PyList_GET_ITEM(pySpillFile, k);
+            }
+        } else {
+            pySpillFiles[0] = pySpillFile;
+        }
+    }
+
+    // The memory limit is shared equally between the outputs that
+    // can spill, so that it bounds the whole collection
+    size_t spilling = 0;
+    for (size_t k = 0; k < pySpillFiles.size(); ++k) {
+        if (pySpillFiles[k] && pySpillFiles[k] != Py_None) ++spilling;
+    }
+    size_t outputLimit = size_t(memoryLimit);
+    if (spilling > 1) outputLimit /= spilling;
+
+    FeatureTransform transforms;
+    if (!transforms.parse(pyTransforms)) return 0;
+
+    Plugin::OutputList ol = pd->plugin->getOutputDescriptors();
+
+    vector<int> outputs;
+    vector<FeatureCollector *> collectors;
+
+    for (size_t k = 0; k < pyOutputs.size(); ++k) {
+
+        Py_ssize_t output = PyNumber_AsSsize_t(pyOutputs[k], PyExc_OverflowError);
+        if (output == -1 && PyErr_Occurred()) {
+            deleteCollectors(collectors);
+            return 0;
+        }
+        if (output < 0 || output >= Py_ssize_t(ol.size())) {
+            PyErr_SetString(PyExc_Exception,
+                            "output index out of range");
+            deleteCollectors(collectors);
+            return 0;
+        }
+
+        FeatureCollector *collector = new FeatureCollector(ol[output]);
+        outputs.push_back(int(output));
+        collectors.push_back(collector);
+
+        bool transformable =
+            (collector->getShape() != FeatureCollector::ListShape);
+
+        if (!multiple || transformable) {
+            if (!collector->setTransforms(transforms)) {
+                deleteCollectors(collectors);
+                return 0;
+            }
+        }
+
+        if (memoryLimit > 0 && transformable) {
+            PyObject *file = pySpillFiles[k];
+            if (!file || file == Py_None) {
+                PyErr_SetString(PyExc_ValueError,
+                                "A spill file is required with a memory limit");
+                deleteCollectors(collectors);
+                return 0;
+            }
+            if (!collector->setSpillFile(outputLimit, file)) {
+                deleteCollectors(collectors);
+                return 0;
+            }
+        }
+
+        if (!collector->setSparse(sparse != 0)) {
+            deleteCollectors(collectors);
+            return 0;
+        }
+
+        PyObject *out, *outTimes;
+        if (!pickOutArray(pyOut, k, pyOutputs.size(), multiple, out) ||
+            !pickOutArray(pyOutTimes, k, pyOutputs.size(), multiple, outTimes) ||
+            !collector->setOutputArrays(out, outTimes)) {
+            deleteCollectors(collectors);
+            return 0;
+        }
+    }
+
+    PyArrayObject *data = convertCollectInput(pyBuffer, pd->channels);
+    if (!data) {
+        deleteCollectors(collectors);
+        return 0;
+    }
+
+    processArray(pd, data, 0, PyArray_DIMS(data)[PyArray_NDIM(data) - 1],
+                 outputs, collectors);
+
+    Py_DECREF(data);
+
+    PyObject *results = PyList_New(0);
+
+    for (size_t k = 0; k < collectors.size(); ++k) {
+
+        FeatureCollector *collector = collectors[k];
+
+        if (collector->hasError()) {
+            PyErr_SetString(collector->hasSpillError() ?
+                            PyExc_IOError : PyExc_ValueError,
+                            collector->getError().c_str());
+            Py_DECREF(results);
+            deleteCollectors(collectors);
+            return 0;
+        }
+
+        PyObject *result;
+        if (collector->getShape() == FeatureCollector::ListShape) {
+            result = convertFeatureList(collector->getFeatures());
+        } else {
+            result = collector->takeValues();
+        }
+        if (!result) {
+            Py_DECREF(results);
+            deleteCollectors(collectors);
+            return 0;
+        }
+
+        PyList_Append(results, result);
+        Py_DECREF(result);
+    }
+
+    deleteCollectors(collectors);
+
+    if (multiple) {
+        return results;
+    } else {
+        PyObject *result = PyList_GET_ITEM(results, 0);
+        Py_INCREF(result);
+        Py_DECREF(results);
+        return result;
+    }
+}
+
+static PyObject *
+collect_regions(PyObject *self, PyObject *args)
+{
+    PyObject *pyBuffer;
+    ssize_t output;
+    PyObject *pyRegions;
+    PyObject *pyTransforms = 0;
+
+    if (!PyArg_ParseTuple(args, "OnO|O",
+                          &pyBuffer,
+                          &output,
+                          &pyRegions,
+                          &pyTransforms)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "collect_regions() takes buffer (1D or 2D array, one row per channel), output index (int), regions (list of start and end frame pairs), and optional transforms (list) arguments");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->isInitialised || pd->stepSize == 0) {
+        PyErr_SetString(PyExc_Exception,
+                        "Plugin has not been initialised.");
+        return 0;
+    }
+
+    Plugin::OutputList ol = pd->plugin->getOutputDescriptors();
+    if (output < 0 || output >= ssize_t(ol.size())) {
+        PyErr_SetString(PyExc_Exception,
+                        "output index out of range");
+        return 0;
+    }
+
+    PyObject *seq = PySequence_Fast(pyRegions, "regions must be a sequence");
+    if (!seq) return 0;
+
+    vector<pair<size_t, size_t> > regions;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); ++i) {
+        ssize_t start, end;
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        PyObject *tuple = PySequence_Tuple(item);
+        if (!tuple || !PyArg_ParseTuple(tuple, "nn", &start, &end) ||
+            start < 0 || end < start) {
+            Py_XDECREF(tuple);
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError,
+                            "Each region must be a pair of start and end frames, with 0 <= start <= end");
+            return 0;
+        }
+        Py_DECREF(tuple);
+        regions.push_back(pair<size_t, size_t>(start, end));
+    }
+    Py_DECREF(seq);
+
+    FeatureTransform transforms;
+    if (!transforms.parse(pyTransforms)) return 0;
+
+    PyArrayObject *data = convertCollectInput(pyBuffer, pd->channels);
+    if (!data) return 0;
+
+    vector<int> outputs(1, int(output));
+    PyObject *results = PyList_New(0);
+
+    for (size_t r = 0; r < regions.size(); ++r) {
+
+        vector<FeatureCollector *> collectors;
+        collectors.push_back(new FeatureCollector(ol[output]));
+        FeatureCollector *collector = collectors[0];
+
+        if (!collector->setTransforms(transforms)) {
+            deleteCollectors(collectors);
+            Py_DECREF(results);
+            Py_DECREF(data);
+            return 0;
+        }
+
+        processArray(pd, data, regions[r].first, regions[r].second,
+                     outputs, collectors);
+
+        PyObject *result = 0;
+        if (collector->hasError()) {
+            PyErr_SetString(PyExc_ValueError, collector->getError().c_str());
+        } else if (collector->getShape() == FeatureCollector::ListShape) {
+            result = convertFeatureList(collector->getFeatures());
+        } else {
+            result = collector->takeValues();
+        }
+
+        deleteCollectors(collectors);
+
+        if (!result) {
+            Py_DECREF(results);
+            Py_DECREF(data);
+            return 0;
+        }
+
+        PyList_Append(results, result);
+        Py_DECREF(result);
+    }
+
+    Py_DECREF(data);
+    return results;
+}
+
+static PyObject *
+process_clips(PyObject *self, PyObject *args)
+{
+    PyObject *pyClips;
+    PyObject *pyOutput;
+    PyObject *pyTransforms = 0;
+    PyObject *pyOut = 0;
+    PyObject *pyOutTimes = 0;
+
+    if (!PyArg_ParseTuple(args, "OO|OOO",
+                          &pyClips,
+                          &pyOutput,
+                          &pyTransforms,
+                          &pyOut,
+                          &pyOutTimes)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "process_clips() takes clips (list of 1D or 2D arrays, one row per channel), output index (int or list of ints), and optional transforms (list), out (list with an entry per clip), and out_times (list with an entry per clip) arguments");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->isInitialised || pd->stepSize == 0) {
+        PyErr_SetString(PyExc_Exception,
+                        "Plugin has not been initialised.");
+        return 0;
+    }
+
+    bool multiple = PyList_Check(pyOutput);
+
+    Plugin::OutputList ol = pd->plugin->getOutputDescriptors();
+
+    vector<int> outputs;
+    PyObject *outputSeq = (multiple ? pyOutput : 0);
+    Py_ssize_t nOutputs = (multiple ? PyList_GET_SIZE(pyOutput) : 1);
+    for (Py_ssize_t k = 0; k < nOutputs; ++k) {
+        PyObject *item = (outputSeq ? PyList_GET_ITEM(outputSeq, k) : pyOutput);
+        Py_ssize_t output = PyNumber_AsSsize_t(item, PyExc_OverflowError);
+        if (output == -1 && PyErr_Occurred()) return 0;
+        if (output < 0 || output >= Py_ssize_t(ol.size())) {
+            PyErr_SetString(PyExc_Exception,
+                            "output index out of range");
+            return 0;
+        }
+        outputs.push_back(int(output));
+    }
+
+    FeatureTransform transforms;
+    if (!transforms.parse(pyTransforms)) return 0;
+
+    PyObject *seq = PySequence_Fast(pyClips, "clips must be a sequence");
+    if (!seq) return 0;
+    size_t nClips = PySequence_Fast_GET_SIZE(seq);
+
+    PyObject *outSpecs[2] = { pyOut, pyOutTimes };
+    for (int a = 0; a < 2; ++a) {
+        if (outSpecs[a] == Py_None) outSpecs[a] = 0;
+        if (outSpecs[a] && (!PyList_Check(outSpecs[a]) ||
+                            PyList_GET_SIZE(outSpecs[a]) != Py_ssize_t(nClips))) {
+            PyErr_SetString(PyExc_ValueError,
+                            "Out arrays for clips must be given as a list with one entry per clip");
+            Py_DECREF(seq);
+            return 0;
+        }
+    }
+
+    // Convert every clip and set up all of the collectors first, so
+    // that the clips can then be processed in one pass without the GIL
+    vector<PyArrayObject *> clips;
+    vector<FeatureCollector *> collectors;
+    bool ok = true;
+
+    for (size_t i = 0; i < nClips && ok; ++i) {
+        PyArrayObject *data =
+            convertCollectInput(PySequence_Fast_GET_ITEM(seq, i),
+                                pd->channels);
+        if (!data) {
+            ok = false;
+            break;
+        }
+        clips.push_back(data);
+        for (size_t k = 0; k < outputs.size(); ++k) {
+            FeatureCollector *collector = new FeatureCollector(ol[outputs[k]]);
+            collectors.push_back(collector);
+            if ((!multiple ||
+                 collector->getShape() != FeatureCollector::ListShape) &&
+                !collector->setTransforms(transforms)) {
+                ok = false;
+                break;
+            }
+            PyObject *out, *outTimes;
+            if (!pickOutArray(outSpecs[0] ? PyList_GET_ITEM(outSpecs[0], i) : 0,
+                              k, outputs.size(), multiple, out) ||
+                !pickOutArray(outSpecs[1] ? PyList_GET_ITEM(outSpecs[1], i) : 0,
+                              k, outputs.size(), multiple, outTimes) ||
+                !collector->setOutputArrays(out, outTimes)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    Py_DECREF(seq);
+
+    if (ok) {
+        pd->busy = true;
+        Py_BEGIN_ALLOW_THREADS
+
+        InputConditioner::FloatModeGuard guard(pd->conditioner);
+
+        for (size_t i = 0; i < clips.size(); ++i) {
+            size_t n = PyArray_DIMS(clips[i])[PyArray_NDIM(clips[i]) - 1];
+            vector<FeatureCollector *> clipCollectors
+                (collectors.begin() + i * outputs.size(),
+                 collectors.begin() + (i + 1) * outputs.size());
+            processRange(pd, (const float *)PyArray_DATA(clips[i]), n, 0, n,
+                         outputs, clipCollectors);
+        }
+
+        Py_END_ALLOW_THREADS
+        pd->busy = false;
+    }
+
+    for (size_t i = 0; i < clips.size(); ++i) {
+        Py_DECREF(clips[i]);
+    }
+
+    PyObject *results = (ok ? PyList_New(nClips) : 0);
+
+    for (size_t i = 0; results && i < nClips; ++i) {
+
+        PyObject *clipResults = PyList_New(outputs.size());
+        if (!clipResults) {
+            Py_CLEAR(results);
+            break;
+        }
+
+        for (size_t k = 0; k < outputs.size(); ++k) {
+            FeatureCollector *collector = collectors[i * outputs.size() + k];
+            PyObject *result = 0;
+            if (collector->hasError()) {
+                PyErr_SetString(PyExc_ValueError, collector->getError().c_str());
+            } else if (collector->getShape() == FeatureCollector::ListShape) {
+                result = convertFeatureList(collector->getFeatures());
+            } else {
+                result = collector->takeValues();
+            }
+            if (!result) {
+                Py_DECREF(clipResults);
+                Py_CLEAR(results);
+                break;
+            }
+            PyList_SET_ITEM(clipResults, k, result);
+        }
+        if (!results) break;
+
+        if (multiple) {
+            PyList_SET_ITEM(results, i, clipResults);
+        } else {
+            PyObject *result = PyList_GET_ITEM(clipResults, 0);
+            Py_INCREF(result);
+            Py_DECREF(clipResults);
+            PyList_SET_ITEM(results, i, result);
+        }
+    }
+
+    deleteCollectors(collectors);
+    return results;
+}
+
+static PyObject *
+attach_rolling(PyObject *self, PyObject *args)
+{
+    ssize_t output;
+    ssize_t capacity;
+    PyObject *pyTransforms = 0;
+
+    if (!PyArg_ParseTuple(args, "nn|O",
+                          &output,
+                          &capacity,
+                          &pyTransforms)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "attach_rolling() takes output index (int), capacity (int), and optional transforms (list) arguments");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    Plugin::OutputList ol = pd->plugin->getOutputDescriptors();
+    if (output < 0 || output >= int(ol.size())) {
+        PyErr_SetString(PyExc_Exception,
+                        "output index out of range");
+        return 0;
+    }
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Rolling collector capacity must be at least 1");
+        return 0;
+    }
+
+    FeatureTransform transforms;
+    if (!transforms.parse(pyTransforms)) return 0;
+
+    RollingCollector *collector =
+        new RollingCollector(ol[output], capacity, transforms);
+    if (!collector->isValid()) {
+        delete collector;
+        return 0;
+    }
+
+    if (!pd->rolling) {
+        pd->rolling = new map<int, RollingCollector *>;
+    }
+    delete (*pd->rolling)[output];
+    (*pd->rolling)[output] = collector;
+
+    Py_RETURN_TRUE;
+}
+
+static RollingCollector *
+getRolling(PyPluginObject *pd, ssize_t output)
+{
+    if (pd->rolling) {
+        map<int, RollingCollector *>::iterator i = pd->rolling->find(output);
+        if (i != pd->rolling->end()) return i->second;
+    }
+    PyErr_SetString(PyExc_ValueError,
+                    "No rolling collector is attached to this output");
+    return 0;
+}
+
+static PyObject *
+detach_rolling(PyObject *self, PyObject *args)
+{
+    ssize_t output;
+
+    if (!PyArg_ParseTuple(args, "n", &output)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "detach_rolling() takes output index (int) argument");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    RollingCollector *collector = getRolling(pd, output);
+    if (!collector) return 0;
+
+    pd->rolling->erase(output);
+    delete collector;
+
+    Py_RETURN_TRUE;
+}
+
+static PyObject *
+rolling_snapshot(PyObject *self, PyObject *args)
+{
+    ssize_t output;
+    int contiguous = 0;
+
+    if (!PyArg_ParseTuple(args, "n|i", &output, &contiguous)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "rolling_snapshot() takes output index (int) and optional contiguous (bool) arguments");
+        return 0; }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    RollingCollector *collector = getRolling(pd, output);
+    if (!collector) return 0;
+
+    if (collector->hasError()) {
+        PyErr_SetString(PyExc_ValueError, collector->getError().c_str());
+        return 0;
+    }
+
+    if (collector->getShape() == FeatureCollector::ListShape) {
+        return convertFeatureList(collector->getFeatures());
+    } else {
+        return collector->snapshot(contiguous);
+    }
+}
+
+static PyObject *
+watch_slow_blocks(PyObject *self, PyObject *args)
+{
+    double threshold = 0.0;
+    double factor = 0.0;
+    ssize_t capacity = 100;
+    PyObject *pyKeepBlocks = 0;
+
+    if (!PyArg_ParseTuple(args, "|ddnO",
+                          &threshold,
+                          &factor,
+                          &capacity,
+                          &pyKeepBlocks)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "watch_slow_blocks() takes optional threshold in seconds (float), factor (float), capacity (int), and keep_blocks (bool) arguments");
+        return 0;
+    }
+
+    if (threshold < 0.0 || factor < 0.0 || capacity < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Slow block threshold, factor, and capacity must not be negative");
+        return 0;
+    }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    delete pd->slowBlocks;
+    pd->slowBlocks = 0;
+
+    if (threshold > 0.0 || factor > 0.0) {
+        pd->slowBlocks = new SlowBlockMonitor
+            (threshold, factor, capacity,
+             pyKeepBlocks && PyObject_IsTrue(pyKeepBlocks));
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+convertSlowBlock(PyPluginObject *pd, const SlowBlockMonitor::Entry &e)
+{
+    PyObject *pyTimestamp = PyRealTime_FromRealTime(e.timestamp);
+    if (!pyTimestamp) return 0;
+
+    PyObject *dict = Py_BuildValue("{s:O,s:N,s:d,s:d,s:d,s:d,s:n,s:n}",
+                                   "plugin_key",
+                                   PyDict_GetItemString(pd->info, "pluginKey"),
+                                   "timestamp", pyTimestamp,
+                                   "duration", e.duration,
+                                   "typical", e.typical,
+                                   "peak", double(e.peak),
+                                   "rms", double(e.rms),
+                                   "non_finite", Py_ssize_t(e.nonFinite),
+                                   "denormals", Py_ssize_t(e.denormals));
+    if (!dict) return 0;
+
+    if (!e.block.empty()) {
+        npy_intp dims[2] = { npy_intp(e.channels), npy_intp(e.blockSize) };
+        PyObject *block = PyArray_SimpleNew(2, dims, NPY_FLOAT);
+        if (!block) {
+            Py_DECREF(dict);
+            return 0;
+        }
+        memcpy(PyArray_DATA((PyArrayObject *)block), &e.block[0],
+               e.block.size() * sizeof(float));
+        PyDict_SetItemString(dict, "block", block);
+        Py_DECREF(block);
+    }
+
+    return dict;
+}
+
+static PyObject *
+get_slow_blocks(PyObject *self, PyObject *args)
+{
+    PyObject *pyClear = 0;
+
+    if (!PyArg_ParseTuple(args, "|O", &pyClear)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "get_slow_blocks() takes optional clear (bool) argument");
+        return 0;
+    }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->slowBlocks) {
+        PyErr_SetString(PyExc_Exception,
+                        "Slow blocks are not being watched for this plugin.");
+        return 0;
+    }
+
+    bool clear = (!pyClear || PyObject_IsTrue(pyClear));
+    vector<SlowBlockMonitor::Entry> entries =
+        pd->slowBlocks->getEntries(clear);
+
+    PyObject *list = PyList_New(entries.size());
+    if (!list) return 0;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        PyObject *dict = convertSlowBlock(pd, entries[i]);
+        if (!dict) {
+            Py_DECREF(list);
+            return 0;
+        }
+        PyList_SET_ITEM(list, i, dict);
+    }
+
+    return list;
+}
+
+static PyObject *
+get_slow_block_stats(PyObject *self, PyObject *)
+{
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->slowBlocks) {
+        PyErr_SetString(PyExc_Exception,
+                        "Slow blocks are not being watched for this plugin.");
+        return 0;
+    }
+
+    return Py_BuildValue("{s:n,s:n,s:d}",
+                         "blocks", Py_ssize_t(pd->slowBlocks->getBlockCount()),
+                         "slow", Py_ssize_t(pd->slowBlocks->getSlowCount()),
+                         "mean_duration", pd->slowBlocks->getMeanDuration());
+}
+
+static PyObject *
+set_input_conditioning(PyObject *self, PyObject *args)
+{
+    PyObject *pyFlush = 0;
+    PyObject *pyScrub = 0;
+
+    if (!PyArg_ParseTuple(args, "|OO",
+                          &pyFlush,
+                          &pyScrub)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "set_input_conditioning() takes optional flush_denormals (bool) and scrub (bool) arguments");
+        return 0;
+    }
+
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    bool flush = (pyFlush && PyObject_IsTrue(pyFlush));
+    bool scrub = (pyScrub && PyObject_IsTrue(pyScrub));
+
+    delete pd->conditioner;
+    pd->conditioner = 0;
+
+    if (flush || scrub) {
+        pd->conditioner = new InputConditioner(flush, scrub);
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+get_input_conditioning_counts(PyObject *self, PyObject *)
+{
+    PyPluginObject *pd = getPluginObject(self);
+    if (!pd) return 0;
+
+    if (!pd->conditioner) {
+        PyErr_SetString(PyExc_Exception,
+                        "Input conditioning is not enabled for this plugin.");
+        return 0;
+    }
+
+    InputConditioner *c = pd->conditioner;
+    return Py_BuildValue("{s:n,s:n,s:n}",
+                         "blocks", Py_ssize_t(c->getBlockCount()),
+                         "non_finite", Py_ssize_t(c->getNonFiniteCount()),
+                         "denormals", Py_ssize_t(c->getDenormalCount()));
+}
+
 static PyObject *
 get_preferred_block_size(PyObject *self, PyObject *)
 {
@@ -767,6 +1831,7 @@ unload(PyObject *self, PyObject *)
 //    cerr << "unload: unloading plugin object " << pd << ", plugin " << pd->plugin << endl;
     
     delete pd->plugin;
+    deleteRolling(pd);
     pd->plugin = 0; // This is checked by getPluginObject, so we avoid
                     // blowing up if called repeatedly
 
@@ -837,6 +1902,39 @@ static PyMethodDef PyPluginObject_methods[] =
     {"get_remaining_features", get_remaining_features, METH_NOARGS,
      "get_remaining_features() -> Obtain any features extracted at the end of processing."},
 
+    {"collect", collect, METH_VARARGS,
+     "collect(buffer, output, transforms, memory_limit, spill_file, sparse, out, out_times) -> Process the whole of the given audio buffer (a 1D array, or a 2D array with one row per channel) from the start, in steps of the plugin's initialised step size, and return all of the features from the output with the given index. If output is a list of indices, all of those outputs are collected in the same single pass and a list of results is returned, one per output, with any transforms applied to those outputs that can take them and spill_file being a list with one file per output. For outputs with a fixed bin count of 1 or more, at a fixed or one-per-step sample rate and without durations, the result is a float32 NumPy array of the feature values, one row per feature; otherwise it is a list of feature dictionaries. The optional transforms list gives transforms to apply to each row of values as it is collected, in order: any of \"log\" or (\"log\", floor), \"db\" or (\"db\", floor), (\"clip\", min, max), \"l2\", \"delta\", and \"delta2\". If memory_limit is greater than zero, no more than that many bytes of values are held in memory at once, shared equally between the outputs given spill files: beyond that, they are written out to spill_file (an open, empty file object) and the array returned is mapped from that file. If sparse is true, results with more than one value per feature are instead returned in compressed sparse row form, as a tuple of data (float32), column indices and row pointer (int32) arrays and a (rows, columns) shape, keeping only the non-zero values; this cannot be combined with a memory limit. If out is given (a float32 array, or a list with one array or None per output), values are written straight into it rather than into a new array, and the result is a view of its rows that were written; it must have the dimensions of the result and at least as many rows as there are features. Likewise if out_times (a float64 array, or a list of them) is given, the timestamp of each feature in seconds is written into it. These are only for outputs returned as arrays, and cannot be combined with a memory limit or sparse collection."},
+
+    {"collect_regions", collect_regions, METH_VARARGS,
+     "collect_regions(buffer, output, regions, transforms) -> Process each of the given regions of the audio buffer (a 1D array, or a 2D array with one row per channel) separately, from a reset, and return a list of the features from the output with the given index, one result per region, in the same form as collect() returns. Each region is a pair of start and end sample frames, and the plugin sees timestamps relative to the start of the whole buffer. The optional transforms list is as for collect()."},
+
+    {"process_clips", process_clips, METH_VARARGS,
+     "process_clips(clips, output, transforms, out, out_times) -> Process each of the given clips of audio (a list of 1D arrays, or of 2D arrays with one row per channel) in turn, from a reset, as collect() processes a whole buffer, and return a list of results, one per clip, in the same form as collect() returns. All of the clips are processed in a single pass without the GIL, reusing this one initialised plugin, which makes this much quicker than loading a plugin for each of many short clips. The output and transforms arguments are as for collect(). The optional out and out_times arguments are lists with an entry per clip, each of which is as for collect()."},
+
+    {"attach_rolling", attach_rolling, METH_VARARGS,
+     "attach_rolling(output, capacity, transforms) -> Keep the most recent features (up to capacity of them) from the output with the given index, as they are returned by process_block() and get_remaining_features(), in a fixed-size ring buffer whose contents may be obtained at any time with rolling_snapshot(). Any collector already attached to the output is replaced. The optional transforms list is applied to each row of values as it arrives, as for collect(). Features are discarded when the plugin is reset."},
+
+    {"detach_rolling", detach_rolling, METH_VARARGS,
+     "detach_rolling(output) -> Stop keeping the features from the output with the given index, and release its ring buffer once no snapshot refers to it."},
+
+    {"rolling_snapshot", rolling_snapshot, METH_VARARGS,
+     "rolling_snapshot(output, contiguous) -> Return the features currently held for the output with the given index, oldest first. For outputs that collect() would return as an array, the result is either (if contiguous is True) a tuple of a float64 array of timestamps in seconds and a float32 array of values, newly allocated, or (if contiguous is False, the default) a list of one or two such tuples whose arrays are read-only views of the ring buffer itself, without copying. Views reflect further processing, so copy them if you need their contents to persist. For other outputs, the result is a list of feature dictionaries, each with a timestamp."},
+
+    {"watch_slow_blocks", watch_slow_blocks, METH_VARARGS,
+     "watch_slow_blocks(threshold, factor, capacity, keep_blocks) -> Time each block passed to the plugin by process_block(), collect(), collect_regions() and process_clips(), and log those that take longer than threshold seconds (if threshold is non-zero) or longer than factor times the running mean time of the blocks before them (if factor is non-zero), together with statistics of their input. At most capacity blocks are logged, the oldest being discarded first. If keep_blocks is True, a copy of the input of each logged block is kept too, so that it can be reproduced. Calling with neither threshold nor factor set stops watching and discards the log."},
+
+    {"get_slow_blocks", get_slow_blocks, METH_VARARGS,
+     "get_slow_blocks(clear) -> Return the blocks logged as slow since watch_slow_blocks() was called, oldest first, and remove them from the log unless clear is False. Each is a dictionary with the plugin_key, the block's timestamp (RealTime), its duration and the typical (running mean) duration in seconds, the peak and rms of its finite samples, its counts of non_finite (NaN or infinite) and denormal samples, and, if kept, the block itself as a 2D float32 array with one row per channel."},
+
+    {"get_slow_block_stats", get_slow_block_stats, METH_NOARGS,
+     "get_slow_block_stats() -> Return a dictionary of the numbers of blocks timed and found slow since watch_slow_blocks() was called, and the running mean time per block in seconds."},
+
+    {"set_input_conditioning", set_input_conditioning, METH_VARARGS,
+     "set_input_conditioning(flush_denormals, scrub) -> Condition the audio passed to the plugin by process_block(), collect(), collect_regions() and process_clips(). If flush_denormals is True, the processor is switched into flush-to-zero and denormals-are-zero mode while the plugin runs, where supported, so that denormal values arising within the plugin do not slow it down. If scrub is True, NaN, infinite and denormal input samples are replaced with zero as the input is converted to float, in the same pass. Calling with neither set turns conditioning off and discards the counts."},
+
+    {"get_input_conditioning_counts", get_input_conditioning_counts, METH_NOARGS,
+     "get_input_conditioning_counts() -> Return a dictionary of the numbers of blocks passed to the plugin and of non_finite (NaN or infinite) and denormal input samples scrubbed since set_input_conditioning() was called."},
+
     {"unload", unload, METH_NOARGS,
      "unload() -> Dispose of the plugin. You cannot use the plugin object again after calling this. Note that unloading also happens automatically when the plugin object's reference count reaches zero; this function is only necessary if you wish to ensure the native part of the plugin is disposed of before then."},
     
@@ -42,11 +42,17 @@
 #include <vamp-hostsdk/Plugin.h>
 
 #include <string>
+#include <map>
+
+class RollingCollector;
+class SlowBlockMonitor;
+class InputConditioner;
 
 struct PyPluginObject
 {
     PyObject_HEAD
     Vamp::Plugin *plugin;
+    float inputSampleRate;
     bool isInitialised;
     size_t channels;
     size_t blockSize;
@@ -55,13 +61,30 @@ struct PyPluginObject
     int inputDomain;
     PyObject *parameters;
     PyObject *programs;
+    std::map<int, RollingCollector *> *rolling;
+    Vamp::RealTime lastTimestamp;
+    bool busy; // processing without the GIL: other calls must wait
+    SlowBlockMonitor *slowBlocks;
+    InputConditioner *conditioner;
 };
 
 extern PyTypeObject Plugin_Type;
 #define PyPlugin_Check(v) PyObject_TypeCheck(v, &Plugin_Type)
 
 extern PyObject *
-PyPluginObject_From_Plugin(Vamp::Plugin *);
+PyPluginObject_From_Plugin(Vamp::Plugin *, std::string pluginKey,
+                           float inputSampleRate);
+
+/* Convert a list of features to a Python list of feature dicts, as
+   returned by process_block() */
+extern PyObject *
+convertFeatureList(const Vamp::Plugin::FeatureList &);
+
+/* Pass the features in a feature set to any rolling collectors
+   attached to their outputs, as process_block() does */
+extern void
+feedRolling(PyPluginObject *, const Vamp::Plugin::FeatureSet &,
+            const Vamp::RealTime &);
 
 #endif
 
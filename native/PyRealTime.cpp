@@ -93,8 +93,6 @@ RealTime_new(PyTypeObject *type, PyObject *args, PyObject *kw)
     // Using PyObject_New because we use PyObject_Del to delete in the
     // destructor
     RealTimeObject *self = PyObject_New(RealTimeObject, &RealTime_Type);
-    PyObject_Init((PyObject *)self, &RealTime_Type);
-        
     if (self == NULL) return NULL;
 
     self->rt = NULL;
@@ -127,6 +125,7 @@ RealTime_new(PyTypeObject *type, PyObject *args, PyObject *kw)
     if (!self->rt) { 
         PyErr_SetString(PyExc_TypeError, 
                         "RealTime initialised with wrong arguments.");
+        Py_DECREF(self);
         return NULL; 
     }
 
@@ -191,6 +190,14 @@ RealTime_float(PyObject *s)
 }
 
 
+/* Pickling support: reconstruct from the (sec, nsec) constructor */
+static PyObject *
+RealTime_reduce(RealTimeObject *self)
+{
+    return Py_BuildValue("(O(ii))", (PyObject *)&RealTime_Type,
+                         self->rt->sec, self->rt->nsec);
+}
+
 /* Type object's (RealTime) methods table */
 static PyMethodDef RealTime_methods[] = 
 {
@@ -205,6 +212,9 @@ static PyMethodDef RealTime_methods[] =
 
     {"to_float", (PyCFunction)RealTime_float,    METH_NOARGS,
      PyDoc_STR("to_float() -> Floating point representation.")},
+
+    {"__reduce__", (PyCFunction)RealTime_reduce, METH_NOARGS,
+     PyDoc_STR("__reduce__() -> Pickling support: the RealTime type and its (sec, nsec) constructor arguments.")},
         
     {NULL,              NULL}           /* sentinel */
 };
@@ -238,7 +248,10 @@ RealTime_getattro(RealTimeObject *self, PyObject *nameobj)
 #if PY_MAJOR_VERSION < 3
     name = PyString_AsString(nameobj);
 #else
-    name = PyBytes_AsString(PyUnicode_AsUTF8String(nameobj));
+    PyObject *utf8 = PyUnicode_AsUTF8String(nameobj);
+    if (!utf8) return NULL;
+    name = PyBytes_AsString(utf8);
+    Py_DECREF(utf8);
 #endif
         
     if ( !string(name).compare("sec") ) { 
@@ -258,14 +271,17 @@ static PyObject *
 RealTime_richcompare(PyObject *self, PyObject *other, int op)
 {
     if (!PyRealTime_Check(self) || !PyRealTime_Check(other)) {
-        PyErr_SetString(PyExc_TypeError, "RealTime Object Expected.");
-        return Py_False;
+        Py_INCREF(Py_NotImplemented);
+        return Py_NotImplemented;
     }
 
     RealTime *ap = PyRealTime_AS_REALTIME(self);
     RealTime *bp = PyRealTime_AS_REALTIME(other);
 
-    if (!ap || !bp) return Py_False;
+    if (!ap || !bp) {
+        PyErr_SetString(PyExc_TypeError, "RealTime Object Expected.");
+        return NULL;
+    }
     const RealTime &a = *ap;
     const RealTime &b = *bp;
 
@@ -308,9 +324,13 @@ RealTime_repr(PyObject *self)
 static PyObject *
 RealTime_add(PyObject *s, PyObject *w)
 {
+    if (!PyRealTime_Check(s) || !PyRealTime_Check(w)) {
+        Py_INCREF(Py_NotImplemented);
+        return Py_NotImplemented;
+    }
+
     RealTimeObject *result = PyObject_New(RealTimeObject, &RealTime_Type); 
     if (result == NULL) return NULL;
-    PyObject_Init((PyObject *)result, &RealTime_Type);
 
     result->rt = new RealTime(
         *((RealTimeObject*)s)->rt + *((RealTimeObject*)w)->rt);
@@ -320,9 +340,13 @@ RealTime_add(PyObject *s, PyObject *w)
 static PyObject *
 RealTime_subtract(PyObject *s, PyObject *w)
 {
+    if (!PyRealTime_Check(s) || !PyRealTime_Check(w)) {
+        Py_INCREF(Py_NotImplemented);
+        return Py_NotImplemented;
+    }
+
     RealTimeObject *result = PyObject_New(RealTimeObject, &RealTime_Type); 
     if (result == NULL) return NULL;
-    PyObject_Init((PyObject *)result, &RealTime_Type);
 
     result->rt = new RealTime(
         *((RealTimeObject*)s)->rt - *((RealTimeObject*)w)->rt);
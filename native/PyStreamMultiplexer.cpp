@@ -0,0 +1,369 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "PyStreamMultiplexer.h"
+#include "PyPluginObject.h"
+#include "StreamMultiplexer.h"
+
+// define a unique API pointer 
+#define PY_ARRAY_UNIQUE_SYMBOL VAMPYHOST_ARRAY_API
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#define NO_IMPORT_ARRAY
+#include "numpy/arrayobject.h"
+
+#include <map>
+
+using namespace std;
+using namespace Vamp;
+
+static PyObject *
+StreamMultiplexer_new(PyTypeObject *type, PyObject *args, PyObject *kw)
+{
+    int threads = 0;
+    Py_ssize_t batch = 8;
+
+    if (!PyArg_ParseTuple(args, "|in:StreamMultiplexer.new ",
+                          &threads,
+                          &batch)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "StreamMultiplexer constructor takes optional thread count (int) and batch size in blocks (int) arguments");
+        return NULL;
+    }
+
+    if (threads < 0 || batch < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Thread count must not be negative, and batch size must be at least 1");
+        return NULL;
+    }
+
+    StreamMultiplexerObject *self =
+        PyObject_New(StreamMultiplexerObject, &StreamMultiplexer_Type);
+    if (self == NULL) return NULL;
+
+    self->mux = new StreamMultiplexer(threads, batch);
+
+    return (PyObject *)self;
+}
+
+static void
+StreamMultiplexerObject_dealloc(StreamMultiplexerObject *self)
+{
+    // Waits for the workers to complete any blocks in progress
+    StreamMultiplexer *mux = self->mux;
+    Py_BEGIN_ALLOW_THREADS
+    delete mux;
+    Py_END_ALLOW_THREADS
+    PyObject_Del(self);
+}
+
+static PyObject *
+StreamMultiplexer_addStream(StreamMultiplexerObject *self, PyObject *args)
+{
+    PyObject *pyPlugin;
+    Py_ssize_t ringFrames = 0;
+    PyObject *pyOutputs = 0;
+
+    if (!PyArg_ParseTuple(args, "O|nO",
+                          &pyPlugin,
+                          &ringFrames,
+                          &pyOutputs)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "add_stream() takes plugin (vampyhost.Plugin), and optional ring size in frames (int) and outputs (list of ints) arguments");
+        return NULL;
+    }
+
+    if (!PyPlugin_Check(pyPlugin) || !((PyPluginObject *)pyPlugin)->plugin) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Plugin argument must be a loaded vampyhost.Plugin");
+        return NULL;
+    }
+
+    PyPluginObject *pd = (PyPluginObject *)pyPlugin;
+
+    if (!pd->isInitialised || pd->stepSize == 0) {
+        PyErr_SetString(PyExc_Exception,
+                        "Plugin has not been initialised.");
+        return NULL;
+    }
+    if (pd->busy) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Plugin is in use by another thread.");
+        return NULL;
+    }
+
+    vector<int> outputs;
+    if (pyOutputs && pyOutputs != Py_None) {
+        if (!PyList_Check(pyOutputs)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "Outputs must be a list of output indices");
+            return NULL;
+        }
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pyOutputs); ++i) {
+            long output = PyLong_AsLong(PyList_GET_ITEM(pyOutputs, i));
+            if (output == -1 && PyErr_Occurred()) return NULL;
+            outputs.push_back(int(output));
+        }
+    }
+
+    // The multiplexer takes over the plugin, leaving the plugin
+    // object as if it had been unloaded
+    Plugin *plugin = pd->plugin;
+    pd->plugin = 0;
+    pd->isInitialised = false;
+
+    int id = self->mux->addStream(plugin, pd->inputSampleRate,
+                                  pd->channels, pd->stepSize, pd->blockSize,
+                                  outputs, ringFrames > 0 ? ringFrames : 0);
+
+    return PyLong_FromLong(id);
+}
+
+static PyObject *
+StreamMultiplexer_push(StreamMultiplexerObject *self, PyObject *args)
+{
+    int id;
+    PyObject *pyBuffer;
+
+    if (!PyArg_ParseTuple(args, "iO",
+                          &id,
+                          &pyBuffer)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "push() takes stream id (int) and buffer (1D or 2D array, one row per channel) arguments");
+        return NULL;
+    }
+
+    size_t channels = self->mux->getChannelCount(id);
+    if (channels == 0) {
+        PyErr_SetString(PyExc_KeyError, "No such stream");
+        return NULL;
+    }
+
+    PyArrayObject *data = (PyArrayObject *)
+        PyArray_FROM_OTF(pyBuffer, NPY_FLOAT,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!data) return NULL;
+
+    int ndim = PyArray_NDIM(data);
+    if (ndim < 1 || ndim > 2 ||
+        (ndim == 1 ? 1 : size_t(PyArray_DIMS(data)[0])) != channels) {
+        PyErr_SetString(PyExc_TypeError, "Wrong number of channels");
+        Py_DECREF(data);
+        return NULL;
+    }
+
+    size_t frames = PyArray_DIMS(data)[ndim - 1];
+    long accepted = self->mux->push(id, (const float *)PyArray_DATA(data),
+                                    frames, frames);
+    Py_DECREF(data);
+
+    if (accepted < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Stream has been finished");
+        return NULL;
+    }
+
+    return PyLong_FromLong(accepted);
+}
+
+static PyObject *
+StreamMultiplexer_finish(StreamMultiplexerObject *self, PyObject *args)
+{
+    int id;
+
+    if (!PyArg_ParseTuple(args, "i", &id)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "finish() takes stream id (int) argument");
+        return NULL;
+    }
+
+    if (!self->mux->finish(id)) {
+        PyErr_SetString(PyExc_KeyError, "No such stream");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+StreamMultiplexer_poll(StreamMultiplexerObject *self, PyObject *args)
+{
+    int id;
+
+    if (!PyArg_ParseTuple(args, "i", &id)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "poll() takes stream id (int) argument");
+        return NULL;
+    }
+
+    StreamMultiplexer::FeatureQueue queue;
+    bool done = false;
+
+    if (!self->mux->poll(id, queue, done)) {
+        PyErr_SetString(PyExc_KeyError, "No such stream");
+        return NULL;
+    }
+
+    map<int, Plugin::FeatureList> byOutput;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        byOutput[queue[i].first].push_back(queue[i].second);
+    }
+
+    PyObject *pyFs = PyDict_New();
+    if (!pyFs) return NULL;
+
+    for (map<int, Plugin::FeatureList>::const_iterator i = byOutput.begin();
+         i != byOutput.end(); ++i) {
+        PyObject *pyFl = convertFeatureList(i->second);
+        PyObject *pyN = PyLong_FromLong(i->first);
+        if (!pyFl || !pyN) {
+            Py_XDECREF(pyFl);
+            Py_XDECREF(pyN);
+            Py_DECREF(pyFs);
+            return NULL;
+        }
+        PyDict_SetItem(pyFs, pyN, pyFl);
+        Py_DECREF(pyN);
+        Py_DECREF(pyFl);
+    }
+
+    return Py_BuildValue("(NO)", pyFs, done ? Py_True : Py_False);
+}
+
+static PyObject *
+StreamMultiplexer_removeStream(StreamMultiplexerObject *self, PyObject *args)
+{
+    int id;
+
+    if (!PyArg_ParseTuple(args, "i", &id)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "remove_stream() takes stream id (int) argument");
+        return NULL;
+    }
+
+    bool removed;
+    Py_BEGIN_ALLOW_THREADS
+    removed = self->mux->removeStream(id);
+    Py_END_ALLOW_THREADS
+
+    if (!removed) {
+        PyErr_SetString(PyExc_KeyError, "No such stream");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+StreamMultiplexer_stats(StreamMultiplexerObject *self)
+{
+    StreamMultiplexer::Stats stats = self->mux->getStats();
+
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}",
+                         "threads", Py_ssize_t(self->mux->getThreadCount()),
+                         "streams", Py_ssize_t(stats.streams),
+                         "blocks", Py_ssize_t(stats.blocks),
+                         "batches", Py_ssize_t(stats.batches),
+                         "dropped_frames", Py_ssize_t(stats.droppedFrames));
+}
+
+static PyMethodDef StreamMultiplexer_methods[] =
+{
+    {"add_stream", (PyCFunction)StreamMultiplexer_addStream, METH_VARARGS,
+     PyDoc_STR("add_stream(plugin, ring_frames=0, outputs=None) -> Add a stream processed by the given initialised plugin, and return its id (int). The multiplexer takes over the plugin, which can no longer be used directly. Incoming audio is held in a ring buffer of ring_frames sample frames per channel (at least two blocks). Only features from the outputs with the given indices are kept, or from all outputs if outputs is None.")},
+
+    {"push", (PyCFunction)StreamMultiplexer_push, METH_VARARGS,
+     PyDoc_STR("push(id, buffer) -> Append the audio in buffer (a 1D array, or a 2D array with one row per channel) to the stream with the given id, and return the number of sample frames accepted. This is less than the length of the buffer if the stream's ring buffer is full, in which case the rest are dropped and counted in stats().")},
+
+    {"finish", (PyCFunction)StreamMultiplexer_finish, METH_VARARGS,
+     PyDoc_STR("finish(id) -> Mark the end of the stream with the given id. Any remaining audio is processed, padded to a whole block, and followed by the plugin's remaining features.")},
+
+    {"poll", (PyCFunction)StreamMultiplexer_poll, METH_VARARGS,
+     PyDoc_STR("poll(id) -> Return a tuple of the features produced for the stream with the given id since the last poll, as a dictionary mapping output index to a list of feature dictionaries like that returned by process_block(), and a flag that is True once the stream has been finished and all of its features returned. Every feature has a timestamp: those without their own are given the timestamp of the block that produced them.")},
+
+    {"remove_stream", (PyCFunction)StreamMultiplexer_removeStream, METH_VARARGS,
+     PyDoc_STR("remove_stream(id) -> Remove the stream with the given id and dispose of its plugin, discarding any unprocessed audio and unpolled features.")},
+
+    {"stats", (PyCFunction)StreamMultiplexer_stats, METH_NOARGS,
+     PyDoc_STR("stats() -> Return a dictionary of the number of worker threads and current streams, and the total numbers of blocks processed, of batches processed, and of sample frames dropped because a stream's ring buffer was full.")},
+
+    {NULL, NULL}           /* sentinel */
+};
+
+/* Doc:: 10.3 Type Objects */ /* static */ 
+PyTypeObject StreamMultiplexer_Type = 
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "vampyhost.StreamMultiplexer",      /*tp_name*/
+    sizeof(StreamMultiplexerObject),    /*tp_basicsize*/
+    0,                                  /*tp_itemsize*/
+    (destructor)StreamMultiplexerObject_dealloc, /*tp_dealloc*/
+    0,                                  /*tp_print*/
+    0,                                  /*tp_getattr*/
+    0,                                  /*tp_setattr*/
+    0,                                  /*tp_compare*/
+    0,                                  /*tp_repr*/
+    0,                                  /*tp_as_number*/
+    0,                                  /*tp_as_sequence*/
+    0,                                  /*tp_as_mapping*/
+    0,                                  /*tp_hash*/
+    0,                                  /*tp_call*/
+    0,                                  /*tp_str*/
+    PyObject_GenericGetAttr,            /*tp_getattro*/
+    0,                                  /*tp_setattro*/
+    0,                                  /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,                 /*tp_flags*/
+    "StreamMultiplexer(threads=0, batch=8) -> Run many live audio streams, each with its own plugin, on a fixed pool of worker threads (one per hardware thread if threads is 0). Each stream's audio is pushed into its own ring buffer, and whenever a whole block is ready the stream is queued for the workers, which take streams in turn and process up to batch blocks of one before moving on to the next. Processing happens in the background, without the GIL; features are collected from each stream with poll().", /*tp_doc*/
+    0,                                  /*tp_traverse*/
+    0,                                  /*tp_clear*/
+    0,                                  /*tp_richcompare*/
+    0,                                  /*tp_weaklistoffset*/
+    0,                                  /*tp_iter*/
+    0,                                  /*tp_iternext*/
+    StreamMultiplexer_methods,          /*tp_methods*/
+    0,                                  /*tp_members*/
+    0,                                  /*tp_getset*/
+    0,                                  /*tp_base*/
+    0,                                  /*tp_dict*/
+    0,                                  /*tp_descr_get*/
+    0,                                  /*tp_descr_set*/
+    0,                                  /*tp_dictoffset*/
+    0,                                  /*tp_init*/
+    0,                                  /*tp_alloc*/
+    StreamMultiplexer_new,              /*tp_new*/
+    0,                                  /*tp_free*/
+    0,                                  /*tp_is_gc*/
+};
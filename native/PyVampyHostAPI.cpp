@@ -0,0 +1,389 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#define VAMPYHOST_API_IMPLEMENTATION
+#include "VampyHostAPI.h"
+#include "PyVampyHostAPI.h"
+#include "PyPluginObject.h"
+#include "InputConditioner.h"
+#include "SlowBlockMonitor.h"
+
+#include <vector>
+
+using namespace std;
+using namespace Vamp;
+
+// A VampyHostPlugin is never defined: it is the PyPluginObject itself
+static PyPluginObject *
+object(VampyHostPlugin *plugin)
+{
+    return (PyPluginObject *)plugin;
+}
+
+static const PyPluginObject *
+object(const VampyHostPlugin *plugin)
+{
+    return (const PyPluginObject *)plugin;
+}
+
+static PyObject *
+api_loadPlugin(const char *pluginKey, float sampleRate, int adapterFlags)
+{
+    PyObject *module = PyImport_ImportModule("vampyhost");
+    if (!module) return 0;
+    PyObject *plugin = PyObject_CallMethod(module, (char *)"load_plugin",
+                                           (char *)"sfi", pluginKey,
+                                           sampleRate, adapterFlags);
+    Py_DECREF(module);
+    return plugin;
+}
+
+static VampyHostPlugin *
+api_getPlugin(PyObject *plugin)
+{
+    if (!PyPlugin_Check(plugin) || !((PyPluginObject *)plugin)->plugin) {
+        PyErr_SetString(PyExc_AttributeError,
+                        "Invalid or already deleted plugin handle.");
+        return 0;
+    }
+    return (VampyHostPlugin *)plugin;
+}
+
+static int
+api_acquire(VampyHostPlugin *plugin)
+{
+    PyPluginObject *pd = object(plugin);
+    if (!pd->plugin) {
+        PyErr_SetString(PyExc_AttributeError,
+                        "Invalid or already deleted plugin handle.");
+        return -1;
+    }
+    if (pd->busy) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Plugin is in use by another thread.");
+        return -1;
+    }
+    if (!pd->isInitialised) {
+        PyErr_SetString(PyExc_Exception,
+                        "Plugin has not been initialised.");
+        return -1;
+    }
+    pd->busy = true;
+    return 0;
+}
+
+static void
+api_release(VampyHostPlugin *plugin)
+{
+    object(plugin)->busy = false;
+}
+
+static int
+api_getChannelCount(const VampyHostPlugin *plugin)
+{
+    return int(object(plugin)->channels);
+}
+
+static size_t
+api_getStepSize(const VampyHostPlugin *plugin)
+{
+    return object(plugin)->stepSize;
+}
+
+static size_t
+api_getBlockSize(const VampyHostPlugin *plugin)
+{
+    return object(plugin)->blockSize;
+}
+
+static int
+api_getOutputCount(const VampyHostPlugin *plugin)
+{
+    return int(object(plugin)->plugin->getOutputDescriptors().size());
+}
+
+static int
+api_getOutputBinCount(const VampyHostPlugin *plugin, int output)
+{
+    Plugin::OutputList outputs =
+        object(plugin)->plugin->getOutputDescriptors();
+    if (output < 0 || output >= int(outputs.size()) ||
+        !outputs[output].hasFixedBinCount) {
+        return -1;
+    }
+    return int(outputs[output].binCount);
+}
+
+static void
+deliver(const Plugin::FeatureSet &fs,
+        VampyHostFeatureCallback callback, void *context)
+{
+    if (!callback) return;
+    for (Plugin::FeatureSet::const_iterator i = fs.begin();
+         i != fs.end(); ++i) {
+        for (size_t j = 0; j < i->second.size(); ++j) {
+            const Plugin::Feature &f = i->second[j];
+            VampyHostFeature vf;
+            vf.output = i->first;
+            vf.hasTimestamp = f.hasTimestamp;
+            vf.sec = f.timestamp.sec;
+            vf.nsec = f.timestamp.nsec;
+            vf.hasDuration = f.hasDuration;
+            vf.durationSec = f.duration.sec;
+            vf.durationNsec = f.duration.nsec;
+            vf.values = (f.values.empty() ? 0 : &f.values[0]);
+            vf.valueCount = f.values.size();
+            vf.label = f.label.c_str();
+            callback(context, &vf);
+        }
+    }
+}
+
+// Run one block through the plugin, with the input conditioning,
+// slow-block monitoring and rolling collection that process_block()
+// applies
+static Plugin::FeatureSet
+processBlock(PyPluginObject *pd, const float *const *input,
+             const RealTime &timestamp)
+{
+    int channels = pd->channels;
+
+    // Scrubbing needs a copy, as the input belongs to the caller
+    vector<vector<float> > scrubbed;
+    vector<const float *> inbuf(input, input + channels);
+    if (pd->conditioner && pd->conditioner->scrubs()) {
+        scrubbed.resize(channels);
+        for (int c = 0; c < channels; ++c) {
+            scrubbed[c].resize(pd->blockSize);
+            pd->conditioner->convert(input[c], &scrubbed[c][0],
+                                     pd->blockSize);
+            inbuf[c] = &scrubbed[c][0];
+        }
+    }
+
+    double started = (pd->slowBlocks ? SlowBlockMonitor::now() : 0.0);
+    Plugin::FeatureSet fs;
+    {
+        InputConditioner::FloatModeGuard guard(pd->conditioner);
+        fs = pd->plugin->process(&inbuf[0], timestamp);
+    }
+    if (pd->conditioner) pd->conditioner->addBlock();
+    if (pd->slowBlocks) {
+        pd->slowBlocks->check(&inbuf[0], channels, pd->blockSize, timestamp,
+                              SlowBlockMonitor::now() - started);
+    }
+
+    pd->lastTimestamp = timestamp;
+    feedRolling(pd, fs, timestamp);
+    return fs;
+}
+
+static Plugin::FeatureSet
+remainingFeatures(PyPluginObject *pd)
+{
+    Plugin::FeatureSet fs = pd->plugin->getRemainingFeatures();
+
+    // Remaining features belong after the last block processed
+    feedRolling(pd, fs, pd->lastTimestamp +
+                RealTime::frame2RealTime(pd->stepSize, pd->inputSampleRate));
+    return fs;
+}
+
+static int
+api_process(VampyHostPlugin *plugin, const float *const *input,
+            int sec, int nsec,
+            VampyHostFeatureCallback callback, void *context)
+{
+    PyPluginObject *pd = object(plugin);
+    if (!pd->busy) return VAMPYHOST_ERROR_NOT_ACQUIRED;
+    deliver(processBlock(pd, input, RealTime(sec, nsec)), callback, context);
+    return VAMPYHOST_OK;
+}
+
+static int
+api_getRemainingFeatures(VampyHostPlugin *plugin,
+                         VampyHostFeatureCallback callback, void *context)
+{
+    PyPluginObject *pd = object(plugin);
+    if (!pd->busy) return VAMPYHOST_ERROR_NOT_ACQUIRED;
+    deliver(remainingFeatures(pd), callback, context);
+    return VAMPYHOST_OK;
+}
+
+static double
+toSeconds(const RealTime &rt)
+{
+    return rt.sec + double(rt.nsec) / 1000000000.0;
+}
+
+// Write the features of one output into the caller's rows, timed as
+// FeatureCollector times them
+struct ColumnWriter
+{
+    const Plugin::OutputDescriptor &desc;
+    size_t width;
+    float *values;
+    double *times;
+    size_t rows;
+    size_t count;
+    double lastTime;
+    int error;
+
+    ColumnWriter(const Plugin::OutputDescriptor &d, float *v, double *t,
+                 size_t r) :
+        desc(d), width(d.binCount), values(v), times(t), rows(r),
+        count(0), lastTime(0.0), error(VAMPYHOST_OK) { }
+
+    void add(const Plugin::FeatureList &fl, const RealTime &blockTimestamp) {
+        for (size_t i = 0; i < fl.size() && error == VAMPYHOST_OK; ++i) {
+            const Plugin::Feature &f = fl[i];
+            if (f.values.size() != width) {
+                error = VAMPYHOST_ERROR_WRONG_WIDTH;
+            } else if (count == rows) {
+                error = VAMPYHOST_ERROR_OUT_OF_SPACE;
+            } else {
+                double t;
+                if (desc.sampleType ==
+                    Plugin::OutputDescriptor::OneSamplePerStep) {
+                    t = toSeconds(blockTimestamp);
+                } else if (f.hasTimestamp) {
+                    t = toSeconds(f.timestamp);
+                } else if (count > 0 && desc.sampleRate > 0.f) {
+                    t = lastTime + 1.0 / desc.sampleRate;
+                } else {
+                    t = toSeconds(blockTimestamp);
+                }
+                lastTime = t;
+                if (width > 0) {
+                    copy(f.values.begin(), f.values.end(),
+                         values + count * width);
+                }
+                if (times) times[count] = t;
+                ++count;
+            }
+        }
+    }
+};
+
+static int
+api_collect(VampyHostPlugin *plugin, const float *const *input,
+            size_t frames, int output,
+            float *values, double *times, size_t rows,
+            size_t *written)
+{
+    PyPluginObject *pd = object(plugin);
+    if (written) *written = 0;
+    if (!pd->busy) return VAMPYHOST_ERROR_NOT_ACQUIRED;
+
+    Plugin::OutputList outputs = pd->plugin->getOutputDescriptors();
+    if (output < 0 || output >= int(outputs.size())) {
+        return VAMPYHOST_ERROR_NO_SUCH_OUTPUT;
+    }
+    if (!outputs[output].hasFixedBinCount ||
+        (outputs[output].binCount > 0 && !values)) {
+        return VAMPYHOST_ERROR_WRONG_WIDTH;
+    }
+
+    ColumnWriter writer(outputs[output], values, times, rows);
+
+    int channels = pd->channels;
+    size_t blockSize = pd->blockSize;
+    size_t stepSize = pd->stepSize;
+
+    vector<vector<float> > padded;
+    vector<const float *> inbuf(channels);
+
+    pd->plugin->reset();
+
+    size_t next = 0;
+
+    for (size_t i = 0; i < frames; i += stepSize) {
+
+        if (i + blockSize <= frames) {
+            for (int c = 0; c < channels; ++c) {
+                inbuf[c] = input[c] + i;
+            }
+        } else {
+            padded.resize(channels);
+            for (int c = 0; c < channels; ++c) {
+                padded[c].assign(blockSize, 0.f);
+                copy(input[c] + i, input[c] + frames, padded[c].begin());
+                inbuf[c] = &padded[c][0];
+            }
+        }
+
+        RealTime timestamp = RealTime::frame2RealTime(i, pd->inputSampleRate);
+        Plugin::FeatureSet fs = processBlock(pd, &inbuf[0], timestamp);
+        Plugin::FeatureSet::const_iterator fi = fs.find(output);
+        if (fi != fs.end()) writer.add(fi->second, timestamp);
+
+        next = i + stepSize;
+    }
+
+    Plugin::FeatureSet fs = remainingFeatures(pd);
+    Plugin::FeatureSet::const_iterator fi = fs.find(output);
+    if (fi != fs.end()) {
+        writer.add(fi->second,
+                   RealTime::frame2RealTime(next, pd->inputSampleRate));
+    }
+
+    if (written) *written = writer.count;
+    return writer.error;
+}
+
+static VampyHostAPI api = {
+    VAMPYHOST_API_VERSION,
+    sizeof(VampyHostAPI),
+    api_loadPlugin,
+    api_getPlugin,
+    api_acquire,
+    api_release,
+    api_getChannelCount,
+    api_getStepSize,
+    api_getBlockSize,
+    api_getOutputCount,
+    api_getOutputBinCount,
+    api_process,
+    api_getRemainingFeatures,
+    api_collect
+};
+
+PyObject *
+PyVampyHostAPI_NewCapsule()
+{
+    return PyCapsule_New(&api, VAMPYHOST_API_CAPSULE_NAME, 0);
+}
@@ -0,0 +1,308 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "RollingCollector.h"
+
+// define a unique API pointer 
+#define PY_ARRAY_UNIQUE_SYMBOL VAMPYHOST_ARRAY_API
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#define NO_IMPORT_ARRAY
+#include "numpy/arrayobject.h"
+
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+using namespace Vamp;
+
+static const char *ringCapsuleName = "vampyhost.RollingCollector.ring";
+
+static double
+toSeconds(const RealTime &rt)
+{
+    return rt.sec + double(rt.nsec) / 1000000000.0;
+}
+
+RollingCollector::RollingCollector(const Plugin::OutputDescriptor &desc,
+                                   size_t capacity,
+                                   const FeatureTransform &transforms) :
+    m_shape(FeatureCollector::deduceShape(desc)),
+    m_sampleType(desc.sampleType),
+    m_sampleRate(desc.sampleRate),
+    m_bins(0),
+    m_width(0),
+    m_capacity(capacity),
+    m_head(0),
+    m_count(0),
+    m_total(0),
+    m_lastTime(0.0),
+    m_transforms(transforms),
+    m_capsule(0),
+    m_ring(0)
+{
+    if (m_shape == FeatureCollector::ListShape) {
+        if (!m_transforms.empty()) {
+            PyErr_SetString(PyExc_ValueError,
+                            "Transforms can only be applied to outputs with vector or matrix shape");
+            return;
+        }
+    } else {
+        m_bins = desc.binCount;
+        m_width = m_transforms.getOutputWidth(m_bins);
+    }
+    m_transforms.reset();
+
+    // The ring is allocated once, at its full size, and never
+    // reallocated: views handed out by snapshot() refer to it
+    // directly, and keep it alive through the capsule
+    Ring *ring = new Ring;
+    if (m_shape == FeatureCollector::ListShape) {
+        ring->features.resize(m_capacity);
+    } else {
+        ring->times.resize(m_capacity);
+        ring->values.resize(m_capacity * m_width);
+    }
+
+    m_capsule = PyCapsule_New(ring, ringCapsuleName, deleteRing);
+    if (!m_capsule) {
+        delete ring;
+        return;
+    }
+    m_ring = ring;
+}
+
+RollingCollector::~RollingCollector()
+{
+    Py_XDECREF(m_capsule);
+}
+
+void
+RollingCollector::deleteRing(PyObject *capsule)
+{
+    delete (Ring *)PyCapsule_GetPointer(capsule, ringCapsuleName);
+}
+
+bool
+RollingCollector::isValid() const
+{
+    return m_ring != 0;
+}
+
+void
+RollingCollector::clear()
+{
+    m_head = 0;
+    m_count = 0;
+    m_total = 0;
+    m_lastTime = 0.0;
+    m_transforms.reset();
+}
+
+void
+RollingCollector::add(const Plugin::FeatureList &features,
+                      const RealTime &blockTimestamp)
+{
+    if (m_capacity == 0) return;
+
+    for (size_t i = 0; i < features.size(); ++i) {
+
+        const Plugin::Feature &f = features[i];
+
+        double t;
+        if (m_sampleType == Plugin::OutputDescriptor::OneSamplePerStep) {
+            t = toSeconds(blockTimestamp);
+        } else if (f.hasTimestamp) {
+            t = toSeconds(f.timestamp);
+        } else if (m_sampleType == Plugin::OutputDescriptor::FixedSampleRate &&
+                   m_total > 0 && m_sampleRate > 0.f) {
+            t = m_lastTime + 1.0 / m_sampleRate;
+        } else {
+            t = toSeconds(blockTimestamp);
+        }
+
+        if (m_shape == FeatureCollector::ListShape) {
+            Plugin::Feature &g = m_ring->features[m_head];
+            g = f;
+            g.hasTimestamp = true;
+            g.timestamp = RealTime::fromSeconds(t);
+        } else {
+            const vector<float> &v = f.values;
+            if (v.size() != m_bins) {
+                if (m_error.empty()) {
+                    ostringstream os;
+                    os << "Feature " << m_total << " has " << v.size()
+                       << " values, but output has bin count " << m_bins;
+                    m_error = os.str();
+                }
+                continue;
+            }
+            float *row = &m_ring->values[m_head * m_width];
+            if (m_transforms.empty()) {
+                for (size_t j = 0; j < m_bins; ++j) {
+                    row[j] = v[j];
+                }
+            } else {
+                m_transforms.apply(&v[0], m_bins, row);
+            }
+            m_ring->times[m_head] = t;
+        }
+
+        m_lastTime = t;
+        ++m_total;
+        if (++m_head == m_capacity) m_head = 0;
+        if (m_count < m_capacity) ++m_count;
+    }
+}
+
+PyObject *
+RollingCollector::makeSegment(size_t start, size_t rows) const
+{
+    npy_intp dims[2];
+    dims[0] = rows;
+    dims[1] = m_width;
+    int ndim = (m_width == 1 ? 1 : 2);
+
+    PyObject *times = PyArray_SimpleNewFromData
+        (1, dims, NPY_DOUBLE, (void *)(m_ring->times.data() + start));
+    PyObject *values = PyArray_SimpleNewFromData
+        (ndim, dims, NPY_FLOAT, (void *)(m_ring->values.data() + start * m_width));
+
+    if (!times || !values) {
+        Py_XDECREF(times);
+        Py_XDECREF(values);
+        return 0;
+    }
+
+    PyObject *arrays[2] = { times, values };
+    for (int i = 0; i < 2; ++i) {
+        PyArray_CLEARFLAGS((PyArrayObject *)arrays[i], NPY_ARRAY_WRITEABLE);
+        Py_INCREF(m_capsule);
+        if (PyArray_SetBaseObject((PyArrayObject *)arrays[i], m_capsule) < 0) {
+            Py_DECREF(times);
+            Py_DECREF(values);
+            return 0;
+        }
+    }
+
+    PyObject *segment = PyTuple_New(2);
+    PyTuple_SET_ITEM(segment, 0, times);
+    PyTuple_SET_ITEM(segment, 1, values);
+    return segment;
+}
+
+PyObject *
+RollingCollector::copyAll() const
+{
+    npy_intp dims[2];
+    dims[0] = m_count;
+    dims[1] = m_width;
+    int ndim = (m_width == 1 ? 1 : 2);
+
+    PyObject *times = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
+    PyObject *values = PyArray_SimpleNew(ndim, dims, NPY_FLOAT);
+
+    if (!times || !values) {
+        Py_XDECREF(times);
+        Py_XDECREF(values);
+        return 0;
+    }
+
+    double *tout = (double *)PyArray_DATA((PyArrayObject *)times);
+    float *vout = (float *)PyArray_DATA((PyArrayObject *)values);
+
+    size_t start = (m_count < m_capacity ? 0 : m_head);
+    size_t first = min(m_count, m_capacity - start);
+    size_t second = m_count - first;
+
+    if (first > 0) {
+        memcpy(tout, &m_ring->times[start], first * sizeof(double));
+        memcpy(vout, &m_ring->values[start * m_width],
+               first * m_width * sizeof(float));
+    }
+    if (second > 0) {
+        memcpy(tout + first, &m_ring->times[0], second * sizeof(double));
+        memcpy(vout + first * m_width, &m_ring->values[0],
+               second * m_width * sizeof(float));
+    }
+
+    PyObject *result = PyTuple_New(2);
+    PyTuple_SET_ITEM(result, 0, times);
+    PyTuple_SET_ITEM(result, 1, values);
+    return result;
+}
+
+PyObject *
+RollingCollector::snapshot(bool contiguous) const
+{
+    if (contiguous) return copyAll();
+
+    PyObject *segments = PyList_New(0);
+    if (!segments) return 0;
+
+    // Oldest first: if the ring has wrapped, the oldest feature is
+    // the one about to be overwritten, at the head
+    size_t start = (m_count < m_capacity ? 0 : m_head);
+    size_t first = min(m_count, m_capacity - start);
+    size_t second = m_count - first;
+
+    size_t starts[2] = { start, 0 };
+    size_t rows[2] = { first, second };
+
+    for (int i = 0; i < 2; ++i) {
+        if (rows[i] == 0 && (i > 0 || m_count > 0)) continue;
+        PyObject *segment = makeSegment(starts[i], rows[i]);
+        if (!segment) {
+            Py_DECREF(segments);
+            return 0;
+        }
+        PyList_Append(segments, segment);
+        Py_DECREF(segment);
+    }
+
+    return segments;
+}
+
+Plugin::FeatureList
+RollingCollector::getFeatures() const
+{
+    Plugin::FeatureList features;
+    size_t start = (m_count < m_capacity ? 0 : m_head);
+    for (size_t i = 0; i < m_count; ++i) {
+        features.push_back(m_ring->features[(start + i) % m_capacity]);
+    }
+    return features;
+}
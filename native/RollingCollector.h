@@ -0,0 +1,158 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  RollingCollector: Keep the most recent features returned through a
+  single plugin output, in a fixed-capacity ring buffer, for live
+  streams where only the last few seconds of each output are of
+  interest. Dense outputs are stored as rows of values with a
+  timestamp per row, and can be viewed without copying.
+*/
+
+#ifndef VAMPYHOST_ROLLING_COLLECTOR_H
+#define VAMPYHOST_ROLLING_COLLECTOR_H
+
+#include <Python.h>
+#include <vamp-hostsdk/Plugin.h>
+
+#include "FeatureCollector.h"
+#include "FeatureTransform.h"
+
+#include <vector>
+#include <string>
+
+class RollingCollector
+{
+public:
+    /**
+     * Construct a collector holding up to capacity features from the
+     * output with the given descriptor, applying the given transform
+     * pipeline to each row of values as it is collected (as for
+     * FeatureCollector::setTransforms). Must be called with the GIL
+     * held. Check isValid() afterwards: if the transforms cannot be
+     * applied to this output or the storage could not be allocated,
+     * a Python exception has been set.
+     */
+    RollingCollector(const Vamp::Plugin::OutputDescriptor &desc,
+                     size_t capacity,
+                     const FeatureTransform &transforms);
+
+    /**
+     * Must be called with the GIL held.
+     */
+    ~RollingCollector();
+
+    bool isValid() const;
+
+    FeatureCollector::Shape getShape() const { return m_shape; }
+
+    size_t getCapacity() const { return m_capacity; }
+    size_t getWidth() const { return m_width; }
+
+    /**
+     * Return the number of features currently held, at most the
+     * capacity.
+     */
+    size_t getCount() const { return m_count; }
+
+    /**
+     * Add a list of features returned from the process call for the
+     * block with the given timestamp, overwriting the oldest features
+     * if the buffer is full. Features with no timestamp of their own
+     * are timed as vamp.collect would time them.
+     */
+    void add(const Vamp::Plugin::FeatureList &features,
+             const Vamp::RealTime &blockTimestamp);
+
+    /**
+     * Discard all features held, e.g. on plugin reset.
+     */
+    void clear();
+
+    bool hasError() const { return !m_error.empty(); }
+    std::string getError() const { return m_error; }
+
+    /**
+     * For the vector and matrix shapes, return the features held, in
+     * order from oldest to newest, as Python objects. If contiguous
+     * is true, the result is a tuple of a float64 array of
+     * timestamps in seconds and a float32 array of values (1D for
+     * one value per feature, else 2D), both newly allocated. If
+     * contiguous is false, the result is a list of one or two such
+     * tuples, whose arrays are read-only views onto the ring buffer
+     * itself: their contents will change as further features arrive.
+     */
+    PyObject *snapshot(bool contiguous) const;
+
+    /**
+     * For the list shape, return the features held, oldest first,
+     * each with its timestamp set.
+     */
+    Vamp::Plugin::FeatureList getFeatures() const;
+
+private:
+    struct Ring {
+        std::vector<double> times;
+        std::vector<float> values;
+        Vamp::Plugin::FeatureList features;
+    };
+
+    FeatureCollector::Shape m_shape;
+    Vamp::Plugin::OutputDescriptor::SampleType m_sampleType;
+    float m_sampleRate;
+    size_t m_bins;
+    size_t m_width;
+    size_t m_capacity;
+    size_t m_head;
+    size_t m_count;
+    size_t m_total;
+    double m_lastTime;
+    FeatureTransform m_transforms;
+    PyObject *m_capsule; // owns m_ring, shared with any views
+    Ring *m_ring;
+    std::string m_error;
+
+    static void deleteRing(PyObject *capsule);
+
+    PyObject *makeSegment(size_t start, size_t rows) const;
+    PyObject *copyAll() const;
+
+    RollingCollector(const RollingCollector &); // not provided
+    RollingCollector &operator=(const RollingCollector &); // not provided
+};
+
+#endif
@@ -0,0 +1,136 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "SegmentPooling.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+bool
+SegmentPooling::methodFromName(string name, Method &method)
+{
+    if (name == "mean") method = Mean;
+    else if (name == "min") method = Min;
+    else if (name == "max") method = Max;
+    else if (name == "sum") method = Sum;
+    else if (name == "std") method = StdDev;
+    else return false;
+    return true;
+}
+
+void
+SegmentPooling::pool(const float *matrix, size_t nrows, size_t ncols,
+                     double step,
+                     const double *starts, const double *ends, size_t nsegs,
+                     Method method,
+                     float *out)
+{
+    // Accumulate in double: long segments of large values lose too
+    // much precision in float sums
+    vector<double> acc(ncols), acc2(ncols);
+
+    for (size_t s = 0; s < nsegs; ++s) {
+
+        float *orow = out + s * ncols;
+
+        double first = floor(starts[s] / step);
+        double last = ceil(ends[s] / step) - 1;
+        if (first < 0) first = 0;
+        if (last < first) last = first;
+        if (last >= double(nrows)) last = double(nrows) - 1;
+
+        if (nrows == 0 || first >= double(nrows)) {
+            for (size_t c = 0; c < ncols; ++c) {
+                orow[c] = numeric_limits<float>::quiet_NaN();
+            }
+            continue;
+        }
+
+        size_t r0 = size_t(first), r1 = size_t(last);
+        size_t n = r1 - r0 + 1;
+        const float *row = matrix + r0 * ncols;
+
+        if (method == Min || method == Max) {
+            for (size_t c = 0; c < ncols; ++c) {
+                orow[c] = row[c];
+            }
+            for (size_t r = 1; r < n; ++r) {
+                row += ncols;
+                if (method == Min) {
+                    for (size_t c = 0; c < ncols; ++c) {
+                        if (row[c] < orow[c]) orow[c] = row[c];
+                    }
+                } else {
+                    for (size_t c = 0; c < ncols; ++c) {
+                        if (row[c] > orow[c]) orow[c] = row[c];
+                    }
+                }
+            }
+            continue;
+        }
+
+        for (size_t c = 0; c < ncols; ++c) {
+            acc[c] = 0.0;
+            acc2[c] = 0.0;
+        }
+        for (size_t r = 0; r < n; ++r) {
+            for (size_t c = 0; c < ncols; ++c) {
+                acc[c] += row[c];
+            }
+            if (method == StdDev) {
+                for (size_t c = 0; c < ncols; ++c) {
+                    acc2[c] += double(row[c]) * row[c];
+                }
+            }
+            row += ncols;
+        }
+
+        for (size_t c = 0; c < ncols; ++c) {
+            if (method == Sum) {
+                orow[c] = float(acc[c]);
+            } else if (method == Mean) {
+                orow[c] = float(acc[c] / n);
+            } else {
+                double mean = acc[c] / n;
+                double var = acc2[c] / n - mean * mean;
+                orow[c] = float(var > 0.0 ? sqrt(var) : 0.0);
+            }
+        }
+    }
+}
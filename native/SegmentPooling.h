@@ -0,0 +1,79 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  SegmentPooling: Summarise the rows of a dense feature matrix over
+  a sequence of time segments, e.g. chroma averaged per beat.
+*/
+
+#ifndef VAMPYHOST_SEGMENT_POOLING_H
+#define VAMPYHOST_SEGMENT_POOLING_H
+
+#include <vector>
+#include <string>
+
+class SegmentPooling
+{
+public:
+    enum Method { Mean, Min, Max, Sum, StdDev };
+
+    /**
+     * Look up a pooling method by name ("mean", "min", "max", "sum"
+     * or "std"). Return false if the name is not recognised.
+     */
+    static bool methodFromName(std::string name, Method &method);
+
+    /**
+     * Pool the rows of a row-major matrix of nrows x ncols values,
+     * whose rows are spaced step seconds apart, over each of the
+     * nsegs segments [starts[i], ends[i]). Each segment takes in
+     * every row whose time span overlaps it, or the single row
+     * containing its start time if it is shorter than one step.
+     * Write nsegs x ncols pooled values to out; any segment lying
+     * entirely beyond the end of the matrix receives NaN values.
+     *
+     * Segments are visited in order and rows are read in a single
+     * forward pass when the segments are sorted and do not overlap.
+     */
+    static void pool(const float *matrix, size_t nrows, size_t ncols,
+                     double step,
+                     const double *starts, const double *ends, size_t nsegs,
+                     Method method,
+                     float *out);
+};
+
+#endif
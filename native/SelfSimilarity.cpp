@@ -0,0 +1,318 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "SelfSimilarity.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAMPYHOST_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Rows per tile edge. Two tiles of rows are compared against each
+// other at a time, so that both stay in cache for typical feature
+// widths (up to a few hundred bins)
+static const size_t tileSize = 64;
+
+static uint16_t
+floatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t mantissa = x & 0x007fffff;
+    int exponent = int((x >> 23) & 0xff);
+
+    if (exponent == 0xff) { // infinity or NaN
+        return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+
+    int e = exponent - 127 + 15;
+
+    if (e >= 0x1f) { // too large, becomes infinity
+        return uint16_t(sign | 0x7c00);
+    }
+
+    if (e <= 0) { // subnormal in half precision, or zero
+        if (e < -10) return uint16_t(sign);
+        mantissa |= 0x00800000;
+        int shift = 14 - e;
+        uint32_t h = mantissa >> shift;
+        uint32_t rem = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1))) ++h;
+        return uint16_t(sign | h);
+    }
+
+    uint32_t h = (uint32_t(e) << 10) | (mantissa >> 13);
+    uint32_t rem = mantissa & 0x1fff;
+    // round to nearest even; a carry out of the mantissa correctly
+    // increments the exponent
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+    return uint16_t(sign | h);
+}
+
+bool
+SelfSimilarity::metricFromName(string name, Metric &metric)
+{
+    if (name == "cosine") metric = Cosine;
+    else if (name == "euclidean") metric = Euclidean;
+    else return false;
+    return true;
+}
+
+SelfSimilarity::SelfSimilarity(const float *matrix, size_t nrows, size_t ncols,
+                               Metric metric) :
+    m_matrix(matrix),
+    m_nrows(nrows),
+    m_ncols(ncols),
+    m_metric(metric),
+    m_normalised(0)
+{
+    if (m_metric == Cosine) {
+        m_normalised = new float[nrows * ncols];
+        for (size_t i = 0; i < nrows; ++i) {
+            const float *row = matrix + i * ncols;
+            float *nrow = m_normalised + i * ncols;
+            double sum = 0.0;
+            for (size_t c = 0; c < ncols; ++c) {
+                sum += double(row[c]) * row[c];
+            }
+            float scale = (sum > 0.0 ? float(1.0 / sqrt(sum)) : 0.f);
+            for (size_t c = 0; c < ncols; ++c) {
+                nrow[c] = row[c] * scale;
+            }
+        }
+    }
+}
+
+SelfSimilarity::~SelfSimilarity()
+{
+    delete[] m_normalised;
+}
+
+// Sum of the four lanes of a vector
+#ifdef VAMPYHOST_SSE2
+static inline float
+horizontalSum(__m128 v)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+#endif
+
+static float
+dotProduct(const float *a, const float *b, size_t n)
+{
+    float sum = 0.f;
+    size_t c = 0;
+#ifdef VAMPYHOST_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; c + 4 <= n; c += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + c),
+                                         _mm_loadu_ps(b + c)));
+    }
+    sum = horizontalSum(acc);
+#endif
+    for (; c < n; ++c) {
+        sum += a[c] * b[c];
+    }
+    return sum;
+}
+
+static float
+squaredDistance(const float *a, const float *b, size_t n)
+{
+    float sum = 0.f;
+    size_t c = 0;
+#ifdef VAMPYHOST_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; c + 4 <= n; c += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + c), _mm_loadu_ps(b + c));
+        acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+    sum = horizontalSum(acc);
+#endif
+    for (; c < n; ++c) {
+        float d = a[c] - b[c];
+        sum += d * d;
+    }
+    return sum;
+}
+
+float
+SelfSimilarity::value(size_t i, size_t j) const
+{
+    const size_t n = m_ncols;
+    if (m_metric == Cosine) {
+        return dotProduct(m_normalised + i * n, m_normalised + j * n, n);
+    } else {
+        return sqrtf(squaredDistance(m_matrix + i * n, m_matrix + j * n, n));
+    }
+}
+
+struct SelfSimilarity::Job
+{
+    const SelfSimilarity *ss;
+    void *out;
+    bool full;
+    bool half;
+    size_t band;
+    size_t ntiles;
+    atomic<size_t> *next;
+};
+
+static inline float
+identity(float f)
+{
+    return f;
+}
+
+// Fill the rows of one tile, writing elements of type T through
+// convert. Separate instances for float and float16 output keep the
+// choice of format out of the inner loops
+template <typename T, T (*convert)(float)>
+void
+SelfSimilarity::fillTile(T *out, bool full, size_t band,
+                         size_t i0, size_t i1) const
+{
+    const size_t n = m_nrows;
+    if (full) {
+        for (size_t j0 = i0; j0 < n; j0 += tileSize) {
+            size_t j1 = min(n, j0 + tileSize);
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = max(i, j0); j < j1; ++j) {
+                    T v = convert(value(i, j));
+                    out[i * n + j] = v;
+                    if (i != j) out[j * n + i] = v;
+                }
+            }
+        }
+    } else {
+        const size_t w = band + 1;
+        for (size_t i = i0; i < i1; ++i) {
+            for (size_t k = 0; k < w; ++k) {
+                out[i * w + k] = convert(i + k < n ?
+                                         value(i, i + k) :
+                                         numeric_limits<float>::quiet_NaN());
+            }
+        }
+    }
+}
+
+void
+SelfSimilarity::runJob(Job *job)
+{
+    const SelfSimilarity *ss = job->ss;
+    const size_t n = ss->m_nrows;
+
+    // Tiles of rows are handed out to threads in turn. For the full
+    // matrix, each tile of rows is compared with itself and with all
+    // later tiles, and the results mirrored; the earlier tiles have
+    // more work, so are taken first
+
+    while (true) {
+
+        size_t t = (*job->next)++;
+        if (t >= job->ntiles) break;
+
+        size_t i0 = t * tileSize;
+        size_t i1 = min(n, i0 + tileSize);
+
+        if (job->half) {
+            ss->fillTile<uint16_t, floatToHalf>
+                ((uint16_t *)job->out, job->full, job->band, i0, i1);
+        } else {
+            ss->fillTile<float, identity>
+                ((float *)job->out, job->full, job->band, i0, i1);
+        }
+    }
+}
+
+void
+SelfSimilarity::run(void *out, bool full, size_t band, bool half, int threads)
+{
+    atomic<size_t> next(0);
+
+    Job job;
+    job.ss = this;
+    job.out = out;
+    job.full = full;
+    job.half = half;
+    job.band = band;
+    job.ntiles = (m_nrows + tileSize - 1) / tileSize;
+    job.next = &next;
+
+    if (threads <= 0) {
+        threads = int(thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    if (size_t(threads) > job.ntiles) threads = int(job.ntiles);
+
+    vector<thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.push_back(thread(runJob, &job));
+    }
+    runJob(&job);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+}
+
+void
+SelfSimilarity::computeFull(void *out, bool half, int threads)
+{
+    run(out, true, 0, half, threads);
+}
+
+void
+SelfSimilarity::computeBanded(void *out, size_t band, bool half, int threads)
+{
+    run(out, false, band, half, threads);
+}
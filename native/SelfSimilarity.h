@@ -0,0 +1,104 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  SelfSimilarity: Cosine similarity or Euclidean distance between
+  every pair of rows of a feature matrix, computed in cache-sized
+  tiles across a number of threads.
+*/
+
+#ifndef VAMPYHOST_SELF_SIMILARITY_H
+#define VAMPYHOST_SELF_SIMILARITY_H
+
+#include <string>
+#include <cstddef>
+
+class SelfSimilarity
+{
+public:
+    enum Metric { Cosine, Euclidean };
+
+    /**
+     * Look up a metric by name ("cosine" or "euclidean"). Return
+     * false if the name is not recognised.
+     */
+    static bool metricFromName(std::string name, Metric &metric);
+
+    /**
+     * Construct for a row-major matrix of nrows x ncols values. The
+     * matrix must remain valid for the lifetime of this object.
+     */
+    SelfSimilarity(const float *matrix, size_t nrows, size_t ncols,
+                   Metric metric);
+    ~SelfSimilarity();
+
+    /**
+     * Compute the full nrows x nrows matrix, writing float values to
+     * out (if half is false) or IEEE half-precision values to out (if
+     * half is true). If threads is 0, use one thread per core.
+     */
+    void computeFull(void *out, bool half, int threads);
+
+    /**
+     * Compute only the values within band rows of the diagonal,
+     * writing an nrows x (band + 1) matrix to out in which element
+     * [i][k] holds the value for rows i and i + k. Elements for which
+     * i + k lies beyond the last row are set to NaN.
+     */
+    void computeBanded(void *out, size_t band, bool half, int threads);
+
+private:
+    const float *m_matrix;
+    size_t m_nrows;
+    size_t m_ncols;
+    Metric m_metric;
+    float *m_normalised; // unit-norm rows, for cosine metric
+
+    float value(size_t i, size_t j) const;
+
+    template <typename T, T (*convert)(float)>
+    void fillTile(T *out, bool full, size_t band, size_t i0, size_t i1) const;
+
+    struct Job;
+    static void runJob(Job *);
+    void run(void *out, bool full, size_t band, bool half, int threads);
+
+    SelfSimilarity(const SelfSimilarity &); // not provided
+    SelfSimilarity &operator=(const SelfSimilarity &); // not provided
+};
+
+#endif
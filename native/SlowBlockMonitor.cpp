@@ -0,0 +1,156 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "SlowBlockMonitor.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+using namespace Vamp;
+
+// The running mean is not trusted for relative thresholds until this
+// many blocks have been timed, so that the first few blocks (which
+// are often slower, as caches and allocations warm up) are not all
+// flagged
+static const size_t warmUpBlocks = 8;
+
+// Weight of each new block in the running mean, once warmed up
+static const double meanWeight = 1.0 / 64.0;
+
+SlowBlockMonitor::SlowBlockMonitor(double threshold, double factor,
+                                   size_t capacity, bool keepBlocks) :
+    m_threshold(threshold),
+    m_factor(factor),
+    m_capacity(capacity),
+    m_keepBlocks(keepBlocks),
+    m_blocks(0),
+    m_slow(0),
+    m_mean(0.0)
+{
+}
+
+double
+SlowBlockMonitor::now()
+{
+    return chrono::duration<double>
+        (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool
+SlowBlockMonitor::check(const float *const *input, size_t channels,
+                        size_t blockSize, const RealTime &timestamp,
+                        double duration)
+{
+    ++m_blocks;
+
+    bool warm = (m_blocks > warmUpBlocks);
+    bool slow = ((m_threshold > 0.0 && duration > m_threshold) ||
+                 (m_factor > 0.0 && warm && duration > m_factor * m_mean));
+
+    if (!slow) {
+        // Slow blocks are left out of the mean, so that one outlier
+        // does not hide those that follow it
+        if (m_blocks <= warmUpBlocks) {
+            m_mean += (duration - m_mean) / double(m_blocks);
+        } else {
+            m_mean += (duration - m_mean) * meanWeight;
+        }
+        return false;
+    }
+
+    ++m_slow;
+
+    Entry e;
+    e.timestamp = timestamp;
+    e.duration = duration;
+    e.typical = (warm ? m_mean : 0.0);
+    e.nonFinite = 0;
+    e.denormals = 0;
+    e.channels = channels;
+    e.blockSize = blockSize;
+
+    float peak = 0.f;
+    double sum = 0.0;
+    size_t finite = 0;
+    for (size_t c = 0; c < channels; ++c) {
+        for (size_t i = 0; i < blockSize; ++i) {
+            float v = input[c][i];
+            switch (fpclassify(v)) {
+            case FP_NAN:
+            case FP_INFINITE:
+                ++e.nonFinite;
+                continue;
+            case FP_SUBNORMAL:
+                ++e.denormals;
+                break;
+            default:
+                break;
+            }
+            float a = fabsf(v);
+            if (a > peak) peak = a;
+            sum += double(v) * v;
+            ++finite;
+        }
+    }
+    e.peak = peak;
+    e.rms = (finite > 0 ? float(sqrt(sum / double(finite))) : 0.f);
+
+    if (m_keepBlocks) {
+        e.block.resize(channels * blockSize);
+        for (size_t c = 0; c < channels; ++c) {
+            for (size_t i = 0; i < blockSize; ++i) {
+                e.block[c * blockSize + i] = input[c][i];
+            }
+        }
+    }
+
+    if (m_capacity == 0) return true;
+    while (m_entries.size() >= m_capacity) {
+        m_entries.pop_front();
+    }
+    m_entries.push_back(e);
+    return true;
+}
+
+vector<SlowBlockMonitor::Entry>
+SlowBlockMonitor::getEntries(bool clear)
+{
+    vector<Entry> entries(m_entries.begin(), m_entries.end());
+    if (clear) m_entries.clear();
+    return entries;
+}
@@ -0,0 +1,118 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  SlowBlockMonitor: Time each block a plugin processes, and keep a
+  bounded log of those that take much longer than they should, with
+  statistics of the input that caused them (and optionally a copy of
+  the input itself), so that pathological audio can be found and
+  reproduced.
+*/
+
+#ifndef VAMPYHOST_SLOW_BLOCK_MONITOR_H
+#define VAMPYHOST_SLOW_BLOCK_MONITOR_H
+
+#include <vamp-hostsdk/RealTime.h>
+
+#include <deque>
+#include <vector>
+#include <string>
+
+class SlowBlockMonitor
+{
+public:
+    struct Entry {
+        Vamp::RealTime timestamp;
+        double duration;        // seconds
+        double typical;         // running mean duration at the time, or 0
+        float peak;             // of the finite samples
+        float rms;              // of the finite samples
+        size_t nonFinite;       // NaN and infinite samples
+        size_t denormals;
+        size_t channels;
+        size_t blockSize;
+        std::vector<float> block; // channels * blockSize, if kept
+    };
+
+    /**
+     * Construct a monitor that flags blocks taking longer than
+     * threshold seconds (if threshold is non-zero) or longer than
+     * factor times the running mean duration of unflagged blocks (if
+     * factor is non-zero), keeping at most capacity entries with the
+     * oldest discarded first. If keepBlocks is true, each entry also
+     * holds a copy of the block's input. Does not use Python, and may
+     * be used without the GIL.
+     */
+    SlowBlockMonitor(double threshold, double factor,
+                     size_t capacity, bool keepBlocks);
+
+    /**
+     * Record that processing the block with the given input and
+     * timestamp took the given number of seconds, and log it if it
+     * is slow. Return true if it was logged.
+     */
+    bool check(const float *const *input, size_t channels,
+               size_t blockSize, const Vamp::RealTime &timestamp,
+               double duration);
+
+    /**
+     * Return the logged entries, oldest first, and remove them from
+     * the log if clear is true.
+     */
+    std::vector<Entry> getEntries(bool clear);
+
+    size_t getBlockCount() const { return m_blocks; }
+    size_t getSlowCount() const { return m_slow; }
+    double getMeanDuration() const { return m_mean; }
+
+    /**
+     * Return the monotonic time in seconds, for timing blocks.
+     */
+    static double now();
+
+private:
+    double m_threshold;
+    double m_factor;
+    size_t m_capacity;
+    bool m_keepBlocks;
+    size_t m_blocks;
+    size_t m_slow;
+    double m_mean;
+    std::deque<Entry> m_entries;
+};
+
+#endif
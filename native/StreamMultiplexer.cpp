@@ -0,0 +1,429 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#include "StreamMultiplexer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace Vamp;
+
+struct StreamMultiplexer::Stream
+{
+    int id;
+    Plugin *plugin;
+    float sampleRate;
+    size_t channels;
+    size_t stepSize;
+    size_t blockSize;
+    vector<bool> keep;      // by output index; empty to keep all
+    vector<float> ring;     // channels * capacity, one channel after another
+    size_t capacity;        // in frames
+    uint64_t readPos;       // frame at which the next block starts
+    uint64_t writePos;      // frames pushed so far
+    bool finishing;
+    bool done;
+    bool scheduled;
+    bool processing;
+    bool removed;
+    FeatureQueue features;
+    vector<float> scratch;  // one block, for blocks that wrap or are padded
+};
+
+StreamMultiplexer::StreamMultiplexer(int threads, size_t batchBlocks) :
+    m_batchBlocks(max(batchBlocks, size_t(1))),
+    m_stopping(false),
+    m_nextId(1)
+{
+    if (threads <= 0) {
+        threads = int(thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    for (int i = 0; i < threads; ++i) {
+        m_workers.push_back(thread(&StreamMultiplexer::run, this));
+    }
+}
+
+StreamMultiplexer::~StreamMultiplexer()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i].join();
+    }
+    for (map<int, Stream *>::iterator i = m_streams.begin();
+         i != m_streams.end(); ++i) {
+        delete i->second->plugin;
+        delete i->second;
+    }
+}
+
+int
+StreamMultiplexer::addStream(Plugin *plugin, float sampleRate,
+                             size_t channels, size_t stepSize,
+                             size_t blockSize, const vector<int> &outputs,
+                             size_t ringFrames)
+{
+    Stream *s = new Stream;
+    s->plugin = plugin;
+    s->sampleRate = sampleRate;
+    s->channels = channels;
+    s->stepSize = stepSize;
+    s->blockSize = blockSize;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (outputs[i] < 0) continue;
+        if (size_t(outputs[i]) >= s->keep.size()) {
+            s->keep.resize(outputs[i] + 1, false);
+        }
+        s->keep[outputs[i]] = true;
+    }
+    s->capacity = max(ringFrames, blockSize * 2);
+    s->ring.resize(channels * s->capacity, 0.f);
+    s->readPos = 0;
+    s->writePos = 0;
+    s->finishing = false;
+    s->done = false;
+    s->scheduled = false;
+    s->processing = false;
+    s->removed = false;
+    s->scratch.resize(channels * blockSize, 0.f);
+
+    lock_guard<mutex> lock(m_mutex);
+    s->id = m_nextId++;
+    m_streams[s->id] = s;
+    return s->id;
+}
+
+StreamMultiplexer::Stream *
+StreamMultiplexer::findStream(int id) const
+{
+    map<int, Stream *>::const_iterator i = m_streams.find(id);
+    if (i == m_streams.end()) return 0;
+    return i->second;
+}
+
+size_t
+StreamMultiplexer::getChannelCount(int id) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    Stream *s = findStream(id);
+    return s ? s->channels : 0;
+}
+
+bool
+StreamMultiplexer::isReady(const Stream *s) const
+{
+    if (s->scheduled || s->processing || s->done || s->removed) {
+        return false;
+    }
+    return s->finishing || (s->writePos >= s->readPos + s->blockSize);
+}
+
+// Frames written but not yet read. When the step size is larger than
+// the block size, readPos runs ahead of writePos after each block,
+// and there is nothing to read until the gap has been pushed.
+static size_t
+available(uint64_t readPos, uint64_t writePos)
+{
+    return writePos > readPos ? size_t(writePos - readPos) : 0;
+}
+
+void
+StreamMultiplexer::schedule(Stream *s)
+{
+    s->scheduled = true;
+    m_queue.push_back(s);
+    m_ready.notify_one();
+}
+
+long
+StreamMultiplexer::push(int id, const float *data, size_t frames,
+                        size_t stride)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Stream *s = findStream(id);
+    if (!s || s->finishing) return -1;
+
+    // Frames falling between blocks, when the step is larger than
+    // the block, are never read and so are skipped rather than stored
+    size_t skip = 0;
+    if (s->readPos > s->writePos) {
+        skip = size_t(min(uint64_t(frames), s->readPos - s->writePos));
+        s->writePos += skip;
+        data += skip;
+        frames -= skip;
+    }
+
+    // Only the free part of the ring is written, which no worker
+    // reads from, so this is safe while the stream is processing
+    size_t used = available(s->readPos, s->writePos);
+    size_t n = min(frames, s->capacity - used);
+    size_t offset = size_t(s->writePos % s->capacity);
+    size_t first = min(n, s->capacity - offset);
+
+    for (size_t c = 0; c < s->channels; ++c) {
+        float *ring = &s->ring[c * s->capacity];
+        const float *src = data + c * stride;
+        if (first > 0) {
+            memcpy(ring + offset, src, first * sizeof(float));
+        }
+        if (n > first) {
+            memcpy(ring, src + first, (n - first) * sizeof(float));
+        }
+    }
+
+    s->writePos += n;
+    m_stats.droppedFrames += frames - n;
+
+    if (isReady(s)) schedule(s);
+    return long(skip + n);
+}
+
+bool
+StreamMultiplexer::finish(int id)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Stream *s = findStream(id);
+    if (!s) return false;
+
+    if (!s->finishing) {
+        s->finishing = true;
+        if (isReady(s)) schedule(s);
+    }
+    return true;
+}
+
+bool
+StreamMultiplexer::poll(int id, FeatureQueue &out, bool &done)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Stream *s = findStream(id);
+    if (!s) return false;
+
+    out.insert(out.end(), s->features.begin(), s->features.end());
+    s->features.clear();
+    done = s->done;
+    return true;
+}
+
+bool
+StreamMultiplexer::removeStream(int id)
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    Stream *s = findStream(id);
+    if (!s) return false;
+
+    m_streams.erase(id);
+    s->removed = true;
+
+    while (s->processing) {
+        m_idle.wait(lock);
+    }
+    if (s->scheduled) {
+        m_queue.erase(find(m_queue.begin(), m_queue.end(), s));
+    }
+
+    lock.unlock();
+
+    delete s->plugin;
+    delete s;
+    return true;
+}
+
+StreamMultiplexer::Stats
+StreamMultiplexer::getStats() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.streams = m_streams.size();
+    return stats;
+}
+
+void
+StreamMultiplexer::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    while (true) {
+
+        while (!m_stopping && m_queue.empty()) {
+            m_ready.wait(lock);
+        }
+        if (m_stopping) return;
+
+        // Streams are served in the order they became ready, and go
+        // to the back of the queue after each batch
+        Stream *s = m_queue.front();
+        m_queue.pop_front();
+        s->scheduled = false;
+        s->processing = true;
+
+        size_t frames = available(s->readPos, s->writePos);
+        size_t blocks = 0;
+        if (frames >= s->blockSize) {
+            blocks = min(m_batchBlocks,
+                         1 + (frames - s->blockSize) / s->stepSize);
+        }
+        bool finishing = (s->finishing && blocks == 0);
+
+        lock.unlock();
+        blocks = process(s, blocks, finishing);
+        lock.lock();
+
+        s->processing = false;
+        m_stats.blocks += blocks;
+        m_stats.batches += 1;
+
+        if (isReady(s)) schedule(s);
+        m_idle.notify_all();
+    }
+}
+
+// Copy up to one block of frames from the ring starting at pos,
+// padding with silence, into the scratch buffer. Return pointers to
+// the block's channels, which point into the ring itself if the
+// block is complete and does not wrap.
+static void
+gather(const vector<float> &ring, size_t capacity, size_t channels,
+       uint64_t pos, size_t frames, size_t blockSize,
+       vector<float> &scratch, vector<const float *> &inbuf)
+{
+    size_t offset = size_t(pos % capacity);
+
+    if (frames == blockSize && offset + blockSize <= capacity) {
+        for (size_t c = 0; c < channels; ++c) {
+            inbuf[c] = &ring[c * capacity + offset];
+        }
+        return;
+    }
+
+    size_t first = min(frames, capacity - offset);
+
+    for (size_t c = 0; c < channels; ++c) {
+        float *dst = &scratch[c * blockSize];
+        const float *src = &ring[c * capacity];
+        memcpy(dst, src + offset, first * sizeof(float));
+        if (frames > first) {
+            memcpy(dst + first, src, (frames - first) * sizeof(float));
+        }
+        fill(dst + frames, dst + blockSize, 0.f);
+        inbuf[c] = dst;
+    }
+}
+
+static void
+appendFeatures(const Plugin::FeatureSet &fs, const vector<bool> &keep,
+               const RealTime &timestamp,
+               StreamMultiplexer::FeatureQueue &out)
+{
+    for (Plugin::FeatureSet::const_iterator i = fs.begin();
+         i != fs.end(); ++i) {
+
+        int output = i->first;
+        if (!keep.empty() &&
+            (output < 0 || size_t(output) >= keep.size() || !keep[output])) {
+            continue;
+        }
+
+        for (size_t j = 0; j < i->second.size(); ++j) {
+            out.push_back(pair<int, Plugin::Feature>(output, i->second[j]));
+            Plugin::Feature &f = out.back().second;
+            if (!f.hasTimestamp) {
+                f.hasTimestamp = true;
+                f.timestamp = timestamp;
+            }
+        }
+    }
+}
+
+size_t
+StreamMultiplexer::process(Stream *s, size_t blocks, bool finishing)
+{
+    // Called without the lock. The positions are only changed by the
+    // worker processing the stream, and the part of the ring from
+    // readPos to writePos is not written by push()
+    uint64_t pos;
+    uint64_t end;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        pos = s->readPos;
+        end = s->writePos;
+    }
+
+    vector<const float *> inbuf(s->channels);
+    FeatureQueue out;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        gather(s->ring, s->capacity, s->channels, pos, s->blockSize,
+               s->blockSize, s->scratch, inbuf);
+        RealTime timestamp = RealTime::frame2RealTime(pos, s->sampleRate);
+        appendFeatures(s->plugin->process(&inbuf[0], timestamp),
+                       s->keep, timestamp, out);
+        pos += s->stepSize;
+    }
+
+    if (finishing) {
+        while (pos < end) {
+            ++blocks;
+            size_t frames = size_t(min(uint64_t(s->blockSize), end - pos));
+            gather(s->ring, s->capacity, s->channels, pos, frames,
+                   s->blockSize, s->scratch, inbuf);
+            RealTime timestamp = RealTime::frame2RealTime(pos, s->sampleRate);
+            appendFeatures(s->plugin->process(&inbuf[0], timestamp),
+                           s->keep, timestamp, out);
+            pos += s->stepSize;
+        }
+        appendFeatures(s->plugin->getRemainingFeatures(), s->keep,
+                       RealTime::frame2RealTime(end, s->sampleRate), out);
+        pos = end;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    s->readPos = pos;
+    s->features.insert(s->features.end(), out.begin(), out.end());
+    if (finishing) s->done = true;
+
+    return blocks;
+}
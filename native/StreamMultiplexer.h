@@ -0,0 +1,175 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  StreamMultiplexer: Run many live streams, each with its own plugin
+  instance, on a small fixed pool of worker threads. Audio for each
+  stream is pushed into its own ring buffer; whenever a stream has
+  a whole block ready, it joins a queue from which the workers take
+  streams in turn, processing up to a batch of blocks of one stream
+  at a time before moving on to the next. Features go to a queue per
+  stream, from which they are polled.
+
+  None of this touches Python objects, so it runs without the GIL.
+*/
+
+#ifndef VAMPYHOST_STREAM_MULTIPLEXER_H
+#define VAMPYHOST_STREAM_MULTIPLEXER_H
+
+#include <vamp-hostsdk/Plugin.h>
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+class StreamMultiplexer
+{
+public:
+    /**
+     * Features as queued for a stream: the index of the output each
+     * came from, and the feature itself.
+     */
+    typedef std::vector<std::pair<int, Vamp::Plugin::Feature> > FeatureQueue;
+
+    struct Stats {
+        Stats() : streams(0), blocks(0), batches(0), droppedFrames(0) { }
+        size_t streams;
+        size_t blocks;
+        size_t batches;
+        size_t droppedFrames;
+    };
+
+    /**
+     * Construct with the given number of worker threads (0 for one
+     * per hardware thread), each of which processes up to batchBlocks
+     * blocks of a stream before moving on to the next stream.
+     */
+    StreamMultiplexer(int threads, size_t batchBlocks);
+
+    /**
+     * Stop the workers and delete all remaining streams and their
+     * plugins. Blocks being processed are completed first.
+     */
+    ~StreamMultiplexer();
+
+    /**
+     * Add a stream, taking ownership of the given plugin, which must
+     * already have been initialised with the given channel count,
+     * step size and block size. Only features from the given outputs
+     * are queued (or all outputs, if outputs is empty). The ring
+     * buffer holds ringFrames sample frames per channel, and is
+     * enlarged to hold at least two blocks. Return the stream's id.
+     */
+    int addStream(Vamp::Plugin *plugin, float sampleRate,
+                  size_t channels, size_t stepSize, size_t blockSize,
+                  const std::vector<int> &outputs, size_t ringFrames);
+
+    /**
+     * Return the channel count of the given stream, or 0 if there
+     * is no such stream.
+     */
+    size_t getChannelCount(int id) const;
+
+    /**
+     * Append audio to a stream. The data holds the given number of
+     * frames for each of the stream's channels, with each channel
+     * starting stride values after the previous one. Return the
+     * number of frames accepted, which is less than requested if the
+     * ring buffer is full: the remainder is dropped. Frames that fall
+     * between blocks, when the step size is larger than the block
+     * size, are accepted but not stored. Return -1 if there is no such
+     * stream or it has been finished.
+     */
+    long push(int id, const float *data, size_t frames, size_t stride);
+
+    /**
+     * Mark the end of a stream. Any audio remaining is processed,
+     * padded with silence to a whole block, followed by the plugin's
+     * remaining features. Return false if there is no such stream.
+     */
+    bool finish(int id);
+
+    /**
+     * Move the features queued for a stream into the end of out.
+     * Features without a timestamp of their own are given that of
+     * the block that produced them. On return, done is true if the
+     * stream has been finished and all of its features have been
+     * returned. Return false if there is no such stream.
+     */
+    bool poll(int id, FeatureQueue &out, bool &done);
+
+    /**
+     * Remove a stream and delete its plugin, waiting for any batch
+     * in progress for it to complete. Return false if there is no
+     * such stream.
+     */
+    bool removeStream(int id);
+
+    Stats getStats() const;
+
+    size_t getThreadCount() const { return m_workers.size(); }
+
+private:
+    struct Stream;
+
+    size_t m_batchBlocks;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_idle;
+    std::deque<Stream *> m_queue;
+    std::map<int, Stream *> m_streams;
+    std::vector<std::thread> m_workers;
+    bool m_stopping;
+    int m_nextId;
+    Stats m_stats;
+
+    Stream *findStream(int id) const;
+    bool isReady(const Stream *s) const;
+    void schedule(Stream *s);
+    void run();
+    size_t process(Stream *s, size_t blocks, bool finishing); // returns blocks processed
+
+    StreamMultiplexer(const StreamMultiplexer &); // not provided
+    StreamMultiplexer &operator=(const StreamMultiplexer &); // not provided
+};
+
+#endif
@@ -69,8 +69,10 @@ public:
 	PyObject *uobj = PyUnicode_AsUTF8String(obj);
 	if (!uobj) return std::string();
 	char *cstr = PyBytes_AsString(uobj);
-	if (!cstr) return std::string();
-	else return cstr;
+	std::string s;
+	if (cstr) s = cstr;
+	Py_DECREF(uobj);
+	return s;
 #endif
     }
 };
@@ -0,0 +1,200 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    VampyHost
+
+    Use Vamp audio analysis plugins in Python
+
+    Gyorgy Fazekas and Chris Cannam
+    Centre for Digital Music, Queen Mary, University of London
+    Copyright 2008-2015 Queen Mary, University of London
+  
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and the authors
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+  VampyHostAPI: C interface to vampyhost for other native extensions.
+
+  vampyhost exports a table of functions through a capsule named
+  "vampyhost._C_API", so that another extension (an audio decoder,
+  say) can run plugins on its own float buffers and receive features
+  through callbacks or into its own arrays, with no Python objects
+  made per block. To use it, include this header (from C or C++) in
+  one source file of the extension and call import_vampyhost() from
+  its module initialisation function, after which the table is
+  available as VampyHost_API:
+
+      if (import_vampyhost() < 0) return NULL;
+
+      PyObject *plugin = VampyHost_API->loadPlugin
+          ("vamp-example-plugins:zerocrossing", 44100.f, 0);
+      ... call plugin.initialise() etc through Python as usual ...
+      VampyHostPlugin *p = VampyHost_API->getPlugin(plugin);
+      if (VampyHost_API->acquire(p) < 0) ...;
+      Py_BEGIN_ALLOW_THREADS
+      VampyHost_API->process(p, channels, sec, nsec, callback, context);
+      ...
+      Py_END_ALLOW_THREADS
+      VampyHost_API->release(p);
+
+  Loading and configuring a plugin, and acquire() and release(), need
+  the GIL. Between acquire() and release() the plugin belongs to the
+  caller: its process functions may be called from any one thread at
+  a time without the GIL, and Python calls on the plugin object fail
+  as they do during vampyhost's own GIL-free processing. The caller
+  must hold a reference to the plugin object throughout.
+
+  The table is versioned. Functions are only ever added at the end,
+  with VAMPYHOST_API_VERSION incremented, so an extension built
+  against an older header works with a newer vampyhost; an
+  incompatible change would be made under a new capsule name.
+*/
+
+#ifndef VAMPYHOST_API_H
+#define VAMPYHOST_API_H
+
+#include <Python.h>
+#include <stddef.h>
+
+#define VAMPYHOST_API_VERSION 1
+#define VAMPYHOST_API_CAPSULE_NAME "vampyhost._C_API"
+
+/* Return codes of the GIL-free functions */
+enum {
+    VAMPYHOST_OK = 0,
+    VAMPYHOST_ERROR_NOT_ACQUIRED = 1,   /* acquire() was not called */
+    VAMPYHOST_ERROR_NO_SUCH_OUTPUT = 2,
+    VAMPYHOST_ERROR_WRONG_WIDTH = 3,    /* a feature had the wrong value count */
+    VAMPYHOST_ERROR_OUT_OF_SPACE = 4    /* more features than rows */
+};
+
+/* The native side of a vampyhost.Plugin object */
+typedef struct VampyHostPlugin VampyHostPlugin;
+
+/* A feature, as passed to a callback. Its pointers are valid only for
+   the duration of the callback. */
+typedef struct {
+    int output;                 /* output index */
+    int hasTimestamp;
+    int sec, nsec;              /* timestamp, as a Vamp RealTime */
+    int hasDuration;
+    int durationSec, durationNsec;
+    const float *values;
+    size_t valueCount;
+    const char *label;          /* never NULL, but may be empty */
+} VampyHostFeature;
+
+typedef void (*VampyHostFeatureCallback)(void *context,
+                                         const VampyHostFeature *feature);
+
+typedef struct {
+
+    unsigned int version;       /* VAMPYHOST_API_VERSION of the provider */
+    size_t size;                /* sizeof this table in the provider */
+
+    /* Load a plugin as vampyhost.load_plugin() does, returning a new
+       reference to a vampyhost.Plugin object, or NULL with an
+       exception set. Needs the GIL. */
+    PyObject *(*loadPlugin)(const char *pluginKey, float sampleRate,
+                            int adapterFlags);
+
+    /* Return the native plugin of a vampyhost.Plugin object, valid
+       while the object lives, or NULL with an exception set if it is
+       not a loaded plugin. Needs the GIL. */
+    VampyHostPlugin *(*getPlugin)(PyObject *plugin);
+
+    /* Take the plugin for GIL-free use, returning 0, or -1 with an
+       exception set if it is not initialised or is in use. Release
+       it again with release(). Both need the GIL. */
+    int (*acquire)(VampyHostPlugin *plugin);
+    void (*release)(VampyHostPlugin *plugin);
+
+    /* Properties of an initialised plugin. These, and the functions
+       following, do not use Python and need not hold the GIL. */
+    int (*getChannelCount)(const VampyHostPlugin *plugin);
+    size_t (*getStepSize)(const VampyHostPlugin *plugin);
+    size_t (*getBlockSize)(const VampyHostPlugin *plugin);
+    int (*getOutputCount)(const VampyHostPlugin *plugin);
+
+    /* Return the fixed number of values in each feature of an
+       output, or -1 if it varies or the output does not exist. */
+    int (*getOutputBinCount)(const VampyHostPlugin *plugin, int output);
+
+    /* Process one block, of getChannelCount() pointers to
+       getBlockSize() samples each, with the given timestamp, and pass
+       each feature returned to the callback (which may be NULL). As
+       process_block() does, this applies any input conditioning and
+       slow-block monitoring set on the plugin, and feeds any attached
+       rolling collectors. */
+    int (*process)(VampyHostPlugin *plugin, const float *const *input,
+                   int sec, int nsec,
+                   VampyHostFeatureCallback callback, void *context);
+
+    /* Pass each of the plugin's remaining features to the callback. */
+    int (*getRemainingFeatures)(VampyHostPlugin *plugin,
+                                VampyHostFeatureCallback callback,
+                                void *context);
+
+    /* Reset the plugin and process the whole of a planar buffer of
+       getChannelCount() pointers to frames samples each, starting a
+       block every step (the last padded with zeros), followed by the
+       remaining features, as Plugin.collect() does. Features from the
+       given output are written as rows of getOutputBinCount() values
+       to values (which may be NULL if that count is zero), and their
+       times in seconds to times (which may be NULL), up to rows of
+       them. The number of rows written goes to written. */
+    int (*collect)(VampyHostPlugin *plugin, const float *const *input,
+                   size_t frames, int output,
+                   float *values, double *times, size_t rows,
+                   size_t *written);
+
+} VampyHostAPI;
+
+#ifndef VAMPYHOST_API_IMPLEMENTATION
+
+static VampyHostAPI *VampyHost_API = NULL;
+
+/* Import the vampyhost C API into VampyHost_API, returning 0, or -1
+   with an exception set if vampyhost cannot be imported or is older
+   than this header. */
+static int
+import_vampyhost(void)
+{
+    VampyHostAPI *api = (VampyHostAPI *)
+        PyCapsule_Import(VAMPYHOST_API_CAPSULE_NAME, 0);
+    if (!api) return -1;
+    if (api->version < VAMPYHOST_API_VERSION) {
+        PyErr_SetString(PyExc_ImportError,
+                        "vampyhost C API is older than this extension requires");
+        return -1;
+    }
+    VampyHost_API = api;
+    return 0;
+}
+
+#endif
+
+#endif
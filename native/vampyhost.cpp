@@ -45,6 +45,10 @@
 
 #include "PyRealTime.h"
 #include "PyPluginObject.h"
+#include "PyAdmissionControl.h"
+#include "PyStreamMultiplexer.h"
+#include "PyVampyHostAPI.h"
+#include "PyFilePrefetcher.h"
 
 #include "vamp-hostsdk/PluginHostAdapter.h"
 #include "vamp-hostsdk/PluginChannelAdapter.h"
@@ -54,11 +58,17 @@
 #include "VectorConversion.h"
 #include "StringConversion.h"
 #include "PyRealTime.h"
+#include "SegmentPooling.h"
+#include "SelfSimilarity.h"
+#include "FeatureWriter.h"
+#include "PluginDiscovery.h"
+#include "AdmissionControl.h"
 
 #include <iostream>
 #include <string>
 
 #include <cmath>
+#include <cstring>
 
 #if (VAMP_SDK_MAJOR_VERSION != 2 || VAMP_SDK_MINOR_VERSION < 6)
 #error "Vamp plugin SDK v2, version 2.6 or newer required"
@@ -68,11 +78,55 @@ using namespace std;
 using namespace Vamp;
 using namespace Vamp::HostExt;
 
+static bool
+convertPatterns(PyObject *pyPatterns, vector<string> &patterns)
+{
+    if (!pyPatterns || pyPatterns == Py_None) return true;
+
+    if (!PyList_Check(pyPatterns)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Library name patterns must be given as a list of strings");
+        return false;
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pyPatterns); ++i) {
+        PyObject *item = PyList_GET_ITEM(pyPatterns, i);
+#if (PY_MAJOR_VERSION >= 3)
+        if (!PyUnicode_Check(item)) {
+#else
+        if (!PyString_Check(item)) {
+#endif
+            PyErr_SetString(PyExc_TypeError,
+                            "Library name patterns must be given as a list of strings");
+            return false;
+        }
+        patterns.push_back(StringConversion().py2string(item));
+    }
+
+    return true;
+}
+
 static PyObject *
-list_plugins(PyObject *self, PyObject *)
+list_plugins(PyObject *self, PyObject *args)
 {
-    PluginLoader *loader = PluginLoader::getInstance();
-    vector<PluginLoader::PluginKey> plugins = loader->listPlugins();
+    PyObject *pyInclude = 0;
+    PyObject *pyExclude = 0;
+
+    if (!PyArg_ParseTuple(args, "|OO",
+                          &pyInclude,
+                          &pyExclude)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "list_plugins() takes optional include (list of strings) and exclude (list of strings) arguments");
+        return 0; }
+
+    vector<string> include, exclude;
+    if (!convertPatterns(pyInclude, include) ||
+        !convertPatterns(pyExclude, exclude)) {
+        return 0;
+    }
+
+    vector<string> plugins = PluginDiscovery::listPlugins(include, exclude);
+
     VectorConversion conv;
     return conv.PyValue_From_StringVector(plugins);
 }
@@ -185,6 +239,8 @@ get_outputs_of(PyObject *self, PyObject *args)
 
     outputs = plugin->getOutputDescriptors();
 
+    delete plugin;
+
     PyObject *pyList = PyList_New(outputs.size());
 
     for (size_t i = 0; i < outputs.size(); ++i) {
@@ -230,7 +286,7 @@ load_plugin(PyObject *self, PyObject *args)
         return 0;
     }
 
-    return PyPluginObject_From_Plugin(plugin);
+    return PyPluginObject_From_Plugin(plugin, pluginKey, inputSampleRate);
 }
 
 static PyObject *
@@ -249,12 +305,610 @@ frame_to_realtime(PyObject *self, PyObject *args)
     RealTime rt = RealTime::frame2RealTime(frame, rate);
     return PyRealTime_FromRealTime(rt);
 }
+
+static PyObject *
+frame_view(PyObject *self, PyObject *args)
+{
+    PyObject *pyBuffer;
+    Py_ssize_t step, block;
+
+    if (!PyArg_ParseTuple(args, "Onn",
+                          &pyBuffer,
+                          &step,
+                          &block)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "frame_view() takes buffer (1D or 2D array), step size (int), and block size (int) arguments");
+        return 0; }
+
+    if (step < 1 || block < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Step and block sizes must be at least 1");
+        return 0;
+    }
+
+    PyArrayObject *arr = (PyArrayObject *)PyArray_FROM_O(pyBuffer);
+    if (!arr) return 0;
+
+    int ndim = PyArray_NDIM(arr);
+    if (ndim != 1 && ndim != 2) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Audio data must be a one- or two-dimensional array");
+        Py_DECREF(arr);
+        return 0;
+    }
+    if (!PyArray_ISNUMBER(arr) && !PyArray_ISBOOL(arr)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Audio data must be an array of numbers");
+        Py_DECREF(arr);
+        return 0;
+    }
+
+    npy_intp channels = (ndim == 1 ? 1 : PyArray_DIMS(arr)[0]);
+    npy_intp n = PyArray_DIMS(arr)[ndim - 1];
+    npy_intp channelStride = (ndim == 1 ? 0 : PyArray_STRIDES(arr)[0]);
+    npy_intp sampleStride = PyArray_STRIDES(arr)[ndim - 1];
+    npy_intp itemSize = PyArray_ITEMSIZE(arr);
+
+    // Frames start at every step from zero to the end of the data, as
+    // in vamp.frames.frames_from_array; the full ones are those lying
+    // wholly within it
+    npy_intp total = (n + step - 1) / step;
+    npy_intp full = (n >= block ? (n - block) / step + 1 : 0);
+    if (full > total) full = total;
+
+    npy_intp dims[3] = { full, channels, block };
+    npy_intp strides[3] = { step * sampleStride, channelStride, sampleStride };
+
+    PyArray_Descr *descr = PyArray_DESCR(arr);
+    Py_INCREF(descr);
+    PyObject *view = PyArray_NewFromDescr
+        (&PyArray_Type, descr, 3, dims, strides, PyArray_DATA(arr),
+         PyArray_FLAGS(arr) & NPY_ARRAY_ALIGNED, 0);
+    if (!view) {
+        Py_DECREF(arr);
+        return 0;
+    }
+    Py_INCREF(arr);
+    if (PyArray_SetBaseObject((PyArrayObject *)view, (PyObject *)arr) < 0) {
+        Py_DECREF(view);
+        Py_DECREF(arr);
+        return 0;
+    }
+
+    // The frames that run past the end are copied, padded with zeros
+    // in the data's own type
+    dims[0] = total - full;
+    Py_INCREF(descr);
+    PyObject *tail = PyArray_Zeros(3, dims, descr, 0);
+    if (!tail) {
+        Py_DECREF(view);
+        Py_DECREF(arr);
+        return 0;
+    }
+
+    const char *base = (const char *)PyArray_DATA(arr);
+    for (npy_intp f = full; f < total; ++f) {
+        npy_intp start = f * step;
+        for (npy_intp c = 0; c < channels; ++c) {
+            char *out = (char *)PyArray_GETPTR3((PyArrayObject *)tail,
+                                                f - full, c, 0);
+            const char *in = base + c * channelStride + start * sampleStride;
+            for (npy_intp i = 0; i < n - start; ++i) {
+                memcpy(out + i * itemSize, in + i * sampleStride, itemSize);
+            }
+        }
+    }
+
+    Py_DECREF(arr);
+    return Py_BuildValue("(NN)", view, tail);
+}
+
+static PyObject *
+pool_segments(PyObject *self, PyObject *args)
+{
+    PyObject *pyMatrix, *pyStarts, *pyEnds, *pyMethod;
+    double step;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "OdOOU",
+#else
+                          "OdOOS",
+#endif
+                          &pyMatrix,
+                          &step,
+                          &pyStarts,
+                          &pyEnds,
+                          &pyMethod)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "pool_segments() takes matrix (1D or 2D array), step (float), segment start times (array), segment end times (array), and method (string) arguments");
+        return 0; }
+
+    string methodName = StringConversion().py2string(pyMethod);
+    SegmentPooling::Method method;
+    if (!SegmentPooling::methodFromName(methodName, method)) {
+        PyErr_SetString(PyExc_ValueError,
+                        (string("Unknown pooling method \"") + methodName +
+                         "\": expected one of mean, min, max, sum, std").c_str());
+        return 0;
+    }
+
+    if (!(step > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Step must be greater than zero");
+        return 0;
+    }
+
+    PyArrayObject *matrix = (PyArrayObject *)
+        PyArray_FROM_OTF(pyMatrix, NPY_FLOAT,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!matrix) return 0;
+
+    PyArrayObject *starts = (PyArrayObject *)
+        PyArray_FROM_OTF(pyStarts, NPY_DOUBLE,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    PyArrayObject *ends = (PyArrayObject *)
+        PyArray_FROM_OTF(pyEnds, NPY_DOUBLE,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!starts || !ends) {
+        Py_DECREF(matrix);
+        Py_XDECREF(starts);
+        Py_XDECREF(ends);
+        return 0;
+    }
+
+    int ndim = PyArray_NDIM(matrix);
+    if (ndim != 1 && ndim != 2) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Matrix must be a one- or two-dimensional array");
+    } else if (PyArray_NDIM(starts) != 1 || PyArray_NDIM(ends) != 1 ||
+               PyArray_DIMS(starts)[0] != PyArray_DIMS(ends)[0]) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Segment start and end times must be one-dimensional arrays of equal length");
+    }
+    if (PyErr_Occurred()) {
+        Py_DECREF(matrix);
+        Py_DECREF(starts);
+        Py_DECREF(ends);
+        return 0;
+    }
+
+    size_t nrows = PyArray_DIMS(matrix)[0];
+    size_t ncols = (ndim == 2 ? PyArray_DIMS(matrix)[1] : 1);
+    size_t nsegs = PyArray_DIMS(starts)[0];
+
+    npy_intp dims[2];
+    dims[0] = nsegs;
+    dims[1] = ncols;
+    PyObject *pooled = PyArray_SimpleNew(ndim, dims, NPY_FLOAT);
+
+    if (pooled) {
+        SegmentPooling::pool((const float *)PyArray_DATA(matrix), nrows, ncols,
+                             step,
+                             (const double *)PyArray_DATA(starts),
+                             (const double *)PyArray_DATA(ends),
+                             nsegs,
+                             method,
+                             (float *)PyArray_DATA((PyArrayObject *)pooled));
+    }
+
+    Py_DECREF(matrix);
+    Py_DECREF(starts);
+    Py_DECREF(ends);
+    return pooled;
+}
+
+static PyObject *
+self_similarity(PyObject *self, PyObject *args)
+{
+    PyObject *pyMatrix, *pyMetric;
+    Py_ssize_t band = -1;
+    int half = 0;
+    int threads = 0;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "OU|nii",
+#else
+                          "OS|nii",
+#endif
+                          &pyMatrix,
+                          &pyMetric,
+                          &band,
+                          &half,
+                          &threads)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "self_similarity() takes matrix (1D or 2D array), metric (string), and optional band (int), half (bool), and threads (int) arguments");
+        return 0; }
+
+    string metricName = StringConversion().py2string(pyMetric);
+    SelfSimilarity::Metric metric;
+    if (!SelfSimilarity::metricFromName(metricName, metric)) {
+        PyErr_SetString(PyExc_ValueError,
+                        (string("Unknown similarity metric \"") + metricName +
+                         "\": expected cosine or euclidean").c_str());
+        return 0;
+    }
+
+    PyArrayObject *matrix = (PyArrayObject *)
+        PyArray_FROM_OTF(pyMatrix, NPY_FLOAT,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!matrix) return 0;
+
+    int ndim = PyArray_NDIM(matrix);
+    if (ndim != 1 && ndim != 2) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Matrix must be a one- or two-dimensional array");
+        Py_DECREF(matrix);
+        return 0;
+    }
+
+    size_t nrows = PyArray_DIMS(matrix)[0];
+    size_t ncols = (ndim == 2 ? PyArray_DIMS(matrix)[1] : 1);
+
+    npy_intp dims[2];
+    dims[0] = nrows;
+    dims[1] = (band < 0 ? nrows : band + 1);
+    PyObject *result = PyArray_SimpleNew(2, dims, half ? NPY_HALF : NPY_FLOAT);
+
+    if (result && nrows > 0) {
+        SelfSimilarity ss((const float *)PyArray_DATA(matrix), nrows, ncols,
+                          metric);
+        void *out = PyArray_DATA((PyArrayObject *)result);
+        Py_BEGIN_ALLOW_THREADS
+        if (band < 0) {
+            ss.computeFull(out, half, threads);
+        } else {
+            ss.computeBanded(out, band, half, threads);
+        }
+        Py_END_ALLOW_THREADS
+    }
+
+    Py_DECREF(matrix);
+    return result;
+}
+
+static bool
+writerFormat(PyObject *pyFormat, FeatureWriter::Format &format)
+{
+    string name = StringConversion().py2string(pyFormat);
+    if (!FeatureWriter::formatFromName(name, format)) {
+        PyErr_SetString(PyExc_ValueError,
+                        (string("Unknown feature format \"") + name +
+                         "\": expected csv or jsonl").c_str());
+        return false;
+    }
+    return true;
+}
+
+static PyObject *
+writerResult(FeatureWriter &writer)
+{
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = writer.flush();
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_SetString(PyExc_IOError, writer.getError().c_str());
+        return 0;
+    }
+    return PyLong_FromUnsignedLongLong(writer.getBytesWritten());
+}
+
+// Look up a time (RealTime or number of seconds) in a feature dict,
+// returning false with an exception set if it is of the wrong type
+static bool
+featureTime(PyObject *feature, const char *key, double &t, bool &present)
+{
+    PyObject *v = PyDict_GetItemString(feature, key);
+    present = (v && v != Py_None);
+    if (!present) return true;
+    if (PyRealTime_Check(v)) {
+        const RealTime *rt = PyRealTime_AsRealTime(v);
+        t = rt->sec + rt->nsec / 1e9;
+        return true;
+    }
+    t = PyFloat_AsDouble(v);
+    if (t == -1.0 && PyErr_Occurred()) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_TypeError,
+                        (string("Feature ") + key +
+                         " must be a RealTime or a number of seconds").c_str());
+        return false;
+    }
+    return true;
+}
+
+static PyObject *
+write_features(PyObject *self, PyObject *args)
+{
+    int fd;
+    PyObject *pyFormat, *pyFeatures, *pySource = 0;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "iUO|U",
+#else
+                          "iSO|S",
+#endif
+                          &fd,
+                          &pyFormat,
+                          &pyFeatures,
+                          &pySource)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "write_features() takes file descriptor (int), format (string), features (iterable of feature dicts), and optional source (string) arguments");
+        return 0; }
+
+    FeatureWriter::Format format;
+    if (!writerFormat(pyFormat, format)) return 0;
+
+    PyObject *iterator = PyObject_GetIter(pyFeatures);
+    if (!iterator) return 0;
+
+    FeatureWriter writer(fd, format);
+    if (pySource) writer.setSource(StringConversion().py2string(pySource));
+
+    PyObject *feature;
+    while ((feature = PyIter_Next(iterator))) {
+
+        if (!PyDict_Check(feature)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "Features must be dictionaries");
+            Py_DECREF(feature);
+            break;
+        }
+
+        double timestamp = 0.0, duration = 0.0;
+        bool hasTimestamp, hasDuration;
+        if (!featureTime(feature, "timestamp", timestamp, hasTimestamp) ||
+            !featureTime(feature, "duration", duration, hasDuration)) {
+            Py_DECREF(feature);
+            break;
+        }
+
+        PyArrayObject *values = 0;
+        PyObject *pyValues = PyDict_GetItemString(feature, "values");
+        if (pyValues) {
+            values = (PyArrayObject *)
+                PyArray_FROM_OTF(pyValues, NPY_FLOAT,
+                                 NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+            if (!values) {
+                Py_DECREF(feature);
+                break;
+            }
+            if (PyArray_NDIM(values) > 1) {
+                PyErr_SetString(PyExc_ValueError,
+                                "Feature values must be one-dimensional");
+                Py_DECREF(values);
+                Py_DECREF(feature);
+                break;
+            }
+        }
+
+        string label;
+        PyObject *pyLabel = PyDict_GetItemString(feature, "label");
+        if (pyLabel && pyLabel != Py_None) {
+#if (PY_MAJOR_VERSION >= 3)
+            bool isString = PyUnicode_Check(pyLabel);
+#else
+            bool isString = PyString_Check(pyLabel);
+#endif
+            if (!isString) {
+                PyErr_SetString(PyExc_TypeError,
+                                "Feature label must be a string");
+                Py_XDECREF(values);
+                Py_DECREF(feature);
+                break;
+            }
+            label = StringConversion().py2string(pyLabel);
+        }
+
+        writer.writeFeature(hasTimestamp ? &timestamp : 0,
+                            hasDuration ? &duration : 0,
+                            values ? (const float *)PyArray_DATA(values) : 0,
+                            values ? PyArray_SIZE(values) : 0,
+                            &label);
+
+        Py_XDECREF(values);
+        Py_DECREF(feature);
+
+        if (writer.failed()) break;
+    }
+
+    Py_DECREF(iterator);
+
+    if (PyErr_Occurred()) {
+        writer.flush();
+        return 0;
+    }
+
+    return writerResult(writer);
+}
+
+static PyObject *
+write_feature_rows(PyObject *self, PyObject *args)
+{
+    int fd;
+    PyObject *pyFormat, *pyTimes, *pyValues, *pySource = 0;
+
+    if (!PyArg_ParseTuple(args,
+#if (PY_MAJOR_VERSION >= 3)
+                          "iUOO|U",
+#else
+                          "iSOO|S",
+#endif
+                          &fd,
+                          &pyFormat,
+                          &pyTimes,
+                          &pyValues,
+                          &pySource)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "write_feature_rows() takes file descriptor (int), format (string), times (array), values (1D or 2D array), and optional source (string) arguments");
+        return 0; }
+
+    FeatureWriter::Format format;
+    if (!writerFormat(pyFormat, format)) return 0;
+
+    PyArrayObject *values = (PyArrayObject *)
+        PyArray_FROM_OTF(pyValues, NPY_FLOAT,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!values) return 0;
+
+    PyArrayObject *times = (PyArrayObject *)
+        PyArray_FROM_OTF(pyTimes, NPY_DOUBLE,
+                         NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (!times) {
+        Py_DECREF(values);
+        return 0;
+    }
+
+    int ndim = PyArray_NDIM(values);
+    if (ndim != 1 && ndim != 2) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Values must be a one- or two-dimensional array");
+    } else if (PyArray_NDIM(times) != 1 ||
+               PyArray_DIMS(times)[0] != PyArray_DIMS(values)[0]) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Times must be a one-dimensional array with one time per row of values");
+    }
+    if (PyErr_Occurred()) {
+        Py_DECREF(values);
+        Py_DECREF(times);
+        return 0;
+    }
+
+    size_t rows = PyArray_DIMS(values)[0];
+    size_t columns = (ndim == 2 ? PyArray_DIMS(values)[1] : 1);
+
+    FeatureWriter writer(fd, format);
+    if (pySource) writer.setSource(StringConversion().py2string(pySource));
+
+    Py_BEGIN_ALLOW_THREADS
+    writer.writeRows((const double *)PyArray_DATA(times),
+                     (const float *)PyArray_DATA(values),
+                     rows, columns);
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(values);
+    Py_DECREF(times);
+    return writerResult(writer);
+}
+
+// Obtain a C-contiguous, native-endian numeric array for NPY output,
+// returning a new reference, or 0 with an exception set
+static PyArrayObject *
+npyArray(PyObject *obj, string name, FeatureWriter::Array &array)
+{
+    PyArrayObject *given = (PyArrayObject *)PyArray_FROM_O(obj);
+    if (!given) return 0;
+    if (!PyArray_ISNUMBER(given) && !PyArray_ISBOOL(given)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Only arrays of numbers can be written as NPY");
+        Py_DECREF(given);
+        return 0;
+    }
+    PyArrayObject *arr = (PyArrayObject *)
+        PyArray_FROM_OTF((PyObject *)given, PyArray_TYPE(given),
+                         NPY_ARRAY_IN_ARRAY);
+    Py_DECREF(given);
+    if (!arr) return 0;
+
+    array.name = name;
+    array.data = PyArray_DATA(arr);
+    array.kind = PyArray_DESCR(arr)->kind;
+    array.itemSize = PyArray_ITEMSIZE(arr);
+    array.shape.clear();
+    for (int i = 0; i < PyArray_NDIM(arr); ++i) {
+        array.shape.push_back(PyArray_DIMS(arr)[i]);
+    }
+    return arr;
+}
+
+static PyObject *
+write_npy(PyObject *self, PyObject *args)
+{
+    int fd;
+    PyObject *pyArray;
+
+    if (!PyArg_ParseTuple(args, "iO", &fd, &pyArray)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "write_npy() takes file descriptor (int) and array arguments");
+        return 0; }
+
+    FeatureWriter::Array array;
+    PyArrayObject *arr = npyArray(pyArray, "", array);
+    if (!arr) return 0;
+
+    FeatureWriter writer(fd, FeatureWriter::CSV);
+
+    Py_BEGIN_ALLOW_THREADS
+    writer.writeNpy(array);
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(arr);
+    return writerResult(writer);
+}
+
+static PyObject *
+write_npz(PyObject *self, PyObject *args)
+{
+    int fd;
+    PyObject *pyArrays;
+
+    if (!PyArg_ParseTuple(args, "iO", &fd, &pyArrays)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "write_npz() takes file descriptor (int) and arrays (list of name and array pairs) arguments");
+        return 0; }
+
+    PyObject *seq = PySequence_Fast(pyArrays, "Arrays must be a list of name and array pairs");
+    if (!seq) return 0;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    vector<FeatureWriter::Array> arrays(n);
+    vector<PyArrayObject *> held;
+
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject *pair = PySequence_Fast_GET_ITEM(seq, i);
+        PyObject *pyName, *pyArray;
+        if (!PyTuple_Check(pair) ||
+            !PyArg_ParseTuple(pair,
+#if (PY_MAJOR_VERSION >= 3)
+                              "UO",
+#else
+                              "SO",
+#endif
+                              &pyName, &pyArray)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "Arrays must be a list of name and array pairs");
+            break;
+        }
+        PyArrayObject *arr = npyArray
+            (pyArray, StringConversion().py2string(pyName), arrays[i]);
+        if (!arr) break;
+        held.push_back(arr);
+    }
+
+    Py_DECREF(seq);
+
+    if (PyErr_Occurred()) {
+        for (size_t i = 0; i < held.size(); ++i) Py_DECREF(held[i]);
+        return 0;
+    }
+
+    FeatureWriter writer(fd, FeatureWriter::CSV);
+
+    Py_BEGIN_ALLOW_THREADS
+    writer.writeNpz(arrays);
+    Py_END_ALLOW_THREADS
+
+    for (size_t i = 0; i < held.size(); ++i) Py_DECREF(held[i]);
+    return writerResult(writer);
+}
     
 // module methods table
 static PyMethodDef vampyhost_methods[] = {
     
-    {"list_plugins", list_plugins, METH_NOARGS,
-     "list_plugins() -> Return a list of the plugin keys of all installed Vamp plugins." },
+    {"list_plugins", list_plugins, METH_VARARGS,
+     "list_plugins(include=None, exclude=None) -> Return a list of the plugin keys of all installed Vamp plugins. If include is given, it is a list of patterns of which a plugin library's name (the part of the plugin key before the colon) must match at least one to be examined; if exclude is given, libraries whose names match any of its patterns are skipped. Patterns may use the wildcards * and ?. Libraries that are skipped are never opened." },
 
     {"get_plugin_path", get_plugin_path, METH_NOARGS,
      "get_plugin_path() -> Return a list of directories which will be searched for Vamp plugins. This may be changed by setting the VAMP_PATH environment variable."},
@@ -274,6 +928,27 @@ static PyMethodDef vampyhost_methods[] = {
     {"frame_to_realtime", frame_to_realtime, METH_VARARGS,
      "frame_to_realtime() -> Convert sample frame number and sample rate to a RealTime object." },
 
+    {"frame_view", frame_view, METH_VARARGS,
+     "frame_view(buffer, step_size, block_size) -> Divide the audio in buffer (a 1D array, or a 2D array with one row per channel) into frames of block_size samples starting every step_size samples, and return a tuple of two arrays of shape (frames, channels, block_size). The first holds every frame lying wholly within the buffer, as a read-only strided view of it without copying. The second holds the few frames at the end that run past it, copied and padded with zeros. Both have the buffer's own type."},
+
+    {"pool_segments", pool_segments, METH_VARARGS,
+     "pool_segments(matrix, step, starts, ends, method) -> Summarise the rows of a feature matrix (or vector) whose rows are step seconds apart, over each of the segments given by the start and end times (in seconds). The method may be one of \"mean\", \"min\", \"max\", \"sum\", or \"std\". Each segment takes in every row whose time span overlaps it. Returns an array with one row per segment."},
+
+    {"self_similarity", self_similarity, METH_VARARGS,
+     "self_similarity(matrix, metric, band=-1, half=False, threads=0) -> Compare every row of a feature matrix (or vector) with every other row, returning a square matrix of cosine similarities (if metric is \"cosine\") or Euclidean distances (if metric is \"euclidean\"). If band is zero or more, compare each row only with itself and the following band rows, returning a matrix of band + 1 columns in which column k holds the value for the row k rows later, or NaN past the end. If half is True, return values in half precision (float16) rather than float32. The work is shared across the given number of threads, or one per core if threads is 0."},
+
+    {"write_features", write_features, METH_VARARGS,
+     "write_features(fd, format, features, source=None) -> Write each of the given feature dicts (as returned by process_block, or an iterable such as a generator of them) to the file descriptor fd, in format \"csv\" or \"jsonl\", returning the number of bytes written. CSV follows the column layout of Sonic Annotator: source (if given, on the first row only), timestamp and duration in seconds if present, values, then label if non-empty. JSON Lines writes one object per feature with the same keys as the dict, using null for NaN or infinite values. Features are written as they are obtained, through a buffer."},
+
+    {"write_feature_rows", write_feature_rows, METH_VARARGS,
+     "write_feature_rows(fd, format, times, values, source=None) -> Write a row for each row of the values (a 1D or 2D array), with the corresponding time in seconds from times, to the file descriptor fd as for write_features(), returning the number of bytes written."},
+
+    {"write_npy", write_npy, METH_VARARGS,
+     "write_npy(fd, array) -> Write a numeric array to the file descriptor fd in NumPy NPY format, returning the number of bytes written."},
+
+    {"write_npz", write_npz, METH_VARARGS,
+     "write_npz(fd, arrays) -> Write a list of (name, array) pairs to the file descriptor fd as an uncompressed NumPy NPZ archive, of less than 4GB, returning the number of bytes written."},
+
     {0, 0}              /* sentinel */
 };
 
@@ -307,6 +982,18 @@ static struct PyModuleDef vampyhostdef = {
 PyDoc_STRVAR(module_doc, "Load and run Vamp audio analysis plugins.");
 #endif
 
+// The module initialisation function is the only symbol we export:
+// everything else is built with hidden visibility, but older Python
+// headers don't mark PyMODINIT_FUNC as visible themselves
+#if defined(__GNUC__) && !defined(_WIN32)
+extern "C" __attribute__((visibility("default")))
+#if (PY_MAJOR_VERSION >= 3)
+PyObject *PyInit_vampyhost(void);
+#else
+void initvampyhost(void);
+#endif
+#endif
+
 // module initialization (includes extern C {...} as necessary)
 PyMODINIT_FUNC
 #if (PY_MAJOR_VERSION >= 3)
@@ -327,6 +1014,9 @@ initvampyhost(void)
     
     if (PyType_Ready(&RealTime_Type) < 0) return BAD_RETURN;
     if (PyType_Ready(&Plugin_Type) < 0) return BAD_RETURN;
+    if (PyType_Ready(&AdmissionControl_Type) < 0) return BAD_RETURN;
+    if (PyType_Ready(&StreamMultiplexer_Type) < 0) return BAD_RETURN;
+    if (PyType_Ready(&FilePrefetcher_Type) < 0) return BAD_RETURN;
 
 #if (PY_MAJOR_VERSION >= 3)
     m = PyModule_Create(&vampyhostdef);
@@ -343,6 +1033,21 @@ initvampyhost(void)
 
     PyModule_AddObject(m, "RealTime", (PyObject *)&RealTime_Type);
     PyModule_AddObject(m, "Plugin", (PyObject *)&Plugin_Type);
+    PyModule_AddObject(m, "AdmissionControl", (PyObject *)&AdmissionControl_Type);
+    PyModule_AddObject(m, "StreamMultiplexer", (PyObject *)&StreamMultiplexer_Type);
+    PyModule_AddObject(m, "FilePrefetcher", (PyObject *)&FilePrefetcher_Type);
+
+    PyAdmissionControl_Error =
+        PyErr_NewException((char *)"vampyhost.AdmissionError",
+                           PyExc_RuntimeError, NULL);
+    if (!PyAdmissionControl_Error) return BAD_RETURN;
+    Py_INCREF(PyAdmissionControl_Error);
+    PyModule_AddObject(m, "AdmissionError", PyAdmissionControl_Error);
+
+    // The C API for other extensions, see VampyHostAPI.h
+    PyObject *api = PyVampyHostAPI_NewCapsule();
+    if (!api) return BAD_RETURN;
+    PyModule_AddObject(m, "_C_API", api);
 
     // Some enum types
     PyObject *dict = PyModule_GetDict(m);
@@ -378,7 +1083,11 @@ initvampyhost(void)
         setint(dict, "SHIFT_DATA",
                PluginInputDomainAdapter::ShiftData) < 0 ||
         setint(dict, "NO_SHIFT",
-               PluginInputDomainAdapter::NoShift) < 0) {
+               PluginInputDomainAdapter::NoShift) < 0 ||
+        setint(dict, "LANE_INTERACTIVE",
+               AdmissionControl::Interactive) < 0 ||
+        setint(dict, "LANE_BATCH",
+               AdmissionControl::Batch) < 0) {
         cerr << "ERROR: initvampyhost: Failed to add enums to module dictionary" << endl;
         return BAD_RETURN;
     }
@@ -1,4 +1,5 @@
 import os
+import sys
 from setuptools import setup, find_packages, Extension
 
 
@@ -16,7 +17,14 @@ vpydir = 'native/'
 sdkfiles = [ 'Files', 'PluginBufferingAdapter', 'PluginChannelAdapter',
              'PluginHostAdapter', 'PluginInputDomainAdapter', 'PluginLoader',
              'PluginSummarisingAdapter', 'PluginWrapper', 'RealTime' ]
-vpyfiles = [ 'PyPluginObject', 'PyRealTime', 'VectorConversion', 'vampyhost' ]
+vpyfiles = [ 'PyPluginObject', 'PyRealTime', 'PyAdmissionControl',
+             'PyStreamMultiplexer', 'VectorConversion', 'SegmentPooling',
+             'SelfSimilarity', 'PluginDiscovery', 'AdmissionControl',
+             'StreamMultiplexer', 'FeatureTransform',
+             'FeatureCollector', 'RollingCollector', 'SlowBlockMonitor',
+             'InputConditioner', 'FeatureWriter', 'PyVampyHostAPI',
+             'PyFilePrefetcher', 'FilePrefetcher',
+             'vampyhost' ]
 
 srcfiles = [
     sdkdir + f + '.cpp' for f in sdkfiles
@@ -24,6 +32,45 @@ srcfiles = [
     vpydir + f + '.cpp' for f in vpyfiles
 ]
 
+# std::thread and std::atomic need C++11, which older compilers don't
+# select by default. MSVC has no such switch. Only the module
+# initialisation function needs to be exported
+cxxflags = [] if os.name == 'nt' else [ '-std=c++11', '-fvisibility=hidden' ]
+ldflags = []
+
+# Optimised builds, selected with the VAMPYHOST_OPTIMISE environment
+# variable (GCC and Clang only):
+#
+#   lto           link-time optimisation across all of the sources
+#   pgo-generate  instrumented build, for training: install it, then
+#                 run bench/pgo_workload.py
+#   pgo-use       LTO build using the profile written by pgo-generate
+#
+# The profile is written to and read from VAMPYHOST_PROFILE_DIR,
+# by default .pgo in this directory.
+optimise = os.environ.get('VAMPYHOST_OPTIMISE', '')
+profile_dir = os.path.abspath(os.environ.get('VAMPYHOST_PROFILE_DIR', '.pgo'))
+
+if optimise == 'lto':
+    cxxflags += [ '-flto' ]
+    ldflags += [ '-flto', '-O2' ]
+elif optimise == 'pgo-generate':
+    cxxflags += [ '-fprofile-generate=' + profile_dir ]
+    ldflags += [ '-fprofile-generate=' + profile_dir ]
+elif optimise == 'pgo-use':
+    if sys.platform == 'darwin':
+        # Clang wants the raw profiles merged first, with
+        # llvm-profdata merge -output=default.profdata *.profraw
+        use = [ '-fprofile-use=' + os.path.join(profile_dir, 'default.profdata') ]
+    else:
+        use = [ '-fprofile-use=' + profile_dir, '-fprofile-correction',
+                '-Wno-missing-profile' ]
+    cxxflags += [ '-flto' ] + use
+    ldflags += [ '-flto', '-O2' ] + use
+elif optimise != '':
+    raise ValueError('Unknown VAMPYHOST_OPTIMISE mode "' + optimise +
+                     '": expected lto, pgo-generate, or pgo-use')
+
 def read(*paths):
     with open(os.path.join(*paths), 'r') as f:
         return f.read()
@@ -31,6 +78,8 @@ def read(*paths):
 vampyhost = Extension('vampyhost',
                       sources = srcfiles,
                       define_macros = [ ('_USE_MATH_DEFINES', 1) ],
+                      extra_compile_args = cxxflags,
+                      extra_link_args = ldflags,
                       include_dirs = [ 'vamp-plugin-sdk', get_numpy_include() ])
 
 setup (name = 'vamp',
@@ -41,6 +90,7 @@ setup (name = 'vamp',
        license = 'MIT',
        packages = find_packages(exclude = [ '*test*' ]),
        ext_modules = [ vampyhost ],
+       headers = [ 'native/VampyHostAPI.h' ],
        requires = [ 'numpy' ],
        author = 'Chris Cannam, George Fazekas',
        author_email = 'cannam@all-day-breakfast.com',
@@ -0,0 +1,154 @@
+import vamp
+import vampyhost as vh
+import numpy as np
+import threading
+import time
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+def input_data(n):
+    # start at 1, not 0 so that all elts are non-zero
+    return np.arange(n, dtype = np.float32) + 1
+
+def wait_for_queued(adm, lane, n):
+    for i in range(500):
+        if adm.metrics()[lane]["queued"] == n:
+            return
+        time.sleep(0.01)
+    assert False
+
+def test_acquire_release():
+    ac = vh.AdmissionControl(2)
+    assert ac.acquire("a") == 0.0
+    assert ac.acquire("b", vh.LANE_BATCH) == 0.0
+    m = ac.metrics()
+    assert m["interactive"]["running"] == 1
+    assert m["interactive"]["admitted"] == 1
+    assert m["batch"]["running"] == 1
+    ac.release("a")
+    ac.release("b", vh.LANE_BATCH)
+    m = ac.metrics()
+    assert m["interactive"]["running"] == 0
+    assert m["batch"]["running"] == 0
+    assert m["batch"]["admitted"] == 1
+
+def test_bad_arguments():
+    for args in [ (0,), (2, 0, -1, 2), (2, -1) ]:
+        try:
+            vh.AdmissionControl(*args)
+            assert False
+        except ValueError:
+            pass
+    ac = vh.AdmissionControl(1)
+    try:
+        ac.acquire("a", 5)
+        assert False
+    except ValueError:
+        pass
+
+def test_reject_when_queue_full():
+    adm = vamp.Admission(1, max_queued = 0)
+    with adm.admit("a"):
+        try:
+            with adm.admit("a"):
+                assert False
+        except vamp.AdmissionError:
+            pass
+    m = adm.metrics()["interactive"]
+    assert m["rejected"] == 1
+    assert m["admitted"] == 1
+    assert m["running"] == 0
+
+def test_full_batch_queue_admits_interactive():
+    adm = vamp.Admission(1, max_queued = 1)
+    results = []
+    def run(key, lane):
+        with adm.admit(key, lane):
+            results.append(lane)
+    with adm.admit("a"):
+        tb = threading.Thread(target = run, args = ("b", "batch"))
+        tb.start()
+        wait_for_queued(adm, "batch", 1)
+        try:
+            with adm.admit("c", "batch"):
+                assert False
+        except vamp.AdmissionError:
+            pass
+        ti = threading.Thread(target = run, args = ("d", "interactive"))
+        ti.start()
+        wait_for_queued(adm, "interactive", 1)
+    tb.join()
+    ti.join()
+    assert results == [ "interactive", "batch" ]
+    m = adm.metrics()
+    assert m["batch"]["rejected"] == 1
+    assert m["interactive"]["rejected"] == 0
+
+def test_timeout():
+    adm = vamp.Admission(1)
+    with adm.admit("a"):
+        t0 = time.time()
+        try:
+            with adm.admit("b", timeout = 0.05):
+                assert False
+        except vamp.AdmissionError:
+            pass
+        assert time.time() - t0 >= 0.04
+    m = adm.metrics()["interactive"]
+    assert m["timed_out"] == 1
+    assert m["queued"] == 0
+    # and the slot is free again
+    with adm.admit("b", timeout = 0.0) as waited:
+        assert waited == 0.0
+
+def test_interactive_before_batch():
+    adm = vamp.Admission(1)
+    order = []
+    def run(key, lane):
+        with adm.admit(key, lane):
+            order.append(lane)
+    with adm.admit("a"):
+        tb = threading.Thread(target = run, args = ("b", "batch"))
+        tb.start()
+        wait_for_queued(adm, "batch", 1)
+        ti = threading.Thread(target = run, args = ("c", "interactive"))
+        ti.start()
+        wait_for_queued(adm, "interactive", 1)
+    tb.join()
+    ti.join()
+    assert order == [ "interactive", "batch" ]
+    assert adm.metrics()["batch"]["wait_max"] > 0.0
+
+def test_per_key_limit():
+    adm = vamp.Admission(4, max_running_per_key = 1)
+    with adm.admit("a"):
+        with adm.admit("b"):
+            try:
+                with adm.admit("a", timeout = 0.01):
+                    assert False
+            except vamp.AdmissionError:
+                pass
+
+def test_interactive_reserve():
+    adm = vamp.Admission(2, interactive_reserve = 1)
+    with adm.admit("a", "batch"):
+        try:
+            with adm.admit("b", "batch", timeout = 0.01):
+                assert False
+        except vamp.AdmissionError:
+            pass
+        with adm.admit("c", "interactive", timeout = 0.01):
+            pass
+
+def test_collect():
+    adm = vamp.Admission(1)
+    buf = input_data(10 * 1024)
+    results = adm.collect(buf, rate, plugin_key, "input-summary", lane = "batch")
+    expected = vamp.collect(buf, rate, plugin_key, "input-summary")
+    assert (results["vector"][1] == expected["vector"][1]).all()
+    m = adm.metrics()
+    assert m["batch"]["admitted"] == 1
+    assert m["batch"]["running"] == 0
+    assert m["interactive"]["admitted"] == 0
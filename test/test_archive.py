@@ -0,0 +1,146 @@
+
+import vamp
+import vamp.archive
+import numpy as np
+import wave
+import os
+import tempfile
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100
+blocksize = 1024
+
+def clips():
+    return [ ("clip-%d" % i,
+              np.linspace(-0.5, 0.5, blocksize * (i + 2), dtype = np.float32).reshape(1, -1),
+              rate)
+             for i in range(5) ]
+
+def archive_path():
+    fd, path = tempfile.mkstemp(suffix = ".vca")
+    os.close(fd)
+    return path
+
+def test_round_trip_float32():
+    path = archive_path()
+    try:
+        assert vamp.archive.pack(path, clips()) == 5
+        a = vamp.archive.ClipArchive(path)
+        assert len(a) == 5
+        for i, (id, samples, r) in enumerate(clips()):
+            aid, asamples, ar = a.clip(i)
+            assert aid == id
+            assert ar == r
+            assert asamples.shape == samples.shape
+            assert (asamples == samples).all()
+            assert asamples.ctypes.data % vamp.archive.ALIGNMENT == 0
+            assert not asamples.flags.writeable
+        asamples = None
+        a.close()
+    finally:
+        os.remove(path)
+
+def test_round_trip_int16():
+    path = archive_path()
+    try:
+        vamp.archive.pack(path, clips(), "int16")
+        with vamp.archive.ClipArchive(path) as a:
+            assert a.sample_format == "int16"
+            for i, (id, samples, r) in enumerate(clips()):
+                asamples = a.samples(i)
+                assert asamples.dtype == np.int16
+                assert (abs(asamples / 32768.0 - samples) <= 0.5 / 32768).all()
+            asamples = None
+    finally:
+        os.remove(path)
+
+def test_duplicate_id():
+    path = archive_path()
+    try:
+        w = vamp.archive.ArchiveWriter(path)
+        w.add("a", np.zeros(10), rate)
+        try:
+            w.add("a", np.zeros(10), rate)
+            assert False
+        except ValueError:
+            pass
+        w.close()
+    finally:
+        os.remove(path)
+
+def test_failed_pack_leaves_no_archive():
+    path = archive_path()
+    cs = clips()
+    cs[3] = ("bad", np.zeros((1, 2, 3)), rate)
+    try:
+        vamp.archive.pack(path, cs)
+        assert False
+    except ValueError:
+        pass
+    assert not os.path.exists(path)
+
+def test_collect_archive_matches_collect_clips():
+    path = archive_path()
+    try:
+        vamp.archive.pack(path, clips())
+        expected = vamp.collect_clips([ c[1] for c in clips() ], rate, plugin_key, "input-timestamp")
+        results = list(vamp.archive.collect_archive(path, plugin_key, "input-timestamp", batch = 2))
+        assert [ id for (id, r) in results ] == [ c[0] for c in clips() ]
+        for (id, r), e in zip(results, expected):
+            assert (r["vector"][1] == e["vector"][1]).all()
+    finally:
+        os.remove(path)
+
+def test_collect_archive_mixed_rates():
+    path = archive_path()
+    try:
+        cs = clips()
+        cs[2] = (cs[2][0], cs[2][1], rate / 2)
+        vamp.archive.pack(path, cs)
+        results = list(vamp.archive.collect_archive(path, plugin_key, "input-timestamp"))
+        assert [ id for (id, r) in results ] == [ c[0] for c in cs ]
+        expected = vamp.collect(cs[2][1], rate / 2, plugin_key, "input-timestamp")
+        assert abs(float(results[2][1]["vector"][0]) - float(expected["vector"][0])) < 1e-9
+        assert (results[2][1]["vector"][1] == expected["vector"][1]).all()
+    finally:
+        os.remove(path)
+
+def test_pack_files():
+    paths = []
+    path = archive_path()
+    try:
+        for i, (id, samples, r) in enumerate(clips()):
+            fd, p = tempfile.mkstemp(suffix = ".wav")
+            os.close(fd)
+            w = wave.open(p, "wb")
+            w.setnchannels(1)
+            w.setsampwidth(2)
+            w.setframerate(rate)
+            w.writeframes((samples.T * 32768).astype("<i2").tobytes())
+            w.close()
+            paths.append(p)
+        assert vamp.archive.pack_files(path, paths) == len(paths)
+        with vamp.archive.ClipArchive(path) as a:
+            assert sorted([ a.id(i) for i in range(len(a)) ]) == sorted(paths)
+            for i in range(len(a)):
+                n = paths.index(a.id(i))
+                assert a.samples(i).shape == clips()[n][1].shape
+    finally:
+        for p in paths:
+            os.remove(p)
+        os.remove(path)
+
+def test_failed_pack_files_leaves_no_archive():
+    path = archive_path()
+    fd, bad = tempfile.mkstemp(suffix = ".wav")
+    os.write(fd, b"not a wav file")
+    os.close(fd)
+    try:
+        vamp.archive.pack_files(path, [ bad ])
+        assert False
+    except IOError:
+        pass
+    finally:
+        os.remove(bad)
+    assert not os.path.exists(path)
@@ -0,0 +1,136 @@
+
+import vampyhost as vh
+import numpy as np
+import ctypes
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100
+blocksize = 1024
+
+# Mirrors of the structures in native/VampyHostAPI.h, so that the C
+# API can be driven from here as another extension would drive it
+
+class Feature(ctypes.Structure):
+    _fields_ = [ ("output", ctypes.c_int),
+                 ("hasTimestamp", ctypes.c_int),
+                 ("sec", ctypes.c_int),
+                 ("nsec", ctypes.c_int),
+                 ("hasDuration", ctypes.c_int),
+                 ("durationSec", ctypes.c_int),
+                 ("durationNsec", ctypes.c_int),
+                 ("values", ctypes.POINTER(ctypes.c_float)),
+                 ("valueCount", ctypes.c_size_t),
+                 ("label", ctypes.c_char_p) ]
+
+Callback = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.POINTER(Feature))
+Input = ctypes.POINTER(ctypes.POINTER(ctypes.c_float))
+
+class API(ctypes.Structure):
+    _fields_ = [ ("version", ctypes.c_uint),
+                 ("size", ctypes.c_size_t),
+                 ("loadPlugin", ctypes.PYFUNCTYPE(ctypes.py_object, ctypes.c_char_p, ctypes.c_float, ctypes.c_int)),
+                 ("getPlugin", ctypes.PYFUNCTYPE(ctypes.c_void_p, ctypes.py_object)),
+                 ("acquire", ctypes.PYFUNCTYPE(ctypes.c_int, ctypes.c_void_p)),
+                 ("release", ctypes.PYFUNCTYPE(None, ctypes.c_void_p)),
+                 ("getChannelCount", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p)),
+                 ("getStepSize", ctypes.CFUNCTYPE(ctypes.c_size_t, ctypes.c_void_p)),
+                 ("getBlockSize", ctypes.CFUNCTYPE(ctypes.c_size_t, ctypes.c_void_p)),
+                 ("getOutputCount", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p)),
+                 ("getOutputBinCount", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_int)),
+                 ("process", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, Input, ctypes.c_int, ctypes.c_int, Callback, ctypes.c_void_p)),
+                 ("getRemainingFeatures", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, Callback, ctypes.c_void_p)),
+                 ("collect", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, Input, ctypes.c_size_t, ctypes.c_int, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_double), ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t))) ]
+
+def get_api():
+    get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+    get_pointer.restype = ctypes.c_void_p
+    get_pointer.argtypes = [ ctypes.py_object, ctypes.c_char_p ]
+    return API.from_address(get_pointer(vh._C_API, b"vampyhost._C_API"))
+
+def planar(buf):
+    rows = [ r.ctypes.data_as(ctypes.POINTER(ctypes.c_float)) for r in buf ]
+    return (ctypes.POINTER(ctypes.c_float) * len(rows))(*rows)
+
+def loaded():
+    api = get_api()
+    plug = api.loadPlugin(plugin_key.encode("utf-8"), rate, vh.ADAPT_NONE)
+    plug.initialise(1, blocksize, blocksize)
+    return api, plug, api.getPlugin(plug)
+
+def test_version():
+    api = get_api()
+    assert api.version >= 1
+    assert api.size >= ctypes.sizeof(API)
+
+def test_acquire():
+    api = get_api()
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    p = api.getPlugin(plug)
+    try:
+        api.acquire(p)
+        assert False
+    except Exception:
+        pass                    # not initialised
+    plug.initialise(1, blocksize, blocksize)
+    assert api.acquire(p) == 0
+    try:
+        plug.reset()
+        assert False
+    except RuntimeError:
+        pass                    # in use from native code
+    api.release(p)
+    plug.reset()
+
+def test_process_callback():
+    api, plug, p = loaded()
+    assert api.getChannelCount(p) == 1
+    assert api.getBlockSize(p) == blocksize
+    assert api.getOutputBinCount(p, 5) == 10
+    assert api.getOutputBinCount(p, 0) == 0
+    assert api.getOutputBinCount(p, 99) == -1
+    seen = []
+    def got(context, feature):
+        f = feature.contents
+        seen.append((f.output, [ f.values[i] for i in range(f.valueCount) ]))
+    cb = Callback(got)
+    buf = np.ones((1, blocksize), dtype = np.float32)
+    api.acquire(p)
+    assert api.process(p, planar(buf), 0, 0, cb, None) == 0
+    api.release(p)
+    plug.reset()
+    expected = plug.process_block(buf, vh.RealTime(0, 0))
+    for o, values in seen:
+        assert o in expected
+    assert (5, list(expected[5][0]["values"])) in seen
+    assert len(seen) == sum(len(v) for v in expected.values())
+
+def test_collect():
+    api, plug, p = loaded()
+    buf = (np.arange(blocksize * 10, dtype = np.float32) + 1).reshape(1, -1)
+    values = np.zeros(16, dtype = np.float32)
+    times = np.zeros(16)
+    written = ctypes.c_size_t(0)
+    api.acquire(p)
+    rc = api.collect(p, planar(buf), buf.shape[1], 10,
+                     values.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                     times.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+                     16, ctypes.byref(written))
+    api.release(p)
+    assert rc == 0
+    assert written.value == 10
+    assert list(values[:10]) == [ i * blocksize for i in range(10) ]
+    assert (abs(times[:10] - np.arange(10) * blocksize / rate) < 1e-6).all()
+
+def test_collect_out_of_space():
+    api, plug, p = loaded()
+    buf = np.ones((1, blocksize * 10), dtype = np.float32)
+    values = np.zeros(4, dtype = np.float32)
+    written = ctypes.c_size_t(0)
+    api.acquire(p)
+    rc = api.collect(p, planar(buf), buf.shape[1], 10,
+                     values.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                     None, 4, ctypes.byref(written))
+    api.release(p)
+    assert rc == 4              # VAMPYHOST_ERROR_OUT_OF_SPACE
+    assert written.value == 4
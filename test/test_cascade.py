@@ -0,0 +1,94 @@
+import vamp
+from vamp.cascade import active_regions
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+# As in test_collect, the plugin is expected to run with block and
+# step size of 1024
+
+blocksize = 1024
+
+def gated_data(blocks, active):
+    # silence, except in the given blocks
+    buf = np.zeros(blocks * blocksize, dtype = np.float32)
+    for b in active:
+        buf[b * blocksize : (b + 1) * blocksize] = 1
+    return buf
+
+def test_cascade_regions():
+    buf = gated_data(20, [ 5, 6, 7, 12 ])
+    rvs = vamp.cascade(buf, rate, plugin_key, "input-summary",
+                       plugin_key, "input-timestamp", condition = 1)
+    assert len(rvs) == 2
+    assert rvs[0]["start"] == vh.frame_to_realtime(5 * blocksize, rate)
+    assert rvs[0]["end"] == vh.frame_to_realtime(8 * blocksize, rate)
+    assert rvs[1]["start"] == vh.frame_to_realtime(12 * blocksize, rate)
+    # the plugin sees timestamps within the whole buffer
+    step, values = rvs[0]["vector"]
+    assert list(values) == [ 5 * blocksize, 6 * blocksize, 7 * blocksize ]
+    assert rvs[0]["origin"] == rvs[0]["start"]
+    step, values = rvs[1]["vector"]
+    assert list(values) == [ 12 * blocksize ]
+
+def test_cascade_pre_roll():
+    buf = gated_data(20, [ 5, 6, 7 ])
+    rvs = vamp.cascade(buf, rate, plugin_key, "input-summary",
+                       plugin_key, "input-timestamp", condition = 1,
+                       pre_roll = 2.0 * blocksize / rate)
+    assert len(rvs) == 1
+    step, values = rvs[0]["vector"]
+    # features from the pre-roll are discarded
+    assert list(values) == [ 5 * blocksize, 6 * blocksize, 7 * blocksize ]
+    assert rvs[0]["origin"] == vh.frame_to_realtime(5 * blocksize, rate)
+
+def test_cascade_min_gap():
+    buf = gated_data(20, [ 5, 6, 8 ])
+    rvs = vamp.cascade(buf, rate, plugin_key, "input-summary",
+                       plugin_key, "input-timestamp", condition = 1,
+                       min_gap = 2.0 * blocksize / rate)
+    assert len(rvs) == 1
+    step, values = rvs[0]["vector"]
+    assert list(values) == [ 5 * blocksize, 6 * blocksize, 7 * blocksize, 8 * blocksize ]
+
+def test_cascade_function_condition():
+    buf = gated_data(20, [ 5, 6, 7 ])
+    rvs = vamp.cascade(buf, rate, plugin_key, "input-summary",
+                       plugin_key, "input-timestamp",
+                       condition = lambda v: v == 0)
+    assert len(rvs) == 2
+    assert rvs[0]["start"] == vh.frame_to_realtime(0, rate)
+    assert rvs[1]["start"] == vh.frame_to_realtime(8 * blocksize, rate)
+    assert rvs[1]["end"] == vh.frame_to_realtime(20 * blocksize, rate)
+
+def test_cascade_nothing_active():
+    buf = gated_data(10, [])
+    rvs = vamp.cascade(buf, rate, plugin_key, "input-summary",
+                       plugin_key, "input-timestamp", condition = 1)
+    assert rvs == []
+
+def test_active_regions_list():
+    features = [ { "timestamp": vh.RealTime('seconds', 0.0), "label": "speech" },
+                 { "timestamp": vh.RealTime('seconds', 1.0), "label": "music" },
+                 { "timestamp": vh.RealTime('seconds', 2.0), "label": "speech",
+                   "duration": vh.RealTime('seconds', 0.5) } ]
+    starts, ends = active_regions({ "list": features },
+                                  lambda f: f["label"] == "speech",
+                                  10.0)
+    assert list(starts) == [ 0.0, 2.0 ]
+    assert list(ends) == [ 1.0, 2.5 ]
+
+def test_collect_regions():
+    buf = gated_data(10, [])
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    plug.initialise(1, blocksize, blocksize)
+    results = plug.collect_regions(buf, 10, [ (0, 2048), (4096, 5000), (9000, 20000) ])
+    assert len(results) == 3
+    assert list(results[0]) == [ 0, 1024 ]
+    assert list(results[1]) == [ 4096 ]
+    # regions are clipped to the end of the buffer
+    assert list(results[2]) == [ 9000, 10024 ]
+    plug.unload()
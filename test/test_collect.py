@@ -2,6 +2,7 @@
 import vamp
 import numpy as np
 import vamp.frames as fr
+import pickle
 
 plugin_key = "vamp-test-plugin:vamp-test-plugin"
 plugin_key_freq = "vamp-test-plugin:vamp-test-plugin-freq"
@@ -119,3 +120,281 @@ def test_collect_grid_one_sample_per_step():
     for i in range(len(results)):
         expected = np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ])
         assert (abs(results[i] - expected) < eps).all()
+
+def test_collect_transform_clip_l2():
+    buf = input_data(blocksize * 10)
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", transforms = [ ("clip", 0.2, 0.5) ])
+    step, results = rdict["matrix"]
+    assert len(results) == 10
+    for i in range(len(results)):
+        expected = np.clip(np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ]), 0.2, 0.5)
+        assert (abs(results[i] - expected) < eps).all()
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", transforms = [ "l2" ])
+    step, results = rdict["matrix"]
+    for i in range(len(results)):
+        expected = np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ])
+        expected = expected / np.sqrt(np.sum(expected * expected))
+        assert (abs(results[i] - expected) < eps).all()
+
+def test_collect_transform_db():
+    buf = input_data(blocksize * 10)
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", transforms = [ "db" ])
+    step, results = rdict["matrix"]
+    for i in range(len(results)):
+        expected = 10.0 * np.log10(np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ]))
+        assert (abs(results[i] - expected) < 1e-4).all()
+
+def test_collect_transform_delta():
+    buf = input_data(blocksize * 10)
+    rdict = vamp.collect(buf, rate, plugin_key, "input-timestamp", transforms = [ "delta" ])
+    # a vector output with deltas appended becomes a matrix
+    step, results = rdict["matrix"]
+    assert results.shape == (10, 2)
+    for i in range(len(results)):
+        assert results[i][0] == i * blocksize
+        if i == 0:
+            assert results[i][1] == 0
+        else:
+            assert results[i][1] == blocksize
+    rdict = vamp.collect(buf, rate, plugin_key, "input-timestamp", transforms = [ "delta2" ])
+    step, results = rdict["matrix"]
+    assert results.shape == (10, 3)
+    assert results[1][2] == blocksize
+    assert (results[2:,2] == 0).all()
+
+def test_collect_transform_fail():
+    buf = input_data(blocksize * 10)
+    try:
+        vamp.collect(buf, rate, plugin_key, "curve-vsr", transforms = [ "l2" ])
+        assert False
+    except ValueError: # list-shaped output
+        pass
+    try:
+        vamp.collect(buf, rate, plugin_key, "grid-oss", transforms = [ "sqrt" ])
+        assert False
+    except ValueError: # unknown transform
+        pass
+
+def test_collect_memory_limit():
+    buf = input_data(blocksize * 10)
+    # A limit smaller than the whole result forces values out to disk
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", memory_limit = 100)
+    step, results = rdict["matrix"]
+    assert isinstance(results.base, np.memmap)
+    assert results.shape == (10, 10)
+    for i in range(len(results)):
+        expected = np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ])
+        assert (abs(results[i] - expected) < eps).all()
+    results[0][0] = 0
+    rdict = vamp.collect(buf, rate, plugin_key, "input-timestamp", memory_limit = 12)
+    step, results = rdict["vector"]
+    assert results.shape == (10,)
+    assert (results == np.arange(10) * blocksize).all()
+
+def test_collect_memory_limit_not_reached():
+    buf = input_data(blocksize * 10)
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", memory_limit = 1000000)
+    step, results = rdict["matrix"]
+    assert not isinstance(results.base, np.memmap)
+    assert results.shape == (10, 10)
+
+def test_collect_multiple_outputs():
+    buf = input_data(blocksize * 10)
+    outputs = [ "input-timestamp", "grid-oss", "curve-vsr" ]
+    rdicts = vamp.collect(buf, rate, plugin_key, outputs)
+    assert sorted(rdicts.keys()) == sorted(outputs)
+    for o in outputs:
+        single = vamp.collect(buf, rate, plugin_key, o)
+        shape = list(single.keys())[0]
+        assert list(rdicts[o].keys()) == [ shape ]
+        if shape == "list":
+            assert len(rdicts[o][shape]) == len(single[shape])
+            for (a, b) in zip(rdicts[o][shape], single[shape]):
+                assert a["timestamp"] == b["timestamp"]
+                assert (a["values"] == b["values"]).all()
+        else:
+            assert rdicts[o][shape][0] == single[shape][0]
+            assert (rdicts[o][shape][1] == single[shape][1]).all()
+
+def test_collect_multiple_outputs_transformed():
+    buf = input_data(blocksize * 10)
+    # transforms apply only to the outputs that can take them
+    rdicts = vamp.collect(buf, rate, plugin_key, [ "grid-oss", "curve-vsr" ],
+                          transforms = [ "l2" ], memory_limit = 100)
+    step, results = rdicts["grid-oss"]["matrix"]
+    assert isinstance(results.base, np.memmap)
+    for i in range(len(results)):
+        expected = np.array([ (j + i + 2.0) / 30.0 for j in range(0, 10) ])
+        expected = expected / np.sqrt((expected * expected).sum())
+        assert (abs(results[i] - expected) < eps).all()
+    assert len(rdicts["curve-vsr"]["list"]) == 10
+
+def test_collect_multiple_outputs_share_memory_limit():
+    buf = input_data(blocksize * 10)
+    # Each 10x10 result fits within the limit alone, but not both
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", memory_limit = 500)
+    assert not isinstance(rdict["matrix"][1].base, np.memmap)
+    rdicts = vamp.collect(buf, rate, plugin_key, [ "grid-oss", "grid-fsr" ],
+                          memory_limit = 500)
+    assert isinstance(rdicts["grid-oss"]["matrix"][1].base, np.memmap)
+    assert isinstance(rdicts["grid-fsr"]["matrix"][1].base, np.memmap)
+
+def test_collect_duplicate_outputs():
+    buf = input_data(blocksize * 10)
+    try:
+        vamp.collect(buf, rate, plugin_key, [ "grid-oss", "grid-oss" ])
+        assert False
+    except ValueError:
+        pass
+    try:
+        vamp.collect_clips([ buf ], rate, plugin_key, [ "grid-oss", "grid-oss" ])
+        assert False
+    except ValueError:
+        pass
+
+def test_collect_pickle_out_of_band():
+    buf = input_data(blocksize * 10)
+    rdicts = vamp.collect(buf, rate, plugin_key, [ "grid-oss", "curve-vsr" ])
+    spilled = vamp.collect(buf, rate, plugin_key, "grid-oss", memory_limit = 100)
+    for rdict in [ rdicts, spilled ]:
+        p = pickle.loads(pickle.dumps(rdict))
+        assert list(p.keys()) == list(rdict.keys())
+    if pickle.HIGHEST_PROTOCOL < 5:
+        return
+    # Matrix data goes out of band, while step and feature timestamps
+    # go in band
+    buffers = []
+    data = pickle.dumps(spilled, protocol = 5, buffer_callback = buffers.append)
+    assert len(buffers) == 1
+    step, results = pickle.loads(data, buffers = buffers)["matrix"]
+    assert step == spilled["matrix"][0]
+    assert (results == spilled["matrix"][1]).all()
+    buffers = []
+    data = pickle.dumps(rdicts, protocol = 5, buffer_callback = buffers.append)
+    p = pickle.loads(data, buffers = buffers)
+    assert (p["grid-oss"]["matrix"][1] == rdicts["grid-oss"]["matrix"][1]).all()
+    assert p["curve-vsr"]["list"][3]["timestamp"] == rdicts["curve-vsr"]["list"][3]["timestamp"]
+
+def test_collect_threads():
+    # Collection runs without the GIL, so may proceed in several
+    # threads at once, each with its own plugin
+    import threading
+    buf = input_data(blocksize * 200)
+    expected = vamp.collect(buf, rate, plugin_key, "input-timestamp")["vector"][1]
+    results = [ None ] * 4
+    def run(i):
+        results[i] = vamp.collect(buf, rate, plugin_key, "input-timestamp")["vector"][1]
+    threads = [ threading.Thread(target = run, args = (i,)) for i in range(4) ]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for r in results:
+        assert (r == expected).all()
+
+def test_collect_sparse():
+    # four channels, of which only the first has any signal, so
+    # three quarters of the input-summary values are zero
+    buf = np.zeros((4, blocksize * 10))
+    buf[0] = input_data(blocksize * 10)
+    dense = vamp.collect(buf, rate, plugin_key, "input-summary")
+    rdict = vamp.collect(buf, rate, plugin_key, "input-summary", sparse = True)
+    step, results = rdict["matrix"]
+    assert step == dense["matrix"][0]
+    assert results.format == "csr"
+    assert results.shape == (10, 4)
+    assert results.nnz == 10
+    assert (results.toarray() == dense["matrix"][1]).all()
+
+def test_collect_sparse_dense_shapes():
+    # Only matrix results are made sparse
+    buf = input_data(blocksize * 10)
+    rdict = vamp.collect(buf, rate, plugin_key, [ "input-summary", "grid-oss" ],
+                         sparse = True)
+    step, results = rdict["input-summary"]["vector"]
+    assert isinstance(results, np.ndarray)
+    step, results = rdict["grid-oss"]["matrix"]
+    assert results.format == "csr"
+    assert results.shape == (10, 10)
+
+def test_collect_sparse_memory_limit():
+    buf = input_data(blocksize * 10)
+    try:
+        vamp.collect(buf, rate, plugin_key, "grid-oss", sparse = True,
+                     memory_limit = 1024)
+        assert False
+    except ValueError:
+        pass
+
+def test_collect_clips():
+    clips = [ input_data(blocksize * n) for n in [ 3, 5, 1 ] ] + [ input_data(100) ]
+    results = vamp.collect_clips(clips, rate, plugin_key, "input-summary")
+    assert len(results) == len(clips)
+    for clip, result in zip(clips, results):
+        expected = vamp.collect(clip, rate, plugin_key, "input-summary")
+        assert (result["vector"][1] == expected["vector"][1]).all()
+        assert result["vector"][0] == expected["vector"][0]
+
+def test_collect_clips_multiple_outputs():
+    clips = [ input_data(blocksize * 2), input_data(blocksize * 4) ]
+    results = vamp.collect_clips(clips, rate, plugin_key,
+                                 [ "input-timestamp", "instants" ],
+                                 transforms = [ ("clip", 0, blocksize * 2) ])
+    # each clip is processed from a reset, with its own timestamps
+    for clip, result in zip(clips, results):
+        n = len(clip) // blocksize
+        expected = [ min(i * blocksize, blocksize * 2) for i in range(n) ]
+        assert list(result["input-timestamp"]["vector"][1]) == expected
+        assert len(result["instants"]["list"]) == 10
+
+def test_collect_clips_empty():
+    assert vamp.collect_clips([], rate, plugin_key) == []
+
+def test_collect_out():
+    buf = input_data(blocksize * 10)
+    out = np.full(16, -1, dtype = np.float32)
+    times = np.zeros(16)
+    rdict = vamp.collect(buf, rate, plugin_key, "input-timestamp",
+                         out = out, out_times = times)
+    step, results = rdict["vector"]
+    assert len(results) == 10
+    assert np.shares_memory(results, out)
+    assert list(out[:10]) == [ i * blocksize for i in range(10) ]
+    assert out[10] == -1
+    assert (abs(times[:10] - np.arange(10) * blocksize / rate) < eps).all()
+
+def test_collect_out_matrix_and_errors():
+    buf = input_data(blocksize * 10)
+    out = np.zeros((10, 10), dtype = np.float32)
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss", out = out)
+    expected = vamp.collect(buf, rate, plugin_key, "grid-oss")
+    assert (rdict["matrix"][1] == expected["matrix"][1]).all()
+    assert (out == expected["matrix"][1]).all()
+    for bad in [ np.zeros((10, 10)),               # wrong dtype
+                 np.zeros((10, 9), np.float32),    # wrong width
+                 np.zeros((5, 10), np.float32),    # too few rows
+                 np.zeros((10, 20), np.float32)[:, ::2] ]: # not contiguous
+        try:
+            vamp.collect(buf, rate, plugin_key, "grid-oss", out = bad)
+            assert False
+        except (TypeError, ValueError):
+            pass
+    try:
+        vamp.collect(buf, rate, plugin_key, "instants", out = out)
+        assert False
+    except ValueError:
+        pass
+
+def test_collect_out_multiple_and_clips():
+    buf = input_data(blocksize * 4)
+    out = np.zeros(4, dtype = np.float32)
+    rdict = vamp.collect(buf, rate, plugin_key, [ "input-timestamp", "instants" ],
+                         out = { "input-timestamp": out })
+    assert np.shares_memory(rdict["input-timestamp"]["vector"][1], out)
+    clips = [ input_data(blocksize * 2), input_data(blocksize * 3) ]
+    outs = np.zeros((2, 3), dtype = np.float32)
+    results = vamp.collect_clips(clips, rate, plugin_key, "input-timestamp",
+                                 out = [ outs[0], outs[1] ])
+    assert list(outs[0]) == [ 0, blocksize, 0 ]
+    assert list(outs[1]) == [ 0, blocksize, blocksize * 2 ]
+    assert len(results[0]["vector"][1]) == 2
@@ -0,0 +1,82 @@
+
+import vamp
+import vamp.costs
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+# As in test_collect, the plugin is expected to run with block and
+# step size of 1024
+
+blocksize = 1024
+
+def test_measure():
+    m = vamp.costs.measure(plugin_key, rate, seconds = 1.0)
+    assert m["step_size"] == blocksize
+    assert m["block_size"] == blocksize
+    assert m["blocks"] == int(rate) // blocksize
+    assert m["realtime_factor"] > 0
+    assert m["block_max"] >= m["block_mean"]
+    # one input-timestamp feature of one value per block, each held
+    # as a float32 value and a float64 timestamp
+    per_hour = 3600.0 * m["blocks"] / m["seconds"]
+    out = m["outputs"]["input-timestamp"]
+    assert abs(out["features_per_hour"] - per_hour) < 1e-6
+    assert abs(out["bytes_per_hour"] - per_hour * 12) < 1e-6
+    # ten instants, without values, from getRemainingFeatures
+    assert abs(m["outputs"]["instants"]["features_per_hour"] - 10 * 3600.0 / m["seconds"]) < 1e-6
+
+def test_measure_configuration():
+    m = vamp.costs.measure(plugin_key, rate, channels = 2, step_size = 512,
+                           block_size = 2048, seconds = 0.5)
+    assert m["channels"] == 2
+    assert m["step_size"] == 512
+    assert m["block_size"] == 2048
+    assert m["blocks"] == (int(rate * 0.5) - 2048) // 512 + 1
+    # input-summary has one bin per channel
+    out = m["outputs"]["input-summary"]
+    assert abs(out["bytes_per_hour"] - out["features_per_hour"] * (2 * 4 + 8)) < 1e-3
+
+def test_database():
+    db = vamp.costs.ProfileDatabase(":memory:")
+    keys = vamp.list_plugins([ "vamp-test-plugin" ])
+    results = vamp.costs.profile(keys, [ {}, { "channels": 2 }, { "channels": 20 } ],
+                                 rate, 0.25, db)
+    # the test plugins support up to 10 channels, so the last
+    # configuration fails and is skipped
+    assert len(results) == 2 * len(keys)
+    stored = db.measurements(plugin_key)
+    assert len(stored) == 2
+    assert stored[0]["outputs"] == results[0]["outputs"]
+    assert stored[1]["channels"] == 2
+    assert db.latest(plugin_key, 2)["recorded"] == stored[1]["recorded"]
+    assert db.latest(plugin_key, 4) is None
+    prediction = vamp.costs.predict(stored[0], 2.0)
+    assert abs(prediction["bytes"] - stored[0]["bytes_per_hour"] * 2) < 1e-3
+    text = vamp.costs.report(db.measurements())
+    assert plugin_key in text
+    assert len(text.split("\n")) == 2 + len(results)
+
+def test_profile_failures():
+    keys = vamp.list_plugins([ "vamp-test-plugin" ])
+    failures = []
+    results = vamp.costs.profile(keys + [ "nonesuch:plugin" ],
+                                 [ {}, { "channels": 20 } ], rate, 0.25,
+                                 failures = failures)
+    assert len(results) == len(keys)
+    # each test plugin fails with 20 channels, and the missing plugin
+    # fails to load in both configurations
+    assert len(failures) == len(keys) + 2
+    assert [ f[0] for f in failures ].count("nonesuch:plugin") == 2
+    assert failures[0][1] == { "channels": 20 }
+    text = vamp.costs.report(results, failures)
+    lines = text.split("\n")
+    assert len(lines) == 2 + len(results) + len(failures)
+    assert "streams" in lines[0]
+    assert "nonesuch:plugin" in lines[-1]
+    try:
+        vamp.costs.measure("nonesuch:plugin")
+        assert False
+    except vamp.costs.MeasurementError:
+        pass
@@ -0,0 +1,121 @@
+
+import vamp
+import vamp.export
+import numpy as np
+import json
+import csv
+import os
+import tempfile
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100
+blocksize = 1024
+
+def input_data(n):
+    # start at 1, not 0 so that all elts are non-zero
+    return np.arange(n) + 1
+
+def temp_path(suffix):
+    fd, path = tempfile.mkstemp(suffix = suffix)
+    os.close(fd)
+    return path
+
+def test_csv_vector():
+    buf = input_data(blocksize * 10)
+    result = vamp.collect(buf, rate, plugin_key, "input-timestamp")
+    path = temp_path(".csv")
+    n = vamp.export.write_csv(result, path)
+    assert n == os.path.getsize(path)
+    rows = list(csv.reader(open(path)))
+    os.remove(path)
+    step = result["vector"][0].to_float()
+    assert len(rows) == 10
+    for i, row in enumerate(rows):
+        assert len(row[0].split(".")[1]) == 9
+        assert abs(float(row[0]) - i * step) < 1e-9
+        assert row[1] == str(i * blocksize)
+
+def test_csv_source_and_list():
+    buf = input_data(blocksize * 10)
+    result = vamp.collect(buf, rate, plugin_key, "notes-regions")
+    path = temp_path(".csv")
+    vamp.export.write_csv(result, path, source = 'a "b".wav')
+    text = open(path).read()
+    os.remove(path)
+    lines = text.splitlines()
+    assert len(lines) == 10
+    assert lines[0] == '"a ""b"".wav",0.000000000,1.000000000,1,"note"'
+    assert lines[1] == ',1.750000000,2.000000000,2,"note"'
+
+def test_csv_matrix_file_object():
+    buf = input_data(blocksize * 10)
+    result = vamp.collect(buf, rate, plugin_key, "grid-oss")
+    path = temp_path(".csv")
+    with open(path, "wb") as f:
+        vamp.export.write_csv(result, f)
+    rows = list(csv.reader(open(path)))
+    os.remove(path)
+    values = result["matrix"][1]
+    assert len(rows) == 10
+    for i, row in enumerate(rows):
+        assert (np.array(row[1:], dtype = np.float32) == values[i]).all()
+
+def test_number_format():
+    values = np.array([ 0.1, 1, 100, 1e-6, 123456789, -2.5, 0, 1e20,
+                        np.nan, np.inf ], dtype = np.float32)
+    path = temp_path(".csv")
+    vamp.export.write_csv({ "vector": (1, values) }, path)
+    rows = list(csv.reader(open(path)))
+    os.remove(path)
+    assert [ r[1] for r in rows ] == [ "0.1", "1", "100", "1e-06", "123456790",
+                                       "-2.5", "0", "1e+20", "nan", "inf" ]
+    assert rows[3][0] == "3.000000000"
+
+def test_jsonl_stream():
+    buf = input_data(blocksize * 10)
+    path = temp_path(".jsonl")
+    vamp.export.write_jsonl(vamp.process_audio(buf, rate, plugin_key, "curve-vsr"), path)
+    lines = [ json.loads(l) for l in open(path) ]
+    os.remove(path)
+    expected = list(vamp.process_audio(buf, rate, plugin_key, "curve-vsr"))
+    assert len(lines) == len(expected) == 10
+    for l, e in zip(lines, expected):
+        assert abs(l["timestamp"] - e["timestamp"].to_float()) < 1e-9
+        assert (np.array(l["values"], dtype = np.float32) == e["values"]).all()
+
+def test_jsonl_nan_and_label():
+    features = [ { "timestamp": 1.5, "values": np.array([ np.nan, 2 ]),
+                   "label": 'say "hi"\n' } ]
+    path = temp_path(".jsonl")
+    vamp.export.write_jsonl(features, path)
+    line = json.loads(open(path).read())
+    os.remove(path)
+    assert line == { "timestamp": 1.5, "values": [ None, 2 ], "label": 'say "hi"\n' }
+
+def test_npy_npz():
+    buf = input_data(blocksize * 10)
+    result = vamp.collect(buf, rate, plugin_key, "grid-oss")
+    path = temp_path(".npy")
+    vamp.export.write_npy(result, path)
+    assert (np.load(path) == result["matrix"][1]).all()
+    os.remove(path)
+    path = temp_path(".npz")
+    vamp.export.write_npz(result, path)
+    z = np.load(path)
+    assert (z["values"] == result["matrix"][1]).all()
+    step = result["matrix"][0].to_float()
+    assert np.allclose(z["times"], np.arange(10) * step)
+    z.close()
+    os.remove(path)
+
+def test_npy_rejects_list():
+    result = vamp.collect(input_data(blocksize * 10), rate, plugin_key, "instants")
+    path = temp_path(".npy")
+    try:
+        vamp.export.write_npy(result, path)
+        assert False
+    except ValueError:
+        pass
+    finally:
+        os.remove(path)
@@ -0,0 +1,100 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+import struct
+import wave
+import os
+import tempfile
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100
+blocksize = 1024
+
+def write_pcm16(path, samples):
+    # samples: channels x frames, in [-1, 1)
+    w = wave.open(path, "wb")
+    w.setnchannels(samples.shape[0])
+    w.setsampwidth(2)
+    w.setframerate(rate)
+    w.writeframes((samples.T * 32768).astype("<i2").tobytes())
+    w.close()
+
+def write_float32(path, samples):
+    data = samples.T.astype("<f4").tobytes()
+    channels = samples.shape[0]
+    fmt = struct.pack("<HHIIHH", 3, channels, rate, rate * channels * 4,
+                      channels * 4, 32)
+    with open(path, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", 4 + 8 + len(fmt) + 8 + len(data)) + b"WAVE")
+        f.write(b"fmt " + struct.pack("<I", len(fmt)) + fmt)
+        f.write(b"data" + struct.pack("<I", len(data)) + data)
+
+def make_files(n):
+    d = tempfile.mkdtemp()
+    paths, expected = [], []
+    for i in range(n):
+        frames = blocksize * (i + 2) + 17
+        samples = ((np.arange(frames * 2) % 200) / 256.0 - 0.25).reshape(2, frames)
+        samples[1] *= -1
+        path = os.path.join(d, "f%d.wav" % i)
+        if i % 2:
+            write_float32(path, samples)
+        else:
+            write_pcm16(path, samples)
+        paths.append(path)
+        expected.append(samples.astype(np.float32))
+    return d, paths, expected
+
+def remove_files(d, paths):
+    for p in paths:
+        if os.path.exists(p):
+            os.remove(p)
+    os.rmdir(d)
+
+def test_prefetch_in_order():
+    d, paths, expected = make_files(6)
+    # small chunks and read-ahead so that files are split and held back
+    results = list(vh.FilePrefetcher(paths, 3, 20000, 4096))
+    remove_files(d, paths)
+    assert [ r[0] for r in results ] == paths
+    for (path, data, sr), e in zip(results, expected):
+        assert sr == rate
+        assert data.dtype == np.float32
+        assert data.shape == e.shape
+        assert (data == e).all()
+
+def test_prefetch_errors():
+    d, paths, expected = make_files(2)
+    bad = os.path.join(d, "not-a-wav.wav")
+    with open(bad, "wb") as f:
+        f.write(b"hello")
+    missing = os.path.join(d, "missing.wav")
+    it = vh.FilePrefetcher([ missing, paths[0], bad, paths[1] ])
+    outcomes = []
+    while True:
+        try:
+            outcomes.append(next(it)[0])
+        except StopIteration:
+            break
+        except IOError:
+            outcomes.append(None)
+    remove_files(d, paths + [ bad ])
+    assert outcomes == [ None, paths[0], None, paths[1] ]
+
+def test_abandon_early():
+    d, paths, expected = make_files(4)
+    it = vh.FilePrefetcher(paths, 2)
+    assert next(it)[0] == paths[0]
+    del it                      # workers stop with files still unread
+    remove_files(d, paths)
+
+def test_collect_files():
+    d, paths, expected = make_files(3)
+    results = list(vamp.collect_files(paths, plugin_key, "input-summary"))
+    remove_files(d, paths)
+    assert [ r[0] for r in results ] == paths
+    for (path, result), e in zip(results, expected):
+        assert (result["matrix"][1] ==
+                vamp.collect(e, rate, plugin_key, "input-summary")["matrix"][1]).all()
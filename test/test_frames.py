@@ -21,3 +21,29 @@ def test_frames_from_2d_buffer():
                   [[3,4],[9,10]],[[4,5],[10,11]],[[5,0],[11,0]]])
 
     
+
+def test_frames_keep_dtype():
+    buf = np.arange(5, dtype = np.float32)
+    ff = list(fr.frames_from_array(buf, 2, 2))
+    assert [f.dtype for f in ff] == [np.float32] * 3
+    assert to_lists(ff) == [[[0,1]],[[2,3]],[[4,0]]]
+
+def test_frame_array_view():
+    buf = np.array([np.arange(10), np.arange(10, 20)], dtype = np.float32)
+    full, tail = fr.frame_array(buf, 3, 4)
+    assert full.shape == (3, 2, 4)
+    assert tail.shape == (1, 2, 4)
+    assert full.dtype == np.float32 and tail.dtype == np.float32
+    assert np.shares_memory(full, buf)
+    assert not full.flags.writeable
+    assert (full[2] == buf[:, 6:10]).all()
+    assert (tail[0] == [[9, 0, 0, 0], [19, 0, 0, 0]]).all()
+    # strided source
+    full, tail = fr.frame_array(buf[:, ::2], 2, 2)
+    assert (full[1] == buf[:, 4:8:2]).all()
+    assert tail.shape[0] == 1
+
+def test_frame_array_short():
+    full, tail = fr.frame_array(np.arange(3), 1, 4)
+    assert full.shape == (0, 1, 4)
+    assert to_lists(tail) == [[[0,1,2,0]],[[1,2,0,0]],[[2,0,0,0]]]
@@ -0,0 +1,107 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+blocksize = 1024
+
+# The input-summary output gives, for each channel, the number of
+# non-zero samples in the block plus the value of its first sample
+
+def load(channels = 1):
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    assert plug.initialise(channels, blocksize, blocksize)
+    return plug, plug.get_output("input-summary")["output_index"]
+
+def dirty_block(dtype):
+    block = np.ones((1, blocksize), dtype = dtype)
+    block[0, 0] = np.nan
+    block[0, 5] = -np.inf
+    block[0, 6] = 1e-40
+    return block
+
+def summary(plug, index, block):
+    fs = plug.process_block(block, vh.RealTime(0, 0))
+    return fs[index][0]["values"][0]
+
+def test_unconditioned():
+    plug, index = load()
+    assert np.isnan(summary(plug, index, dirty_block(np.float32)))
+    try:
+        plug.get_input_conditioning_counts()
+        assert False
+    except Exception:
+        pass
+
+def test_scrub_block():
+    for dtype in [ np.float32, np.float64 ]:
+        plug, index = load()
+        plug.set_input_conditioning(False, True)
+        # NaN, infinity and denormal all become zero, so are not counted
+        assert summary(plug, index, dirty_block(dtype)) == blocksize - 3
+        counts = plug.get_input_conditioning_counts()
+        assert counts == { "blocks": 1, "non_finite": 2, "denormals": 1 }
+
+def test_scrub_strided_and_list():
+    plug, index = load()
+    plug.set_input_conditioning(False, True)
+    wide = np.ones((1, blocksize * 2), dtype = np.float32)
+    wide[0, 0] = np.nan
+    assert summary(plug, index, wide[:, ::2]) == blocksize - 1
+    block = [ list(dirty_block(np.float64)[0]) ]
+    assert summary(plug, index, block) == blocksize - 3
+    assert plug.get_input_conditioning_counts()["non_finite"] == 3
+
+def test_scrub_collect():
+    buf = np.ones(blocksize * 4)
+    buf[blocksize] = np.nan
+    buf[blocksize * 2 + 1] = 1e-40
+    result = vamp.collect(buf, rate, plugin_key, "input-summary",
+                          scrub_input = True)
+    values = result["vector"][1]
+    assert list(values) == [ blocksize + 1, blocksize - 1, blocksize, blocksize + 1 ]
+    # the caller's data is untouched
+    assert np.isnan(buf[blocksize])
+
+def test_scrub_collect_overlapping():
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    step = blocksize // 2
+    assert plug.initialise(1, step, blocksize)
+    plug.set_input_conditioning(False, True)
+    index = plug.get_output("input-summary")["output_index"]
+    buf = np.ones((1, blocksize * 3), dtype = np.float32)
+    buf[0, step + 1] = np.nan
+    buf[0, blocksize * 2 + 1] = np.inf
+    values = plug.collect(buf, index)
+    # each bad sample lies in two overlapping blocks, and is zeroed in
+    # both, but is counted only once
+    clean = np.concatenate((np.nan_to_num(buf[0], posinf = 0),
+                            np.zeros(step, dtype = np.float32)))
+    expected = [ np.count_nonzero(clean[i : i + blocksize]) + clean[i]
+                 for i in range(0, blocksize * 3, step) ]
+    assert list(values) == expected
+    counts = plug.get_input_conditioning_counts()
+    assert counts == { "blocks": 6, "non_finite": 2, "denormals": 0 }
+    # and the caller's data is untouched
+    assert np.isnan(buf[0, step + 1])
+
+def test_flush_denormals():
+    plug, index = load()
+    plug.set_input_conditioning(True, False)
+    # flushing does not alter the input itself
+    assert np.isnan(summary(plug, index, dirty_block(np.float32)))
+    counts = plug.get_input_conditioning_counts()
+    assert counts == { "blocks": 1, "non_finite": 0, "denormals": 0 }
+    # and the floating-point mode is restored afterwards
+    tiny = np.array([1e-38], dtype = np.float32) / np.float32(100)
+    assert tiny[0] != 0
+    plug.set_input_conditioning()
+    try:
+        plug.get_input_conditioning_counts()
+        assert False
+    except Exception:
+        pass
@@ -0,0 +1,157 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+import time
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+# As in test_collect, the plugin is expected to run with block and
+# step size of 1024
+
+blocksize = 1024
+eps = 1e-6
+
+def input_data(n):
+    # start at 1, not 0 so that all elts are non-zero
+    return np.arange(n, dtype = np.float32) + 1
+
+def wait_done(mux, streams):
+    results = dict((s, {}) for s in streams)
+    deadline = time.time() + 30
+    while not all(mux.done(s) for s in streams):
+        assert time.time() < deadline
+        for s in streams:
+            for output, fl in mux.poll(s).items():
+                results[s].setdefault(output, []).extend(fl)
+        time.sleep(0.001)
+    return results
+
+def test_multiplex_matches_process():
+    buf = input_data(blocksize * 10)
+    expected = list(vamp.process_audio(buf, rate, plugin_key, "input-timestamp"))
+    mux = vamp.Multiplexer(2, 3)
+    streams = [ mux.add_stream(rate, plugin_key, [ "input-timestamp" ])
+                for i in range(20) ]
+    # push in awkward pieces, so that blocks straddle pushes
+    for start in range(0, len(buf), 700):
+        for s in streams:
+            assert mux.push(s, buf[start : start + 700]) == len(buf[start : start + 700])
+    for s in streams:
+        mux.finish(s)
+    results = wait_done(mux, streams)
+    for s in streams:
+        actual = results[s]["input-timestamp"]
+        assert len(actual) == len(expected)
+        for i, (a, e) in enumerate(zip(actual, expected)):
+            assert a["timestamp"] == vh.frame_to_realtime(i * blocksize, rate)
+            assert a["values"][0] == e["values"][0]
+    stats = mux.stats()
+    assert stats["threads"] == 2
+    assert stats["streams"] == 20
+    assert stats["blocks"] == 20 * 10
+    assert stats["dropped_frames"] == 0
+
+def test_multiplex_block_contents():
+    buf = input_data(blocksize * 5)
+    mux = vamp.Multiplexer(1)
+    s = mux.add_stream(rate, plugin_key, [ "input-summary", "instants" ])
+    mux.push(s, buf)
+    mux.finish(s)
+    results = wait_done(mux, [s])[s]
+    summary = results["input-summary"]
+    assert len(summary) == 5
+    for i in range(5):
+        assert summary[i]["values"][0] == blocksize + i * blocksize + 1
+    # remaining features, from getRemainingFeatures
+    assert len(results["instants"]) == 10
+
+def test_multiplex_multichannel():
+    buf = np.array([input_data(blocksize * 3), input_data(blocksize * 3) * 2])
+    mux = vamp.Multiplexer(1)
+    s = mux.add_stream(rate, plugin_key, [ "input-summary" ], channels = 2)
+    mux.push(s, buf)
+    mux.finish(s)
+    summary = wait_done(mux, [s])[s]["input-summary"]
+    assert len(summary) == 3
+    assert summary[1]["values"][0] == blocksize + blocksize + 1
+    assert summary[1]["values"][1] == blocksize + (blocksize + 1) * 2
+
+def test_multiplex_ring_overflow():
+    mux = vamp.Multiplexer(1)
+    s = mux.add_stream(rate, plugin_key, [ "input-timestamp" ],
+                       ring_seconds = blocksize * 4 / rate)
+    accepted = mux.push(s, input_data(blocksize * 100))
+    assert accepted < blocksize * 100
+    assert mux.stats()["dropped_frames"] == blocksize * 100 - accepted
+    mux.remove_stream(s)
+    assert mux.stats()["streams"] == 0
+
+def test_multiplex_step_larger_than_block():
+    buf = input_data(18000)
+    mux = vamp.Multiplexer(1)
+    s = mux.add_stream(rate, plugin_key, [ "input-summary" ],
+                       step_size = blocksize * 4, block_size = blocksize)
+    for start in range(0, len(buf), 1000):
+        assert mux.push(s, buf[start : start + 1000]) == len(buf[start : start + 1000])
+    mux.finish(s)
+    summary = wait_done(mux, [s])[s]["input-summary"]
+    # blocks start at 0, 4096, 8192, 12288 and 16384; the frames
+    # between them are never stored
+    assert len(summary) == 5
+    for i in range(5):
+        assert summary[i]["values"][0] == blocksize + i * blocksize * 4 + 1
+    stats = mux.stats()
+    assert stats["blocks"] == 5
+    assert stats["dropped_frames"] == 0
+
+def test_multiplex_errors():
+    mux = vamp.Multiplexer(1)
+    s = mux.add_stream(rate, plugin_key)
+    mux.finish(s)
+    try:
+        mux.push(s, input_data(blocksize))
+        assert False
+    except ValueError:
+        pass
+    mux.remove_stream(s)
+    try:
+        mux.push(s, input_data(blocksize))
+        assert False
+    except KeyError:
+        pass
+    try:
+        vh.StreamMultiplexer(1).push(0, input_data(blocksize))
+        assert False
+    except KeyError:
+        pass
+    first = vh.get_outputs_of(plugin_key)[0]
+    try:
+        mux.add_stream(rate, plugin_key, outputs = [ "", first ])
+        assert False
+    except ValueError:
+        pass
+    try:
+        mux.add_stream(rate, plugin_key, outputs = [ "not-an-output" ])
+        assert False
+    except Exception:
+        pass
+
+def test_multiplex_takes_plugin():
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    assert plug.initialise(1, blocksize, blocksize)
+    mux = vh.StreamMultiplexer(1)
+    s = mux.add_stream(plug)
+    try:
+        plug.reset()
+        assert False
+    except Exception:
+        pass
+    try:
+        mux.add_stream(plug)
+        assert False
+    except TypeError:
+        pass
+    mux.remove_stream(s)
@@ -24,6 +24,20 @@ def test_plugin_exists_module():
 def test_plugin_exists_in_freq_version():
     assert plugin_key_freq in vh.list_plugins()
 
+def test_list_plugins_order():
+    plugins = vh.list_plugins()
+    assert plugins == sorted(plugins)
+    assert vh.list_plugins(None, None) == plugins
+    assert vamp.list_plugins(include = [ "*" ]) == plugins
+
+def test_list_plugins_patterns():
+    assert plugin_key in vamp.list_plugins(include = [ "vamp-test-*" ])
+    assert plugin_key in vamp.list_plugins(include = [ "nonesuch", "VAMP-TEST-PLUGIN" ])
+    assert plugin_key in vamp.list_plugins(include = [ "vamp-?est-plugin" ])
+    assert plugin_key not in vamp.list_plugins(include = [ "vamp-test" ])
+    assert plugin_key not in vamp.list_plugins(exclude = [ "*test*" ])
+    assert plugin_key_freq not in vamp.list_plugins(include = [ "*" ], exclude = [ "vamp-test-plugin" ])
+
 def test_getoutputlist():
     outputs = vh.get_outputs_of(plugin_key)
     assert len(outputs) == 11
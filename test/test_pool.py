@@ -0,0 +1,71 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+blocksize = 1024
+eps = 1e-6
+
+def segment(t, d = None):
+    f = { "timestamp": vh.RealTime('seconds', t), "label": "" }
+    if d is not None:
+        f["duration"] = vh.RealTime('seconds', d)
+    return f
+
+def test_pool_segments_methods():
+    m = np.array([[1, 2], [3, 4], [5, 6], [7, 8]])
+    starts = np.array([0.0, 2.0])
+    ends = np.array([2.0, 4.0])
+    pooled = vh.pool_segments(m, 1.0, starts, ends, "mean")
+    assert pooled.shape == (2, 2)
+    assert (abs(pooled - np.array([[2, 3], [6, 7]])) < eps).all()
+    pooled = vh.pool_segments(m, 1.0, starts, ends, "max")
+    assert (pooled == np.array([[3, 4], [7, 8]])).all()
+    pooled = vh.pool_segments(m, 1.0, starts, ends, "min")
+    assert (pooled == np.array([[1, 2], [5, 6]])).all()
+    pooled = vh.pool_segments(m, 1.0, starts, ends, "sum")
+    assert (pooled == np.array([[4, 6], [12, 14]])).all()
+    pooled = vh.pool_segments(m, 1.0, starts, ends, "std")
+    assert (abs(pooled - 1.0) < eps).all()
+
+def test_pool_segments_overlap_and_range():
+    v = np.arange(10, dtype = np.float32)
+    # A segment shorter than one step takes the row containing its
+    # start; a partial overlap takes in the whole row; a segment
+    # beyond the end gets NaN
+    pooled = vh.pool_segments(v, 0.5, np.array([1.1, 2.25, 20.0]),
+                              np.array([1.2, 3.25, 21.0]), "mean")
+    assert pooled.shape == (3,)
+    assert pooled[0] == 2
+    assert abs(pooled[1] - 5) < eps
+    assert np.isnan(pooled[2])
+
+def test_pool_segments_bad_method():
+    try:
+        vh.pool_segments(np.zeros((4, 2)), 1.0, [0.0], [1.0], "median")
+        assert False
+    except ValueError:
+        pass
+
+def test_pool_features():
+    step = vh.RealTime('seconds', 0.5)
+    m = np.array([[i, 2 * i] for i in range(8)], np.float32)
+    segs = [ segment(0.0), segment(1.0, 0.5), segment(2.0) ]
+    times, pooled = vamp.pool({ "matrix": (step, m) }, { "list": segs })
+    assert times == [ s["timestamp"] for s in segs ]
+    # the first segment runs to the start of the second, the last to
+    # the end of the matrix
+    assert (abs(pooled - np.array([[0.5, 1], [2, 4], [5.5, 11]])) < eps).all()
+
+def test_pool_collected():
+    buf = np.arange(blocksize * 10) + 1
+    grid = vamp.collect(buf, rate, plugin_key, "grid-oss")
+    step, values = grid["matrix"]
+    regions = vamp.collect(buf, rate, plugin_key, "notes-regions")
+    times, pooled = vamp.pool(grid, regions, "max")
+    assert len(times) == len(regions["list"])
+    assert pooled.shape == (len(times), values.shape[1])
@@ -1,5 +1,7 @@
 
 import vamp
+import pickle
+import copy
 
 def test_basic_conf_compare_sec():
     r1 = vamp.vampyhost.RealTime('seconds', 0)
@@ -107,3 +109,25 @@ def test_add_subtract():
     assert r2 - r1 == vamp.vampyhost.RealTime('milliseconds', 200)
     assert r1 - r2 == vamp.vampyhost.RealTime('milliseconds', -200)
     
+def test_other_types():
+    r = vamp.vampyhost.RealTime('seconds', 1)
+    assert not (r == 1)
+    assert r != "1"
+    for op in [ lambda: r < 1, lambda: r + 1, lambda: 1 - r ]:
+        try:
+            op()
+            assert False
+        except TypeError:
+            pass
+
+
+def test_pickle():
+    for r in [ vamp.vampyhost.RealTime(),
+               vamp.vampyhost.RealTime(2, 34),
+               vamp.vampyhost.RealTime('seconds', 1.5),
+               vamp.vampyhost.RealTime('milliseconds', -200) ]:
+        for protocol in range(pickle.HIGHEST_PROTOCOL + 1):
+            r2 = pickle.loads(pickle.dumps(r, protocol))
+            assert r2 == r
+            assert r2.values() == r.values()
+        assert copy.deepcopy(r) == r
@@ -0,0 +1,131 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+# As in test_collect, the plugin is expected to run with block and
+# step size of 1024
+
+blocksize = 1024
+eps = 1e-6
+
+def input_data(n):
+    # start at 1, not 0 so that all elts are non-zero
+    return np.arange(n, dtype = np.float32) + 1
+
+def run_blocks(plug, n, start = 0):
+    for i in range(start, start + n):
+        block = input_data(blocksize).reshape((1, blocksize))
+        plug.process_block(block, vh.frame_to_realtime(i * blocksize, rate))
+
+def load():
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    assert plug.initialise(1, blocksize, blocksize)
+    return plug
+
+def test_rolling_keeps_latest():
+    plug = load()
+    index = plug.get_output("input-timestamp")["output_index"]
+    plug.attach_rolling(index, 4)
+    run_blocks(plug, 2)
+    times, values = plug.rolling_snapshot(index, True)
+    assert (values == np.array([0, 1]) * blocksize).all()
+    run_blocks(plug, 8, 2)
+    times, values = plug.rolling_snapshot(index, True)
+    assert (values == np.array([6, 7, 8, 9]) * blocksize).all()
+    assert (abs(times - np.array([6, 7, 8, 9]) * blocksize / rate) < eps).all()
+    plug.unload()
+
+def test_rolling_views():
+    plug = load()
+    index = plug.get_output("input-timestamp")["output_index"]
+    plug.attach_rolling(index, 4)
+    run_blocks(plug, 10)
+    segments = plug.rolling_snapshot(index)
+    assert len(segments) == 2
+    values = np.concatenate([ v for (t, v) in segments ])
+    assert (values == np.array([6, 7, 8, 9]) * blocksize).all()
+    assert not segments[0][1].flags.writeable
+    # Views remain valid after the collector has gone
+    plug.detach_rolling(index)
+    plug.unload()
+    assert segments[1][1][1] == 9 * blocksize
+
+def test_rolling_list():
+    plug = load()
+    index = plug.get_output("curve-vsr")["output_index"]
+    plug.attach_rolling(index, 3)
+    run_blocks(plug, 10)
+    plug.get_remaining_features()
+    features = plug.rolling_snapshot(index)
+    assert len(features) == 3
+    for i in range(3):
+        assert features[i]["timestamp"] == vh.RealTime('seconds', (i + 7) * 0.75)
+        assert abs(features[i]["values"][0] - (i + 7) * 0.1) < eps
+    plug.unload()
+
+def test_rolling_reset():
+    plug = load()
+    index = plug.get_output("input-timestamp")["output_index"]
+    plug.attach_rolling(index, 4)
+    run_blocks(plug, 3)
+    plug.reset()
+    times, values = plug.rolling_snapshot(index, True)
+    assert len(values) == 0
+    plug.unload()
+
+def test_rolling_processor():
+    rp = vamp.RollingProcessor(rate, plugin_key, [ "input-timestamp", "grid-oss" ],
+                               seconds = 4.5 * blocksize / rate,
+                               transforms = [ "l2" ])
+    buf = input_data(blocksize * 10)
+    # feed in pieces that don't line up with blocks
+    for i in range(0, len(buf), 1000):
+        rp.feed(buf[i : i + 1000])
+    times, values = rp.snapshot("input-timestamp")["vector"]
+    assert (abs(times - np.array([5, 6, 7, 8, 9]) * blocksize / rate) < eps).all()
+    # l2 normalisation of a single value leaves just its sign
+    assert (values == 1).all()
+    times, values = rp.snapshot("grid-oss")["matrix"]
+    assert values.shape == (5, 10)
+    for i in range(5):
+        expected = np.array([ (j + i + 7.0) / 30.0 for j in range(0, 10) ])
+        expected = expected / np.sqrt((expected * expected).sum())
+        assert (abs(values[i] - expected) < eps).all()
+    segments = rp.snapshot("grid-oss", contiguous = False)["matrix"]
+    assert (np.concatenate([ v for (t, v) in segments ]) == values).all()
+    rp.unload()
+
+def test_rolling_finish_overlapping():
+    step = blocksize // 4
+    buf = input_data(blocksize * 4)
+    rp = vamp.RollingProcessor(rate, plugin_key, [ "input-timestamp" ],
+                               seconds = 1.0, step_size = step,
+                               block_size = blocksize)
+    rp.feed(buf)
+    rp.finish()
+    times, values = rp.snapshot("input-timestamp")["vector"]
+    rp.unload()
+    # the trailing overlapping blocks are processed too
+    expected = vamp.collect(buf, rate, plugin_key, "input-timestamp",
+                            step_size = step, block_size = blocksize)
+    assert len(values) == len(buf) // step
+    assert (values == expected["vector"][1]).all()
+
+def test_rolling_fail():
+    plug = load()
+    try:
+        plug.rolling_snapshot(0)
+        assert False
+    except ValueError:
+        pass
+    try:
+        plug.attach_rolling(plug.get_output("curve-vsr")["output_index"], 10, [ "l2" ])
+        assert False
+    except ValueError:
+        pass
+    plug.unload()
@@ -0,0 +1,84 @@
+
+import vamp
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+eps = 1e-5
+
+def reference(m, metric):
+    m = np.asarray(m, dtype = np.float64)
+    if metric == "cosine":
+        norms = np.sqrt((m * m).sum(axis = 1))
+        norms[norms == 0] = 1.0
+        u = m / norms[:, np.newaxis]
+        return u.dot(u.T)
+    else:
+        d = m[:, np.newaxis, :] - m[np.newaxis, :, :]
+        return np.sqrt((d * d).sum(axis = 2))
+
+def test_self_similarity_cosine():
+    m = np.random.RandomState(1).rand(150, 12) - 0.5
+    m[7] = 0
+    s = vh.self_similarity(m, "cosine")
+    assert s.shape == (150, 150)
+    assert s.dtype == np.float32
+    assert (abs(s - reference(m, "cosine")) < eps).all()
+    assert (s == s.T).all()
+    assert s[7, 7] == 0
+
+def test_self_similarity_euclidean():
+    m = np.random.RandomState(2).rand(200, 5)
+    s = vh.self_similarity(m, "euclidean", -1, False, 3)
+    assert s.shape == (200, 200)
+    assert (abs(s - reference(m, "euclidean")) < eps).all()
+    assert (np.diag(s) == 0).all()
+
+def test_self_similarity_vector():
+    v = np.array([1.0, 3.0, 6.0])
+    s = vh.self_similarity(v, "euclidean")
+    assert (abs(s - np.array([[0, 2, 5], [2, 0, 3], [5, 3, 0]])) < eps).all()
+
+def test_self_similarity_banded():
+    m = np.random.RandomState(3).rand(130, 4)
+    full = reference(m, "euclidean")
+    s = vh.self_similarity(m, "euclidean", 3)
+    assert s.shape == (130, 4)
+    for i in range(130):
+        for k in range(4):
+            if i + k < 130:
+                assert abs(s[i, k] - full[i, i + k]) < eps
+            else:
+                assert np.isnan(s[i, k])
+
+def test_self_similarity_half():
+    m = np.random.RandomState(4).rand(70, 8)
+    s = vh.self_similarity(m, "euclidean")
+    h = vh.self_similarity(m, "euclidean", -1, True)
+    assert h.dtype == np.float16
+    assert (h == s.astype(np.float16)).all()
+    h = vh.self_similarity(m, "cosine", 2, True)
+    assert np.isnan(h[69, 1])
+    s = vh.self_similarity(m, "cosine", 2)
+    assert (h[:68] == s[:68].astype(np.float16)).all()
+
+def test_self_similarity_bad_metric():
+    try:
+        vh.self_similarity(np.zeros((2, 2)), "manhattan")
+        assert False
+    except ValueError:
+        pass
+
+def test_self_similarity_of_collect():
+    buf = np.ones((1, 44100 * 2), dtype = np.float32)
+    rdict = vamp.collect(buf, rate, plugin_key, "grid-oss")
+    step, m = rdict["matrix"]
+    s = vamp.self_similarity(rdict, "euclidean")
+    assert s.shape == (len(m), len(m))
+    assert (abs(s - reference(m, "euclidean")) < eps).all()
+    s = vamp.self_similarity(rdict, band = 2, dtype = np.float16)
+    assert s.shape == (len(m), 3)
+    assert s.dtype == np.float16
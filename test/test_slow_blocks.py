@@ -0,0 +1,93 @@
+
+import vampyhost as vh
+import numpy as np
+
+plugin_key = "vamp-test-plugin:vamp-test-plugin"
+
+rate = 44100.0
+
+blocksize = 1024
+
+def load(channels = 1):
+    plug = vh.load_plugin(plugin_key, rate, vh.ADAPT_NONE)
+    assert plug.initialise(channels, blocksize, blocksize)
+    return plug
+
+def test_not_watching():
+    plug = load()
+    try:
+        plug.get_slow_blocks()
+        assert False
+    except Exception:
+        pass
+
+def test_absolute_threshold():
+    plug = load()
+    # every block takes longer than a nanosecond
+    plug.watch_slow_blocks(1e-9)
+    block = np.ones((1, blocksize), dtype = np.float32) * 0.5
+    block[0, 3] = -0.75
+    block[0, 10] = np.nan
+    block[0, 11] = np.inf
+    block[0, 12] = 1e-40
+    plug.process_block(block, vh.frame_to_realtime(blocksize * 2, rate))
+    slow = plug.get_slow_blocks()
+    assert len(slow) == 1
+    b = slow[0]
+    assert b["plugin_key"] == plugin_key
+    assert b["timestamp"] == vh.frame_to_realtime(blocksize * 2, rate)
+    assert b["duration"] > 0
+    assert b["non_finite"] == 2
+    assert b["denormals"] == 1
+    assert b["peak"] == 0.75
+    assert abs(b["rms"] - np.sqrt((0.25 * (blocksize - 4) + 0.75 ** 2) / (blocksize - 2))) < 1e-6
+    assert "block" not in b
+    # cleared once fetched
+    assert plug.get_slow_blocks() == []
+
+def test_bounded_log_and_kept_blocks():
+    plug = load(2)
+    plug.watch_slow_blocks(1e-9, 0, 3, True)
+    buf = np.arange(blocksize * 10 * 2, dtype = np.float32).reshape((2, blocksize * 10))
+    plug.collect(buf, 0)
+    stats = plug.get_slow_block_stats()
+    assert stats["blocks"] == 10
+    assert stats["slow"] == 10
+    slow = plug.get_slow_blocks(False)
+    # only the last three are kept
+    assert len(slow) == 3
+    for i, b in enumerate(slow):
+        start = (7 + i) * blocksize
+        assert b["timestamp"] == vh.frame_to_realtime(start, rate)
+        assert (b["block"] == buf[:, start : start + blocksize]).all()
+    assert len(plug.get_slow_blocks()) == 3
+
+def test_relative_threshold():
+    plug = load()
+    # nothing takes a million times longer than typical
+    plug.watch_slow_blocks(0, 1e6)
+    plug.collect(np.ones(blocksize * 50, dtype = np.float32), 0)
+    assert plug.get_slow_blocks() == []
+    stats = plug.get_slow_block_stats()
+    assert stats["blocks"] == 50
+    assert stats["slow"] == 0
+    assert stats["mean_duration"] > 0
+    # every block takes more than a millionth of the typical duration,
+    # so each one after the first eight (which set the running mean)
+    # is reported, with the typical duration it was compared against
+    plug.watch_slow_blocks(0, 1e-6)
+    plug.collect(np.ones(blocksize * 50, dtype = np.float32), 0)
+    slow = plug.get_slow_blocks()
+    assert len(slow) == 42
+    assert slow[0]["timestamp"] == vh.frame_to_realtime(blocksize * 8, rate)
+    for b in slow:
+        assert b["typical"] > 0
+        assert b["duration"] > 1e-6 * b["typical"]
+    assert plug.get_slow_block_stats()["slow"] == 42
+    # stop watching
+    plug.watch_slow_blocks()
+    try:
+        plug.get_slow_block_stats()
+        assert False
+    except Exception:
+        pass
@@ -89,7 +89,7 @@ And a pitch-chroma plot appears.
 High-level interface (vamp)
 ---------------------------
 
-This module contains three sorts of function:
+This module contains eleven sorts of function:
 
 1. Basic info and lookup functions
 """"""""""""""""""""""""""""""""""
@@ -126,12 +126,26 @@ This module contains three sorts of function:
 """""""""""""""""""""""""""""""""""
    
    * ``vamp.collect``
+   * ``vamp.collect_clips``
+   * ``vamp.collect_files``
 
    This accepts a single array of audio samples as input, and returns
    an output structure that reflects the underlying structure of the
    feature output (depending on whether it is a curve, grid, etc). The
    plugin to be used is specified by its key. A dictionary of plugin
-   parameter settings may optionally be supplied.
+   parameter settings may optionally be supplied, as may a list of
+   transforms (such as dB scaling or normalisation) to be applied
+   natively to each feature as it is collected, and a memory limit
+   beyond which collected values are spilled to a temporary file and
+   returned as a memory-mapped array. Mostly-zero grid outputs may be
+   returned as SciPy sparse matrices instead of dense arrays. Several
+   outputs of the same plugin may be collected at once, from a single
+   processing pass, by passing a list of output identifiers.
+   The ``collect_clips`` function does the same for each of a list of
+   short clips, reusing a single plugin instance for all of them.
+   The ``collect_files`` function does it for each of a list of WAV
+   files, which are read and decoded natively on a pool of threads,
+   ahead of their processing.
 
    The ``collect`` function processes the whole input before returning
    anything; if you need to supply a streamed input, or retrieve
@@ -139,6 +153,118 @@ This module contains three sorts of function:
    ``process`` functions (above) or else the low-level interface
    (below).
 
+4. Post-processing functions
+""""""""""""""""""""""""""""
+
+   * ``vamp.pool``
+   * ``vamp.self_similarity``
+
+   These operate on the structures returned by ``vamp.collect``.
+   The ``pool`` function summarises a vector or matrix output over
+   the time segments given by an event or segment output (for
+   example, chroma averaged per beat), returning one row of pooled
+   values per segment. The ``self_similarity`` function compares
+   every step of a vector or matrix output with every other, by
+   cosine similarity or Euclidean distance, returning either the
+   full square matrix or just a band about its diagonal.
+
+5. Rolling collection for live streams
+""""""""""""""""""""""""""""""""""""""
+
+   * ``vamp.RollingProcessor``
+
+   This runs a plugin over audio supplied a piece at a time, keeping
+   the last few seconds of features from each requested output in a
+   fixed-size native ring buffer. A snapshot of each output is
+   available at any time, in the same structure as ``vamp.collect``
+   returns but with a timestamp per feature, either copied or as
+   views of the ring buffer. Memory use stays constant however long
+   the stream runs.
+
+6. Admission control for services
+"""""""""""""""""""""""""""""""""
+
+   * ``vamp.Admission``
+
+   This limits how many processing calls a service runs at once,
+   overall and per plugin, queueing the rest in an "interactive" or
+   a "batch" priority lane. Interactive calls are admitted first and
+   may have running slots reserved for them; calls are rejected at
+   once when the queue is full, or after a timeout, with
+   ``vamp.AdmissionError``. Counts and waiting times for each lane
+   are available through ``metrics``.
+
+7. Cascaded processing
+""""""""""""""""""""""
+
+   * ``vamp.cascade``
+
+   This runs a cheap "gate" plugin, such as an energy or voice
+   activity detector, over the whole of the audio, and then runs an
+   expensive plugin only over the regions in which the gate's output
+   passes a threshold or predicate. Each region is processed
+   natively from a reset, with an optional pre-roll, and the results
+   are returned per region with timestamps relative to the start of
+   the whole audio.
+
+8. Multiplexing many live streams
+"""""""""""""""""""""""""""""""""
+
+   * ``vamp.Multiplexer``
+
+   This runs many live streams, each with its own plugin instance, on
+   a small fixed pool of native worker threads rather than a thread
+   per stream. Audio for each stream is pushed into its own ring
+   buffer; the workers take the streams with whole blocks ready in
+   turn, processing a batch of blocks from each, and the features for
+   each stream are collected as they become available through
+   ``poll``.
+
+9. Cost profiling
+"""""""""""""""""
+
+   * ``vamp.costs.profile``
+   * ``vamp.costs.report``
+   * ``vamp.costs.ProfileDatabase``
+
+   These measure, for each installed plugin and each of a set of
+   configurations (channel count, step and block size), the time
+   taken to load and initialise the plugin, to process each block
+   and to return its remaining features, and the volume of features
+   it produces. The measurements may be kept in an SQLite profile
+   database, from which a report of the predicted real-time factor
+   and output memory per hour of audio is produced, for use in
+   scheduling and capacity planning. The same is available from the
+   command line as ``python -m vamp.costs``.
+
+10. Exporting features
+""""""""""""""""""""""
+
+   * ``vamp.export.write_csv``
+   * ``vamp.export.write_jsonl``
+   * ``vamp.export.write_npy``
+   * ``vamp.export.write_npz``
+
+   These write the result of ``vamp.collect``, or the features from
+   a streaming run such as ``vamp.process_audio``, to a file as CSV
+   (in the column layout used by Sonic Annotator), JSON Lines, or
+   NumPy NPY or NPZ. The formatting and writing are done natively,
+   straight from the feature buffers.
+
+11. Clip archives
+"""""""""""""""""
+
+   * ``vamp.archive.pack``
+   * ``vamp.archive.pack_files``
+   * ``vamp.archive.collect_archive``
+
+   These pack many short clips of audio into a single archive file,
+   and process every clip in an archive with a plugin, yielding the
+   result for each clip keyed by its id. Clips are read straight from
+   a memory mapping of the archive, and one plugin instance is reused,
+   with a reset between clips. The same can be done from the command
+   line with ``python -m vamp.archive``.
+
 
 Low-level interface (vampyhost)
 -------------------------------
@@ -146,11 +272,25 @@ Low-level interface (vampyhost)
 This extension contains facilities that operate on Vamp plugins in a
 way analogous to the existing C++ Vamp Host SDK: ``list_plugins``,
 ``get_plugin_path``, ``get_category_of``, ``get_library_for``,
-``get_outputs_of``, ``load_plugin``, and a utility function
-``frame_to_realtime``.
+``get_outputs_of``, ``load_plugin``, and the utility functions
+``frame_to_realtime``, ``frame_view``, ``pool_segments``,
+``self_similarity``, ``write_features``, ``write_feature_rows``,
+``write_npy``, and ``write_npz``, and the
+``AdmissionControl``, ``StreamMultiplexer`` and ``FilePrefetcher``
+types.
 
 Calling ``load_plugin`` gets you a ``vampyhost.Plugin`` object, which
 then exposes all of the methods found in the Vamp SDK Plugin class.
+The blocks passed to the plugin by its ``process_block``,
+``collect``, ``collect_regions`` and ``process_clips`` methods may be
+timed, with slow blocks logged, using ``watch_slow_blocks``, and
+their input conditioned (denormals flushed, NaN and infinite samples
+scrubbed) using ``set_input_conditioning``.
+
+Other native extensions, such as audio decoders, can drive plugins
+without going through Python at all, using the versioned C API that
+vampyhost exports as the capsule ``vampyhost._C_API``. It is
+declared, with instructions, in the header ``VampyHostAPI.h``.
 
 (Note that methods wrapped directly from the Vamp SDK are named using
 camelCase, so as to match the names found in the C++ SDK. Elsewhere
@@ -165,5 +305,11 @@ import vampyhost
 
 from vamp.load import list_plugins, get_outputs_of, get_parameters_of, get_category_of
 from vamp.process import process_audio, process_frames, process_audio_multiple_outputs, process_frames_multiple_outputs
-from vamp.collect import collect
+from vamp.collect import collect, collect_clips, collect_files
+from vamp.pool import pool
+from vamp.similarity import self_similarity
+from vamp.rolling import RollingProcessor
+from vamp.admission import Admission, AdmissionError
+from vamp.cascade import cascade
+from vamp.multiplex import Multiplexer
 
@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+from vamp.collect import collect
+from vamp.process import process_audio
+
+from contextlib import contextmanager
+
+AdmissionError = vampyhost.AdmissionError
+
+lanes = { "interactive": vampyhost.LANE_INTERACTIVE,
+          "batch": vampyhost.LANE_BATCH }
+
+class Admission(object):
+    """Admission control for a service that runs Vamp plugins on
+    behalf of many clients at once.
+
+    At most max_running processing calls are allowed to run at the
+    same time, and, if max_running_per_key is not 0, at most that
+    many for any single plugin key. Calls beyond those limits wait
+    in one of two priority lanes, "interactive" or "batch". Waiting
+    interactive calls are always admitted before waiting batch calls,
+    and interactive_reserve of the running slots are kept for
+    interactive calls alone, so that a backlog of batch work cannot
+    starve them. Within a lane, calls are admitted in the order they
+    arrived.
+
+    If max_queued is not None, a call that would take the number of
+    calls waiting in its lane beyond it is rejected at once with
+    AdmissionError, rather than being queued: this lets an overloaded
+    service shed load quickly instead of building up an unbounded
+    backlog. Each lane has its own limit, so a full batch queue does
+    not turn away interactive calls.
+
+    The limiting and queueing is done natively and without holding
+    the Python interpreter lock, so an Admission object may be shared
+    between threads.
+    """
+
+    def __init__(self, max_running, max_running_per_key = 0, max_queued = None, interactive_reserve = 0):
+        if max_queued is None:
+            max_queued = -1
+        self.control = vampyhost.AdmissionControl(max_running,
+                                                  max_running_per_key,
+                                                  max_queued,
+                                                  interactive_reserve)
+
+    @contextmanager
+    def admit(self, plugin_key, lane = "interactive", timeout = None):
+        """Wait for admission of a call to the given plugin in the given
+        lane ("interactive" or "batch"), then run the body of the with
+        statement, releasing the slot when it exits. The value bound by
+        the with statement is the time in seconds spent waiting.
+
+        Raises AdmissionError if the call is rejected because the queue
+        is full, or if timeout is not None and the call has not been
+        admitted within timeout seconds.
+        """
+        if lane not in lanes:
+            raise ValueError("Unknown lane \"" + str(lane) + "\": expected \"interactive\" or \"batch\"")
+        if timeout is None:
+            timeout = -1.0
+        waited = self.control.acquire(plugin_key, lanes[lane], float(timeout))
+        try:
+            yield waited
+        finally:
+            self.control.release(plugin_key, lanes[lane])
+
+    def collect(self, data, sample_rate, plugin_key, output = "", parameters = {}, lane = "interactive", timeout = None, **kwargs):
+        """Run vamp.collect() once admitted in the given lane. All other
+        arguments are as for vamp.collect().
+        """
+        with self.admit(plugin_key, lane, timeout):
+            return collect(data, sample_rate, plugin_key,
+                           output, parameters, **kwargs)
+
+    def process_audio(self, data, sample_rate, plugin_key, output = "", parameters = {}, lane = "interactive", timeout = None, **kwargs):
+        """Run vamp.process_audio() once admitted in the given lane,
+        yielding its features. The slot is held until the generator is
+        exhausted or closed. All other arguments are as for
+        vamp.process_audio().
+        """
+        with self.admit(plugin_key, lane, timeout):
+            for f in process_audio(data, sample_rate, plugin_key,
+                                   output, parameters, **kwargs):
+                yield f
+
+    def metrics(self):
+        """Return a dictionary mapping each lane name to a dictionary of
+        counts of calls admitted, rejected, timed_out, currently queued
+        and currently running in that lane, and the total, maximum, and
+        mean seconds that admitted calls spent waiting (wait_total,
+        wait_max, wait_mean).
+        """
+        return self.control.metrics()
@@ -0,0 +1,316 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+import vamp.load
+import vamp.export
+from vamp.collect import clip_outputs, shape_clip_results
+
+import numpy as np
+import argparse
+import struct
+import mmap
+import sys
+import os
+
+# A clip archive holds many short clips of audio in one file, so that
+# they can be read from a single memory mapping rather than opened
+# one by one. All values are little-endian. The file starts with a
+# 64-byte header:
+#
+#   magic "VAMPCLIP", version (u32), sample format (u32: 0 for float32,
+#   1 for int16), clip count (u64), index offset (u64), ids offset
+#   (u64), ids size (u64), then zero padding
+#
+# followed by the clips' samples, each clip one channel after another
+# and starting on a 64-byte boundary, then the index (an array of
+# records of index_dtype, one per clip), then the clip ids (UTF-8,
+# concatenated, located by the index records).
+
+MAGIC = b"VAMPCLIP"
+VERSION = 1
+HEADER = struct.Struct("<8sIIQQQQ16x")
+ALIGNMENT = 64
+
+sample_formats = { "float32": 0, "int16": 1 }
+sample_dtypes = { 0: np.dtype("<f4"), 1: np.dtype("<i2") }
+
+index_dtype = np.dtype([ ("offset", "<u8"),
+                         ("frames", "<u8"),
+                         ("sample_rate", "<f8"),
+                         ("id_offset", "<u8"),
+                         ("id_length", "<u4"),
+                         ("channels", "<u4") ])
+
+class ArchiveWriter(object):
+    """Write a clip archive, adding clips one at a time.
+
+    The sample_format is "float32", from which clips can be processed
+    without copying, or "int16", which takes half the space and is
+    converted when processed. Clips are written as they are added;
+    the index is written on close(). Used in a with statement, the
+    archive is deleted instead if the body raises an exception.
+    """
+
+    def __init__(self, path, sample_format = "float32"):
+        if sample_format not in sample_formats:
+            raise ValueError("Unknown sample format \"" + str(sample_format) + "\": expected float32 or int16")
+        self.format = sample_formats[sample_format]
+        self.file = open(path, "wb")
+        self.file.write(b"\0" * HEADER.size)
+        self.position = HEADER.size
+        self.records = []
+        self.ids = []
+        self.ids_size = 0
+        self.seen = set()
+
+    def add(self, id, samples, sample_rate):
+        """Add a clip with the given id (a string), samples (a 1D array, or
+        2D with one row per channel), and sample rate."""
+        if id in self.seen:
+            raise ValueError("Duplicate clip id \"" + id + "\"")
+        samples = np.asarray(samples)
+        if samples.ndim == 1:
+            samples = samples.reshape(1, -1)
+        if samples.ndim != 2:
+            raise ValueError("Clip samples must be a one- or two-dimensional array")
+        if self.format == 0:
+            payload = np.ascontiguousarray(samples, dtype = "<f4")
+        else:
+            payload = np.clip(np.round(np.asarray(samples, dtype = np.float64) * 32768.0),
+                              -32768, 32767).astype("<i2")
+        pad = -self.position % ALIGNMENT
+        self.file.write(b"\0" * pad)
+        self.position += pad
+        encoded = id.encode("utf-8")
+        self.records.append((self.position, payload.shape[1], float(sample_rate),
+                             self.ids_size, len(encoded), payload.shape[0]))
+        self.ids.append(encoded)
+        self.seen.add(id)
+        self.ids_size += len(encoded)
+        self.file.write(payload.tobytes())
+        self.position += payload.nbytes
+
+    def close(self):
+        pad = -self.position % ALIGNMENT
+        self.file.write(b"\0" * pad)
+        index_offset = self.position + pad
+        index = np.array(self.records, dtype = index_dtype)
+        self.file.write(index.tobytes())
+        ids_offset = index_offset + index.nbytes
+        self.file.write(b"".join(self.ids))
+        self.file.seek(0)
+        self.file.write(HEADER.pack(MAGIC, VERSION, self.format, len(self.records),
+                                    index_offset, ids_offset, self.ids_size))
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def abandon(self):
+        """Close and delete the archive without completing it, as when
+        adding a clip has failed."""
+        path = self.file.name
+        self.file.close()
+        os.remove(path)
+
+    def __exit__(self, type, value, traceback):
+        if type is None:
+            self.close()
+        else:
+            self.abandon()
+
+class ClipArchive(object):
+    """Read a clip archive through a memory mapping.
+
+    The index attribute is a structured array of the offset, frames,
+    sample_rate, id_offset, id_length and channels of every clip,
+    itself a view of the mapping. Samples are returned as read-only
+    views of the mapping, without copying.
+    """
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access = mmap.ACCESS_READ)
+        if len(self.map) < HEADER.size:
+            self.close()
+            raise ValueError("\"" + path + "\" is not a clip archive")
+        magic, version, fmt, count, index_offset, ids_offset, ids_size = \
+            HEADER.unpack_from(self.map, 0)
+        if magic != MAGIC or version != VERSION or fmt not in sample_dtypes:
+            self.close()
+            raise ValueError("\"" + path + "\" is not a clip archive of a supported version")
+        self.dtype = sample_dtypes[fmt]
+        self.sample_format = [ k for k, v in sample_formats.items() if v == fmt ][0]
+        self.index = np.frombuffer(self.map, dtype = index_dtype,
+                                   count = count, offset = index_offset)
+        self.ids_offset = ids_offset
+
+    def __len__(self):
+        return len(self.index)
+
+    def id(self, i):
+        r = self.index[i]
+        start = self.ids_offset + int(r["id_offset"])
+        return self.map[start : start + int(r["id_length"])].decode("utf-8")
+
+    def samples(self, i):
+        """Return the samples of clip i as a 2D array with one row per
+        channel, in the archive's sample format."""
+        r = self.index[i]
+        channels, frames = int(r["channels"]), int(r["frames"])
+        return np.frombuffer(self.map, dtype = self.dtype,
+                             count = channels * frames,
+                             offset = int(r["offset"])).reshape(channels, frames)
+
+    def clip(self, i):
+        """Return the id, samples and sample rate of clip i."""
+        return self.id(i), self.samples(i), float(self.index[i]["sample_rate"])
+
+    def close(self):
+        self.index = None
+        try:
+            self.map.close()
+        except BufferError:
+            pass                # arrays still refer to it: leave it to them
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+def pack(path, clips, sample_format = "float32"):
+    """Write a clip archive of the given clips, an iterable of tuples of
+    id, samples and sample rate, returning the number of clips. If any
+    clip cannot be added, the archive is deleted and the error raised."""
+    n = 0
+    with ArchiveWriter(path, sample_format) as writer:
+        for id, samples, sample_rate in clips:
+            writer.add(id, samples, sample_rate)
+            n = n + 1
+    return n
+
+def pack_files(path, paths, sample_format = "int16", threads = 0):
+    """Write a clip archive of the given WAV files, read concurrently as
+    for vamp.collect_files(), using each file's path as its id.
+    Return the number of clips. If any file cannot be read, the
+    archive is deleted and the error raised."""
+    return pack(path, vampyhost.FilePrefetcher(list(paths), threads), sample_format)
+
+def collect_archive(path, plugin_key, output = "", parameters = {}, transforms = [], batch = 1024, **kwargs):
+    """Process every clip in a clip archive with a Vamp plugin, acting as
+    a generator that yields a tuple of the clip id and the result, as
+    vamp.collect() would return it for that clip alone, for each clip
+    in the order of the archive.
+
+    One instance of the plugin is loaded for each combination of
+    sample rate and channel count found, and reset between clips.
+    Runs of up to batch clips sharing those are processed natively in
+    a single call, reading float32 clips directly from the mapped
+    archive without copying them. The output, parameters, transforms,
+    and keyword arguments are as for vamp.collect().
+    """
+
+    archive = ClipArchive(path)
+    plugins = {}
+
+    try:
+        n = len(archive)
+        i = 0
+        while i < n:
+            key = (float(archive.index[i]["sample_rate"]), int(archive.index[i]["channels"]))
+            j = i + 1
+            while (j < n and j - i < batch and
+                   (float(archive.index[j]["sample_rate"]), int(archive.index[j]["channels"])) == key):
+                j = j + 1
+
+            clips = [ archive.samples(k) for k in range(i, j) ]
+            if archive.dtype != np.float32:
+                clips = [ c.astype(np.float32) / 32768.0 for c in clips ]
+
+            if key not in plugins:
+                plugin, step_size, block_size = vamp.load.load_and_configure(clips[0], key[0], plugin_key, parameters, **kwargs)
+                try:
+                    plugins[key] = (plugin, step_size, clip_outputs(plugin, output))
+                except:
+                    plugin.unload()
+                    raise
+            plugin, step_size, (multiple, outputs, output_descs, shapes, indices) = plugins[key]
+
+            results = plugin.process_clips(clips, indices, transforms)
+            clips = None
+
+            for k, result in zip(range(i, j),
+                                 shape_clip_results(key[0], step_size, multiple, outputs,
+                                                    output_descs, shapes, results)):
+                yield archive.id(k), result
+            i = j
+    finally:
+        for plugin, step_size, _ in plugins.values():
+            plugin.unload()
+        archive.close()
+
+def main():
+    parser = argparse.ArgumentParser(description = "Pack short audio clips into a clip archive, or run a Vamp plugin over every clip in one.")
+    commands = parser.add_subparsers(dest = "command")
+    p = commands.add_parser("pack", help = "pack WAV files into a clip archive")
+    p.add_argument("archive", help = "clip archive to write")
+    p.add_argument("files", nargs = "+", help = "WAV files to pack (each file's path is its id)")
+    p.add_argument("--float32", action = "store_true",
+                   help = "store float32 samples, which are processed without copying, rather than int16")
+    p.add_argument("--threads", type = int, default = 0,
+                   help = "threads to read files with (default one per hardware thread)")
+    c = commands.add_parser("collect", help = "run a plugin over every clip, writing CSV with the clip id in the first column")
+    c.add_argument("archive", help = "clip archive to read")
+    c.add_argument("plugin", help = "plugin key")
+    c.add_argument("--output", default = "", help = "output identifier (default the first)")
+    c.add_argument("--csv", help = "CSV file to write (default standard output)")
+    args = parser.parse_args()
+
+    if args.command == "pack":
+        n = pack_files(args.archive, args.files,
+                       "float32" if args.float32 else "int16", args.threads)
+        print("Packed %d clips into %s" % (n, args.archive))
+    elif args.command == "collect":
+        out = open(args.csv, "wb") if args.csv else sys.stdout
+        try:
+            for id, result in collect_archive(args.archive, args.plugin, args.output):
+                vamp.export.write_csv(result, out, source = id)
+        finally:
+            if args.csv:
+                out.close()
+    else:
+        parser.print_help()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+import vamp.load
+from vamp.collect import collect, deduce_shape, get_feature_step_time, timestamp_features
+from vamp.pool import segment_times
+
+import math
+import numpy as np
+
+def active_regions(gate, condition, end_time, min_gap = 0.0):
+    """Return arrays of start and end times in seconds of the regions
+    in which a result returned by vamp.collect() satisfies the given
+    condition. See cascade() for the forms the condition may take.
+    Regions separated by less than min_gap seconds are merged.
+    """
+
+    if "list" in gate:
+        features = gate["list"]
+        starts, ends = segment_times(features, end_time)
+        if callable(condition):
+            active = [ bool(condition(f)) for f in features ]
+        else:
+            active = [ "values" in f and len(f["values"]) > 0 and
+                       f["values"][0] >= condition for f in features ]
+        active = np.array(active, dtype = bool)
+        starts = starts[active]
+        ends = ends[active]
+        order = np.argsort(starts, kind = "mergesort")
+        starts = starts[order]
+        ends = ends[order]
+    else:
+        if "matrix" in gate:
+            step, values = gate["matrix"]
+        else:
+            step, values = gate["vector"]
+        step = float(step)
+        if callable(condition):
+            active = np.asarray(condition(values), dtype = bool)
+        elif values.ndim == 2:
+            active = values.max(axis = 1) >= condition
+        else:
+            active = values >= condition
+        edges = np.diff(np.concatenate(([0], active.astype(np.int8), [0])))
+        starts = np.flatnonzero(edges == 1) * step
+        ends = np.minimum(np.flatnonzero(edges == -1) * step, end_time)
+
+    merged_starts = []
+    merged_ends = []
+    for (s, e) in zip(starts, ends):
+        if merged_ends and s - merged_ends[-1] < min_gap:
+            merged_ends[-1] = max(merged_ends[-1], e)
+        else:
+            merged_starts.append(s)
+            merged_ends.append(e)
+
+    return (np.array(merged_starts), np.array(merged_ends))
+
+def cascade(data, sample_rate, gate_key, gate_output, plugin_key, output = "", condition = 0.5, pre_roll = 0.0, min_gap = 0.0, gate_parameters = {}, parameters = {}, transforms = [], **kwargs):
+    """Run a cheap "gate" plugin over the whole of the audio data, and
+    then run a more expensive plugin only over the regions in which
+    the gate's output is active, e.g. running a pitch tracker only
+    where an energy or voice activity detector fires.
+
+    The gate plugin (gate_key, with its output gate_output and
+    parameters gate_parameters) is run with vamp.collect(), using its
+    preferred step and block size. The active regions are derived
+    from its result according to the condition, which may be:
+
+    * A number. For a "vector" result, a region is active where the
+    value is at least this; for a "matrix" result, where the largest
+    value in the row is. For a "list" result, each feature whose
+    first value is at least this is active, from its timestamp for
+    its duration, or until the next feature if it has no duration.
+
+    * A function. For a "vector" or "matrix" result, it is called
+    with the whole array of values and should return an array of
+    booleans, one per row; for a "list" result, it is called with
+    each feature dictionary and should return a boolean, so that
+    (for example) features may be chosen by label.
+
+    Regions separated by less than min_gap seconds are merged into
+    one. The plugin with the given plugin_key is then run natively
+    over each region separately, from a reset, starting pre_roll
+    seconds early so that it has some context to warm up with.
+    Features from the pre-roll are discarded, and timestamps are
+    those within the whole of the audio data. The data is not copied
+    for each region.
+
+    The return value is a list with one element per region, each a
+    dictionary containing "start" and "end" times (RealTime) of the
+    region and the region's results from the requested output, in
+    the same form as vamp.collect() returns them. For a "vector" or
+    "matrix" result, an "origin" element gives the time of the first
+    row of values.
+
+    The transforms, and the step size, block size, and process
+    timestamp method keyword arguments, are as for vamp.collect(),
+    and apply to the expensive plugin.
+    """
+
+    n = np.shape(data)[-1]
+    end_time = float(n) / sample_rate
+
+    gate = collect(data, sample_rate, gate_key, gate_output, gate_parameters)
+    starts, ends = active_regions(gate, condition, end_time, min_gap)
+
+    plugin, step_size, block_size = vamp.load.load_and_configure(data, sample_rate, plugin_key, parameters, **kwargs)
+
+    try:
+        if output == "":
+            output_desc = plugin.get_output(0)
+        else:
+            output_desc = plugin.get_output(output)
+
+        shape = deduce_shape(output_desc)
+
+        frames = []
+        for (s, e) in zip(starts, ends):
+            start = int(math.floor(s * sample_rate + 0.5))
+            end = int(math.floor(e * sample_rate + 0.5))
+            first = max(0, start - int(pre_roll * sample_rate + 0.5))
+            frames.append((first, start, end))
+
+        results = plugin.collect_regions(data, output_desc["output_index"],
+                                         [ (first, end) for (first, start, end) in frames ],
+                                         transforms)
+    finally:
+        plugin.unload()
+
+    rvs = []
+
+    for ((first, start, end), result) in zip(frames, results):
+
+        rv = { "start": vampyhost.frame_to_realtime(start, sample_rate),
+               "end": vampyhost.frame_to_realtime(end, sample_rate) }
+
+        if shape == "list":
+            features = timestamp_features(sample_rate, step_size,
+                                          output_desc, result, first)
+            rv["list"] = [ f for f in features if f["timestamp"] >= rv["start"] ]
+        else:
+            if result.ndim == 2:
+                shape = "matrix"
+            out_step = get_feature_step_time(sample_rate, step_size, output_desc)
+            step = out_step.to_float()
+            skip = int(math.ceil(float(start - first) / sample_rate / step - 1e-9))
+            skip = min(skip, len(result))
+            if output_desc["sampleType"] == vampyhost.ONE_SAMPLE_PER_STEP:
+                rv["origin"] = vampyhost.frame_to_realtime(first + skip * step_size, sample_rate)
+            else:
+                rv["origin"] = (vampyhost.frame_to_realtime(first, sample_rate) +
+                                vampyhost.RealTime('seconds', skip * step))
+            rv[shape] = ( out_step, result[skip:] )
+
+        rvs.append(rv)
+
+    return rvs
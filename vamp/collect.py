@@ -31,10 +31,9 @@
 
 import vampyhost
 import vamp.load
-import vamp.process
-import vamp.frames
 
 import numpy as np
+import tempfile
 
 def get_feature_step_time(sample_rate, step_size, output_desc):
     if output_desc["sampleType"] == vampyhost.ONE_SAMPLE_PER_STEP:
@@ -44,16 +43,17 @@ def get_feature_step_time(sample_rate, step_size, output_desc):
     else:
         return 1
 
-def timestamp_features(sample_rate, step_size, output_desc, features):
+def timestamp_features(sample_rate, step_size, output_desc, features, start_frame = 0):
     n = -1
     if output_desc["sampleType"] == vampyhost.ONE_SAMPLE_PER_STEP:
         for f in features:
             n = n + 1
-            t = vampyhost.frame_to_realtime(n * step_size, sample_rate)
+            t = vampyhost.frame_to_realtime(start_frame + n * step_size, sample_rate)
             f["timestamp"] = t
             yield f
     elif output_desc["sampleType"] == vampyhost.FIXED_SAMPLE_RATE:
         output_rate = output_desc["sampleRate"]
+        n = int(float(start_frame) / sample_rate * output_rate + 0.5) - 1
         for f in features:
             if "has_timestamp" in f:
                 n = int(f["timestamp"].to_float() * output_rate + 0.5)
@@ -65,17 +65,6 @@ def timestamp_features(sample_rate, step_size, output_desc, features):
         for f in features:
             yield f
 
-def fill_timestamps(results, sample_rate, step_size, output_desc):
-
-    output = output_desc["identifier"]
-    
-    selected = ( r[output] for r in results )
-
-    stamped = timestamp_features(sample_rate, step_size, output_desc, selected)
-
-    for s in stamped:
-        yield s
-
 def deduce_shape(output_desc):
     if output_desc["hasDuration"]:
         return "list"
@@ -90,25 +79,30 @@ def deduce_shape(output_desc):
     return "matrix"
 
 
-def reshape(results, sample_rate, step_size, output_desc, shape):
-
-    output = output_desc["identifier"]
-    out_step = get_feature_step_time(sample_rate, step_size, output_desc)
+def sparse_matrix(results):
+    import scipy.sparse
+    data, indices, indptr, shape = results
+    return scipy.sparse.csr_matrix((data, indices, indptr), shape = shape, copy = False)
 
-    if shape == "vector":
-        rv = ( out_step,
-               np.array([r[output]["values"][0] for r in results], np.float32) )
-    elif shape == "matrix":
-        #!!! todo: check that each feature has the right number of bins?
-        outseq = [r[output]["values"] for r in results]
-        rv = ( out_step, np.array(outseq, np.float32) )
+def shape_result(sample_rate, step_size, output_desc, shape, results):
+    if shape == "list":
+        rv = list(timestamp_features(sample_rate, step_size, output_desc, results))
     else:
-        rv = list(fill_timestamps(results, sample_rate, step_size, output_desc))
+        if isinstance(results, tuple):
+            results = sparse_matrix(results)
+        if results.ndim == 2:
+            shape = "matrix"
+        out_step = get_feature_step_time(sample_rate, step_size, output_desc)
+        rv = ( out_step, results )
+    return { shape : rv }
+
+def out_arrays(out, outputs):
+    if out is None:
+        return None
+    return [ out.get(o) for o in outputs ]
 
-    return rv
 
-        
-def collect(data, sample_rate, plugin_key, output = "", parameters = {}, **kwargs):
+def collect(data, sample_rate, plugin_key, output = "", parameters = {}, transforms = [], memory_limit = None, sparse = False, out = None, out_times = None, **kwargs):
     """Process audio data with a Vamp plugin, and make the results from a
     single plugin output available as a single structure.
 
@@ -151,33 +145,247 @@ def collect(data, sample_rate, plugin_key, output = "", parameters = {}, **kwarg
     (optionally), a label (string), and a 1-dimensional array of
     float values.
 
+    If output is a list of output identifiers rather than a single
+    one, all of those outputs are collected together in a single
+    processing pass, and the return value is a dictionary mapping
+    each of the given identifiers to a result dictionary as described
+    above. This is much faster than collecting each output separately.
+    The identifiers must be distinct.
+
+    If the transforms list is non-empty, each of its transforms is
+    applied in turn to the values of every feature, natively, as the
+    feature is collected. This is only possible for results with the
+    "vector" or "matrix" shape; when collecting a list of outputs,
+    they are applied to each output that has one of those shapes. The
+    available transforms are:
+
+    * "log" or ("log", floor): natural logarithm of each value, with
+    values below floor (default 1e-10) taken to be equal to it.
+
+    * "db" or ("db", floor): 10 * log10 of each value, with values
+    below floor (default 1e-10) taken to be equal to it.
+
+    * ("clip", min, max): limit each value to the range min to max.
+
+    * "l2": scale each feature's values to have unit L2 norm.
+
+    * "delta": append the difference between each feature's values
+    and those of the previous feature, doubling the number of values
+    per feature. The first feature has zero differences.
+
+    * "delta2": as "delta", and also append the difference between
+    consecutive deltas, tripling the number of values per feature.
+
+    A "vector" result transformed with "delta" or "delta2" is returned
+    with the "matrix" shape.
+
+    If memory_limit is given, no more than roughly that many bytes of
+    "vector" or "matrix" values are held in memory at once during
+    collection, in total across all of the outputs collected. Beyond
+    that, values are written out in chunks to a temporary file, and
+    the array returned is mapped from that file (as a view of a
+    numpy.memmap) and read on demand. (Copy-on-write: the array may be
+    modified without affecting the file.) The file is deleted
+    automatically when the array is no longer referenced.
+
+    If sparse is True, "matrix" results are returned as SciPy
+    compressed sparse row matrices (scipy.sparse.csr_matrix) in place
+    of NumPy arrays, with only the non-zero values stored. They are
+    built natively as the features arrive and adopted by SciPy without
+    copying. For outputs that are mostly zeros, such as note
+    activations, this takes a fraction of the memory. SciPy must be
+    installed. This cannot be combined with memory_limit.
+
+    If out is given, "vector" or "matrix" values are written straight
+    into it, rather than into a newly allocated array, and the array
+    returned is a view of its first rows, those that were written. It
+    must be a writeable C-contiguous float32 array of the dimensions
+    the result would have (one-dimensional for the "vector" shape),
+    with at least as many rows as there will be features: for
+    example, an array in shared memory that is reused for every call.
+    If out_times is given, a writeable float64 array, the timestamp in
+    seconds of each feature is written into it too. When collecting
+    a list of outputs, out and out_times may be dictionaries mapping
+    output identifier to array. These cannot be combined with
+    memory_limit or sparse.
+
     If you wish to override the processing step size, block size, or
     process timestamp method, you may supply them as keyword arguments
     with the keywords step_size (int), block_size (int), and
     process_timestamp_method (choose from vamp.vampyhost.SHIFT_DATA,
     vamp.vampyhost.SHIFT_TIMESTAMP, or vamp.vampyhost.NO_SHIFT).
 
+    For plugins that slow down on denormal input, or audio that may
+    contain NaNs, supply flush_denormals = True to run the plugin with
+    denormals flushed to zero, and scrub_input = True to replace NaN,
+    infinite and denormal samples with zero as the input is converted.
+
     If you would prefer to obtain features as they are calculated
     (where the plugin supports this) and with the format in which the
     plugin returns them, via an asynchronous generator function, use
     vamp.process() instead.
     """
 
+    check_distinct_outputs(output)
+
     plugin, step_size, block_size = vamp.load.load_and_configure(data, sample_rate, plugin_key, parameters, **kwargs)
 
-    if output == "":
-        output_desc = plugin.get_output(0)
-        output = output_desc["identifier"]
+    multiple = isinstance(output, list)
+    if multiple:
+        outputs = output
     else:
-        output_desc = plugin.get_output(output)
-
-    ff = vamp.frames.frames_from_array(data, step_size, block_size)
+        outputs = [ output ]
 
-    results = vamp.process.process_with_initialised_plugin(ff, sample_rate, step_size, plugin, [output])
-
-    shape = deduce_shape(output_desc)
-    rv = reshape(results, sample_rate, step_size, output_desc, shape)
+    try:
+        output_descs = []
+        for o in outputs:
+            if o == "":
+                output_descs.append(plugin.get_output(0))
+            else:
+                output_descs.append(plugin.get_output(o))
+    except:
+        plugin.unload()
+        raise
+
+    shapes = [ deduce_shape(desc) for desc in output_descs ]
+    indices = [ desc["output_index"] for desc in output_descs ]
+
+    if memory_limit and sparse:
+        plugin.unload()
+        raise ValueError("Sparse collection cannot be combined with a memory limit")
+
+    if (out is not None or out_times is not None) and (memory_limit or sparse):
+        plugin.unload()
+        raise ValueError("Out arrays cannot be combined with a memory limit or sparse collection")
+
+    if multiple:
+        out = out_arrays(out, outputs)
+        out_times = out_arrays(out_times, outputs)
+
+    spill_files = [ None ] * len(outputs)
+    if memory_limit:
+        spill_files = [ None if shape == "list" else tempfile.TemporaryFile()
+                        for shape in shapes ]
+
+    try:
+        if multiple:
+            results = plugin.collect(data, indices, transforms,
+                                     memory_limit or 0, spill_files, sparse,
+                                     out, out_times)
+        else:
+            results = [ plugin.collect(data, indices[0], transforms,
+                                       memory_limit or 0, spill_files[0],
+                                       sparse, out, out_times) ]
+    finally:
+        plugin.unload()
+        for spill_file in spill_files:
+            if spill_file is not None:
+                # Any memmap of the file keeps its own mapping open
+                spill_file.close()
+
+    rvs = [ shape_result(sample_rate, step_size, desc, shape, result)
+            for (desc, shape, result) in zip(output_descs, shapes, results) ]
+
+    if multiple:
+        return dict(zip(outputs, rvs))
+    else:
+        return rvs[0]
+
+
+def check_distinct_outputs(output):
+    """Raise ValueError if a list of outputs names any output twice, as
+    the results are returned in a dictionary keyed by output."""
+    if isinstance(output, list) and len(set(output)) != len(output):
+        raise ValueError("Output list " + str(output) + " contains duplicates")
+
+def clip_outputs(plugin, output):
+    """Look up the output or list of outputs to be collected from clips,
+    returning whether a list was given, the list of output
+    identifiers, and their descriptors, shapes and indices."""
+    check_distinct_outputs(output)
+    multiple = isinstance(output, list)
+    outputs = output if multiple else [ output ]
+    output_descs = []
+    for o in outputs:
+        if o == "":
+            output_descs.append(plugin.get_output(0))
+        else:
+            output_descs.append(plugin.get_output(o))
+    shapes = [ deduce_shape(desc) for desc in output_descs ]
+    indices = [ desc["output_index"] for desc in output_descs ]
+    return multiple, outputs, output_descs, shapes, indices
+
+def shape_clip_results(sample_rate, step_size, multiple, outputs, output_descs, shapes, results):
+    rvs = []
+    for clip_results in results:
+        clip_rvs = [ shape_result(sample_rate, step_size, desc, shape, result)
+                     for (desc, shape, result) in zip(output_descs, shapes, clip_results) ]
+        if multiple:
+            rvs.append(dict(zip(outputs, clip_rvs)))
+        else:
+            rvs.append(clip_rvs[0])
+    return rvs
+
+def collect_clips(clips, sample_rate, plugin_key, output = "", parameters = {}, transforms = [], out = None, out_times = None, **kwargs):
+    """Process each of a list of short clips of audio with a Vamp plugin,
+    and return a list of results, one per clip, each as vamp.collect()
+    would return it for that clip alone.
+
+    A single instance of the plugin is loaded and initialised, and
+    reset between clips, and all of the clips are processed natively
+    in a single call. For large numbers of clips of a few seconds
+    each, this avoids the cost of loading and initialising the plugin
+    for every clip, which is otherwise most of the time taken.
+
+    The clips must all have the same number of channels. The output,
+    parameters, transforms, and keyword arguments are as for
+    vamp.collect(). If out or out_times is given, it is a list with an
+    entry for each clip, as vamp.collect() accepts for that clip alone.
+    """
 
-    plugin.unload()
-    return { shape : rv }
+    if len(clips) == 0:
+        return []
+
+    plugin, step_size, block_size = vamp.load.load_and_configure(np.asarray(clips[0]), sample_rate, plugin_key, parameters, **kwargs)
+
+    try:
+        multiple, outputs, output_descs, shapes, indices = clip_outputs(plugin, output)
+        if multiple:
+            if out is not None:
+                out = [ out_arrays(o, outputs) for o in out ]
+            if out_times is not None:
+                out_times = [ out_arrays(o, outputs) for o in out_times ]
+        else:
+            if out is not None:
+                out = [ [ o ] for o in out ]
+            if out_times is not None:
+                out_times = [ [ o ] for o in out_times ]
+        results = plugin.process_clips(clips, indices, transforms, out, out_times)
+    finally:
+        plugin.unload()
+
+    return shape_clip_results(sample_rate, step_size, multiple, outputs,
+                              output_descs, shapes, results)
+
+def collect_files(paths, plugin_key, output = "", parameters = {}, transforms = [], threads = 0, max_bytes = 256 << 20, **kwargs):
+    """Process each of a list of WAV files with a Vamp plugin, acting as
+    a generator that yields a tuple of the path and the result, as
+    vamp.collect() would return it for that file's audio, for each
+    file in turn.
+
+    The files are read and decoded ahead of their processing, natively
+    and on a pool of threads (one per hardware thread if threads is
+    0), with many reads in flight at once, so that for a batch of
+    files on fast storage the reading is overlapped with processing
+    rather than done one file at a time. No more than about max_bytes
+    of memory is held for files read ahead, counting both the bytes
+    being read and the decoded samples. A file that cannot be read raises
+    IOError when its turn comes.
+
+    Only WAV files of integer PCM or floating-point samples can be
+    read. The output, parameters, transforms, and keyword arguments
+    are as for vamp.collect().
+    """
 
+    for path, data, sample_rate in vampyhost.FilePrefetcher(list(paths), threads, max_bytes):
+        yield path, collect(data, sample_rate, plugin_key, output, parameters, transforms, **kwargs)
@@ -0,0 +1,346 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+import vamp.load
+
+import argparse
+import json
+import sqlite3
+import time
+
+import numpy as np
+
+try:
+    clock = time.perf_counter
+except AttributeError:
+    clock = time.time
+
+# Bytes held per collected feature value (float32) and per feature
+# timestamp (float64), as in the arrays returned by vamp.collect()
+value_bytes = 4
+timestamp_bytes = 8
+
+columns = [ ("plugin_key", "TEXT"),
+            ("sample_rate", "REAL"),
+            ("channels", "INTEGER"),
+            ("step_size", "INTEGER"),
+            ("block_size", "INTEGER"),
+            ("parameters", "TEXT"),
+            ("seconds", "REAL"),
+            ("load_time", "REAL"),
+            ("initialise_time", "REAL"),
+            ("blocks", "INTEGER"),
+            ("block_mean", "REAL"),
+            ("block_p99", "REAL"),
+            ("block_max", "REAL"),
+            ("remaining_time", "REAL"),
+            ("realtime_factor", "REAL"),
+            ("features_per_hour", "REAL"),
+            ("bytes_per_hour", "REAL"),
+            ("outputs", "TEXT"),
+            ("recorded", "REAL") ]
+
+class MeasurementError(Exception):
+    """Raised by measure() when the plugin cannot be loaded or
+    initialised in the configuration requested."""
+    pass
+
+def measure(plugin_key, sample_rate = 44100.0, channels = 1, step_size = 0,
+            block_size = 0, parameters = {}, seconds = 10.0):
+    """Measure the cost of running the plugin with the given key in a
+    single configuration, over the given number of seconds of noise,
+    and return the measurements in a dictionary.
+
+    The times measured, in seconds, are those taken to load the plugin
+    (load_time), to initialise it (initialise_time), to process each
+    block (block_mean, block_p99, block_max) and to return its
+    remaining features at the end (remaining_time). The realtime_factor
+    is the total processing time divided by the duration of the audio,
+    so that a value below 1 means the plugin runs faster than real
+    time. The output volume is given as the number of features
+    (features_per_hour) and the bytes of collected values and
+    timestamps (bytes_per_hour) that an hour of audio would produce,
+    and per output identifier in the outputs dictionary.
+
+    A step_size or block_size of 0 means the plugin's preferred size,
+    as for vamp.collect(). If the plugin cannot be loaded or
+    initialised, MeasurementError is raised.
+    """
+    t0 = clock()
+    try:
+        plug = vampyhost.load_plugin(plugin_key, sample_rate,
+                                     vampyhost.ADAPT_INPUT_DOMAIN +
+                                     vampyhost.ADAPT_CHANNEL_COUNT)
+    except TypeError as e:
+        raise MeasurementError(str(e))
+    load_time = clock() - t0
+
+    plug.set_parameter_values(parameters)
+
+    if block_size == 0:
+        block_size = plug.get_preferred_block_size() or 1024
+    if step_size == 0:
+        step_size = plug.get_preferred_step_size() or block_size
+
+    t0 = clock()
+    try:
+        initialised = plug.initialise(channels, step_size, block_size)
+    except TypeError:
+        initialised = False
+    if not initialised:
+        plug.unload()
+        raise MeasurementError("Failed to initialise plugin %s with %d channels, step %d, block %d" %
+                               (plugin_key, channels, step_size, block_size))
+    initialise_time = clock() - t0
+
+    outputs = [ o["identifier"] for o in plug.get_outputs() ]
+    counts = [ 0 ] * len(outputs)
+    values = [ 0 ] * len(outputs)
+
+    def tally(fs):
+        for index, fl in fs.items():
+            counts[index] += len(fl)
+            for f in fl:
+                if "values" in f:
+                    values[index] += len(f["values"])
+
+    rng = np.random.RandomState(0)
+    frames = max(int(seconds * sample_rate), block_size)
+    audio = rng.uniform(-1, 1, (channels, frames)).astype(np.float32)
+
+    times = []
+    for i in range(0, frames - block_size + 1, step_size):
+        block = audio[:, i : i + block_size]
+        timestamp = vampyhost.frame_to_realtime(i, sample_rate)
+        t0 = clock()
+        fs = plug.process_block(block, timestamp)
+        times.append(clock() - t0)
+        tally(fs)
+
+    t0 = clock()
+    fs = plug.get_remaining_features()
+    remaining_time = clock() - t0
+    tally(fs)
+
+    plug.unload()
+
+    duration = float(frames) / sample_rate
+    scale = 3600.0 / duration
+    times = np.array(times)
+    per_output = {}
+    for index, output in enumerate(outputs):
+        per_output[output] = {
+            "features_per_hour": counts[index] * scale,
+            "bytes_per_hour": (values[index] * value_bytes +
+                               counts[index] * timestamp_bytes) * scale }
+
+    return { "plugin_key": plugin_key,
+             "sample_rate": float(sample_rate),
+             "channels": channels,
+             "step_size": step_size,
+             "block_size": block_size,
+             "parameters": dict(parameters),
+             "seconds": duration,
+             "load_time": load_time,
+             "initialise_time": initialise_time,
+             "blocks": len(times),
+             "block_mean": float(times.mean()),
+             "block_p99": float(np.percentile(times, 99)),
+             "block_max": float(times.max()),
+             "remaining_time": remaining_time,
+             "realtime_factor": (float(times.sum()) + remaining_time) / duration,
+             "features_per_hour": sum(o["features_per_hour"] for o in per_output.values()),
+             "bytes_per_hour": sum(o["bytes_per_hour"] for o in per_output.values()),
+             "outputs": per_output,
+             "recorded": time.time() }
+
+def profile(plugin_keys = None, configurations = [ {} ], sample_rate = 44100.0,
+            seconds = 10.0, database = None, failures = None):
+    """Measure the cost of each of the given plugins (or of every
+    installed plugin, as returned by vamp.list_plugins(), if
+    plugin_keys is None) in each of the given configurations, and
+    return a list of the measurement dictionaries returned by
+    measure().
+
+    Each configuration is a dictionary of keyword arguments for
+    measure(), such as { "channels": 2, "block_size": 2048 }; an empty
+    dictionary means the plugin's preferred sizes with one channel.
+    Plugins that cannot be loaded or initialised in a configuration
+    are skipped; if a failures list is given, a tuple of the plugin
+    key, configuration and error message is appended to it for each.
+    If a ProfileDatabase is given, each measurement is also recorded
+    in it.
+    """
+    if plugin_keys is None:
+        plugin_keys = vamp.load.list_plugins()
+    results = []
+    for key in plugin_keys:
+        for config in configurations:
+            args = { "sample_rate": sample_rate, "seconds": seconds }
+            args.update(config)
+            try:
+                m = measure(key, **args)
+            except MeasurementError as e:
+                if failures is not None:
+                    failures.append((key, config, str(e)))
+                continue
+            if database is not None:
+                database.record(m)
+            results.append(m)
+    return results
+
+class ProfileDatabase(object):
+    """A store of plugin cost measurements, kept in an SQLite database
+    at the given path (or in memory, for the path ":memory:"), for use
+    by schedulers and in capacity planning.
+    """
+
+    def __init__(self, path):
+        self.db = sqlite3.connect(path)
+        self.db.execute("CREATE TABLE IF NOT EXISTS measurements (%s)" %
+                        ", ".join("%s %s" % c for c in columns))
+        self.db.commit()
+
+    def record(self, measurement):
+        """Add the given measurement dictionary, as returned by
+        measure(), to the database.
+        """
+        row = []
+        for name, _ in columns:
+            value = measurement[name]
+            if name in ("parameters", "outputs"):
+                value = json.dumps(value, sort_keys = True)
+            row.append(value)
+        self.db.execute("INSERT INTO measurements VALUES (%s)" %
+                        ", ".join("?" * len(columns)), row)
+        self.db.commit()
+
+    def measurements(self, plugin_key = None):
+        """Return the recorded measurements, for the given plugin key
+        or for all plugins, as a list of dictionaries in the order in
+        which they were recorded.
+        """
+        query = "SELECT * FROM measurements"
+        args = ()
+        if plugin_key is not None:
+            query += " WHERE plugin_key = ?"
+            args = (plugin_key,)
+        results = []
+        for row in self.db.execute(query + " ORDER BY rowid", args):
+            m = dict(zip([ name for name, _ in columns ], row))
+            m["parameters"] = json.loads(m["parameters"])
+            m["outputs"] = json.loads(m["outputs"])
+            results.append(m)
+        return results
+
+    def latest(self, plugin_key, channels = 1, step_size = None, block_size = None):
+        """Return the most recent measurement for the given plugin with
+        the given channel count and, if given, step and block size, or
+        None if there is none.
+        """
+        found = None
+        for m in self.measurements(plugin_key):
+            if (m["channels"] == channels and
+                step_size in (None, m["step_size"]) and
+                block_size in (None, m["block_size"])):
+                found = m
+        return found
+
+    def close(self):
+        self.db.close()
+
+def predict(measurement, hours = 1.0):
+    """Return a dictionary of the predicted processing time in seconds
+    (including loading and initialising the plugin once) and memory in
+    bytes of collected output for the given number of hours of audio,
+    from a measurement dictionary.
+    """
+    return { "seconds": (measurement["load_time"] +
+                         measurement["initialise_time"] +
+                         measurement["realtime_factor"] * hours * 3600.0),
+             "bytes": measurement["bytes_per_hour"] * hours }
+
+def report(measurements, failures = []):
+    """Return a capacity-planning report of the given measurements as a
+    text table, with one line per plugin and configuration giving the
+    real-time factor, the number of such streams one core could keep
+    up with in real time, and the output memory per hour of audio,
+    followed by a line for each of the given failures, as collected
+    by profile().
+    """
+    header = ("%-40s %3s %6s %6s %9s %9s %9s %8s %8s %10s" %
+              ("plugin", "ch", "step", "block", "load ms", "init ms",
+               "block us", "rtf", "streams", "MB/hour"))
+    lines = [ header, "-" * len(header) ]
+    for m in measurements:
+        rtf = m["realtime_factor"]
+        streams = "%8d" % int(1.0 / rtf) if rtf > 0 else "%8s" % "-"
+        lines.append("%-40s %3d %6d %6d %9.2f %9.2f %9.1f %8.4f %s %10.2f" %
+                     (m["plugin_key"], m["channels"], m["step_size"],
+                      m["block_size"], m["load_time"] * 1000.0,
+                      m["initialise_time"] * 1000.0,
+                      m["block_mean"] * 1000000.0, rtf, streams,
+                      m["bytes_per_hour"] / 1048576.0))
+    for (key, config, message) in failures:
+        lines.append("%-40s failed %s: %s" %
+                     (key, json.dumps(config, sort_keys = True), message))
+    return "\n".join(lines)
+
+def main():
+    parser = argparse.ArgumentParser(description = "Measure the processing cost of installed Vamp plugins and report predicted real-time factor and memory per hour of audio.")
+    parser.add_argument("database", help = "SQLite profile database to record measurements in")
+    parser.add_argument("--plugin", action = "append",
+                        help = "plugin key to measure (may be repeated; default all installed plugins)")
+    parser.add_argument("--rate", type = float, default = 44100.0,
+                        help = "sample rate (default 44100)")
+    parser.add_argument("--seconds", type = float, default = 10.0,
+                        help = "seconds of audio per measurement (default 10)")
+    parser.add_argument("--channels", default = "1",
+                        help = "comma-separated channel counts (default 1)")
+    parser.add_argument("--block-sizes", default = "0",
+                        help = "comma-separated block sizes, with step equal to block, or 0 for the plugin's preferred sizes (default 0)")
+    parser.add_argument("--report-only", action = "store_true",
+                        help = "report the measurements already in the database without measuring")
+    args = parser.parse_args()
+
+    db = ProfileDatabase(args.database)
+    failures = []
+    if not args.report_only:
+        configurations = [ { "channels": int(c), "block_size": int(b), "step_size": int(b) }
+                           for c in args.channels.split(",")
+                           for b in args.block_sizes.split(",") ]
+        profile(args.plugin, configurations, args.rate, args.seconds, db, failures)
+    print(report(db.measurements(), failures))
+    db.close()
+
+if __name__ == "__main__":
+    main()
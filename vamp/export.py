@@ -0,0 +1,152 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+
+import numpy as np
+
+def open_output(file):
+    """Return a file descriptor for the given file name, file object or
+    descriptor, and a function to call when finished with it."""
+    if isinstance(file, int):
+        return file, lambda: None
+    if hasattr(file, "fileno"):
+        file.flush()
+        return file.fileno(), lambda: None
+    f = open(file, "wb")
+    return f.fileno(), f.close
+
+def collected(result):
+    """Return the shape and content of a result from vamp.collect(), or
+    None if result is something else (such as an iterable of
+    features)."""
+    if isinstance(result, dict) and len(result) == 1:
+        shape = list(result.keys())[0]
+        if shape in ("vector", "matrix", "list"):
+            return shape, result[shape]
+    return None
+
+def dense_rows(step, values, times):
+    if hasattr(values, "toarray"):
+        values = values.toarray()
+    if times is None:
+        step = step.to_float() if hasattr(step, "to_float") else float(step)
+        times = np.arange(values.shape[0]) * step
+    return np.asarray(times, dtype = np.float64), values
+
+def write_text(format, result, file, source, times):
+    fd, close = open_output(file)
+    try:
+        c = collected(result)
+        if c is None or c[0] == "list":
+            features = result if c is None else c[1]
+            if source is None:
+                return vampyhost.write_features(fd, format, features)
+            return vampyhost.write_features(fd, format, features, source)
+        times, values = dense_rows(c[1][0], c[1][1], times)
+        if source is None:
+            return vampyhost.write_feature_rows(fd, format, times, values)
+        return vampyhost.write_feature_rows(fd, format, times, values, source)
+    finally:
+        close()
+
+def write_csv(result, file, source = None, times = None):
+    """Write features to a CSV file, in the column layout used by Sonic
+    Annotator, returning the number of bytes written.
+
+    The result may be the return value of vamp.collect() for a single
+    output, or any iterable of feature dicts, such as the generator
+    returned by vamp.process_audio(). Features from a generator are
+    written as they are produced, so the whole run need not be held
+    in memory.
+
+    The file may be a file name, an open binary file object (which is
+    flushed first, then written to through its descriptor) or a file
+    descriptor.
+
+    Each feature becomes a row holding its timestamp and (if it has
+    one) duration in seconds, its values, and its label if not empty.
+    If source is given, it is written, quoted, as an extra first
+    column on the first row, with that column left empty on the rows
+    after, as Sonic Annotator does when writing several files to one
+    stream.
+
+    For "vector" and "matrix" results, row timestamps are multiples
+    of the result's step time, unless times (an array of seconds,
+    such as the out_times filled in by vamp.collect()) is given.
+
+    Formatting and writing are done natively. Values are written with
+    the fewest digits that read back exactly.
+    """
+    return write_text("csv", result, file, source, times)
+
+def write_jsonl(result, file, times = None):
+    """Write features as JSON Lines, one object per feature, returning
+    the number of bytes written.
+
+    Each object has the keys of the feature dict that are present:
+    "timestamp" and "duration" (in seconds), "values" (a list), and
+    "label". NaN and infinite values are written as null. The result,
+    file, and times arguments are as for write_csv().
+    """
+    return write_text("jsonl", result, file, None, times)
+
+def dense_result(result, times):
+    c = collected(result)
+    if c is None or c[0] == "list":
+        raise ValueError("NPY and NPZ output needs a \"vector\" or \"matrix\" result from vamp.collect()")
+    return dense_rows(c[1][0], c[1][1], times)
+
+def write_npy(result, file):
+    """Write the values of a "vector" or "matrix" result from
+    vamp.collect() in NumPy NPY format, returning the number of bytes
+    written. The file argument is as for write_csv().
+    """
+    times, values = dense_result(result, None)
+    fd, close = open_output(file)
+    try:
+        return vampyhost.write_npy(fd, values)
+    finally:
+        close()
+
+def write_npz(result, file, times = None):
+    """Write a "vector" or "matrix" result from vamp.collect() as an
+    uncompressed NumPy NPZ archive holding arrays "times" (in seconds)
+    and "values", returning the number of bytes written. The file and
+    times arguments are as for write_csv(). The archive is written
+    without ZIP64 extensions, so it must be smaller than 4GB.
+    """
+    times, values = dense_result(result, times)
+    fd, close = open_output(file)
+    try:
+        return vampyhost.write_npz(fd, [ ("times", times), ("values", values) ])
+    finally:
+        close()
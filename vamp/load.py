@@ -31,13 +31,21 @@
 
 import vampyhost
 
-def list_plugins():
+def list_plugins(include = None, exclude = None):
     """Obtain a list of plugin keys for all currently installed Vamp plugins.
 
     The returned value is a list of strings, each of which is the key
     for one plugin. (Note that a plugin may have multiple outputs, if
     it computes more than one type of feature.)
 
+    To save time where there are many plugin libraries installed, the
+    libraries examined may be limited by giving a list of include
+    patterns, of which the library name (the part of the plugin key
+    before the colon) must match at least one, and a list of exclude
+    patterns, none of which it may match. Patterns may contain the
+    wildcards * and ?, e.g. [ "qm-*" ]. Libraries that are left out
+    are never opened.
+
     To query the available outputs and category of a plugin, you may
     use vamp.get_outputs_of() and vamp.get_category_of(). Further
     information may be retrieved by loading the plugin and querying
@@ -48,7 +56,7 @@ def list_plugins():
     the plugin key and optionally an output identifier to
     vamp.process() or vamp.collect().
     """
-    return vampyhost.list_plugins()
+    return vampyhost.list_plugins(include, exclude)
 
 def get_outputs_of(plugin_key):
     """Obtain a list of the output identifiers for the given plugin key.
@@ -84,6 +92,12 @@ def load_and_configure(data, sample_rate, plugin_key, parameters, **kwargs):
     arguments with keywords step_size (int), block_size (int), and
     process_timestamp_method (choose from vamp.vampyhost.SHIFT_DATA,
     vamp.vampyhost.SHIFT_TIMESTAMP, or vamp.vampyhost.NO_SHIFT).
+
+    The input passed to the plugin may be conditioned by supplying
+    the keyword arguments flush_denormals (bool), to run the plugin
+    with denormal values flushed to zero, and scrub_input (bool), to
+    replace NaN, infinite and denormal input samples with zero. See
+    set_input_conditioning() in the vampyhost Plugin object.
     """
 
     plug = vampyhost.load_plugin(plugin_key, sample_rate,
@@ -93,6 +107,11 @@ def load_and_configure(data, sample_rate, plugin_key, parameters, **kwargs):
     if "process_timestamp_method" in kwargs:
         plug.set_process_timestamp_method(kwargs.pop("process_timestamp_method"))
 
+    flush_denormals = kwargs.pop("flush_denormals", False)
+    scrub_input = kwargs.pop("scrub_input", False)
+    if flush_denormals or scrub_input:
+        plug.set_input_conditioning(flush_denormals, scrub_input)
+
     plug.set_parameter_values(parameters)
 
     block_size = 0
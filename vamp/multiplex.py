@@ -0,0 +1,142 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+import vamp.load
+
+import numpy as np
+
+class Multiplexer(object):
+    """Run many live audio streams, each with its own plugin, on a
+    small fixed pool of native worker threads.
+
+    Streams are added with add_stream(), which loads and initialises
+    a plugin for the stream and returns an id for it. Audio for each
+    stream is supplied in pieces of any length through push(), into
+    a native ring buffer holding ring_seconds of audio. The workers
+    process each stream whenever a whole block is ready, taking the
+    streams in turn and processing up to batch blocks of one before
+    moving on, without holding the Python interpreter lock. Features
+    are retrieved from each stream, as they become available, through
+    poll().
+
+    If a stream's audio arrives faster than the workers can process
+    it, the ring buffer fills and the excess is dropped; the count of
+    dropped sample frames is given by stats().
+
+    The threads argument gives the number of worker threads, or 0 for
+    one per hardware thread.
+    """
+
+    def __init__(self, threads = 0, batch = 8):
+        self.mux = vampyhost.StreamMultiplexer(threads, batch)
+        self.streams = {}
+
+    def add_stream(self, sample_rate, plugin_key, outputs = [ "" ],
+                   channels = 1, parameters = {}, ring_seconds = 2.0, **kwargs):
+        """Add a stream, processed by a new instance of the given
+        plugin, and return its id.
+
+        The outputs argument gives the identifiers of the outputs to
+        keep; the empty string means the plugin's first output. Each
+        output may be named only once. The channels, parameters, and
+        keyword arguments (step_size, block_size,
+        process_timestamp_method) are as for vamp.collect().
+        """
+        shape_probe = np.zeros((channels, 0), dtype = np.float32)
+        plugin, step_size, block_size = vamp.load.load_and_configure(shape_probe, sample_rate, plugin_key, parameters, **kwargs)
+
+        try:
+            indices = {}
+            for output in outputs:
+                if output == "":
+                    index = 0
+                else:
+                    index = plugin.get_output(output)["output_index"]
+                if index in indices:
+                    raise ValueError("Output list " + str(outputs) + " names the same output more than once")
+                indices[index] = output
+
+            ring_frames = int(ring_seconds * sample_rate)
+            stream = self.mux.add_stream(plugin, ring_frames, list(indices.keys()))
+        except:
+            plugin.unload()
+            raise
+        self.streams[stream] = (indices, False)
+        return stream
+
+    def push(self, stream, data):
+        """Supply the next piece of audio for the given stream, a 1- or
+        2-dimensional array of samples (with one row per channel if
+        2-dimensional). Return the number of sample frames accepted,
+        which is less than the length of the data if the stream's
+        ring buffer is full.
+        """
+        return self.mux.push(stream, data)
+
+    def finish(self, stream):
+        """End the given stream: its remaining audio is processed,
+        padded with silence to a whole block, followed by any features
+        the plugin returns at the end of processing.
+        """
+        self.mux.finish(stream)
+
+    def poll(self, stream):
+        """Return the features produced for the given stream since the
+        last call, as a dictionary mapping output identifier to a list
+        of feature dictionaries, each with a timestamp. Outputs with
+        no new features are omitted.
+        """
+        features, done = self.mux.poll(stream)
+        indices, _ = self.streams[stream]
+        self.streams[stream] = (indices, done)
+        return dict((indices[index], fl) for index, fl in features.items())
+
+    def done(self, stream):
+        """Return True if the given stream has been finished and poll()
+        has returned the last of its features.
+        """
+        return self.streams[stream][1]
+
+    def remove_stream(self, stream):
+        """Remove the given stream and dispose of its plugin, discarding
+        any audio not yet processed and features not yet polled.
+        """
+        self.mux.remove_stream(stream)
+        del self.streams[stream]
+
+    def stats(self):
+        """Return a dictionary of the number of worker threads and
+        current streams, and the total numbers of blocks processed, of
+        batches processed, and of sample frames dropped because a
+        stream's ring buffer was full.
+        """
+        return self.mux.stats()
@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+
+import numpy as np
+
+def segment_times(features, end_time):
+    """Return arrays of start and end times in seconds for a list of
+    features, each of which must have a timestamp. A feature without
+    a duration is taken to last until the next feature starts, or
+    until end_time if it is the last one.
+    """
+    n = len(features)
+    starts = np.zeros(n)
+    ends = np.zeros(n)
+    for i in range(n):
+        starts[i] = features[i]["timestamp"].to_float()
+    for i in range(n):
+        f = features[i]
+        if "duration" in f:
+            ends[i] = starts[i] + f["duration"].to_float()
+        elif i + 1 < n:
+            ends[i] = starts[i + 1]
+        else:
+            ends[i] = max(end_time, starts[i])
+    return (starts, ends)
+
+def pool(dense, segments, method = "mean"):
+    """Summarise a dense feature output over the time segments given
+    by an event or segment output, e.g. to obtain beat-synchronous
+    chroma.
+
+    The dense argument should be a result returned by vamp.collect()
+    that contains a "vector" or "matrix" element. The segments
+    argument should be a result returned by vamp.collect() that
+    contains a "list" element, or a list of feature dictionaries in
+    that form. Each segment starts at its feature's timestamp, and
+    lasts for its duration if it has one or until the next segment
+    starts if not. The last segment without a duration extends to the
+    end of the dense output.
+
+    The method may be one of "mean", "min", "max", "sum", or "std".
+    Each segment is summarised over every row of the dense output
+    whose time span overlaps it, or over the single row containing
+    its start time if it is shorter than one step. Segments lying
+    beyond the end of the dense output receive NaN values.
+
+    The result is a tuple of a list of segment start times (RealTime
+    objects) and a NumPy array of pooled values, having one row per
+    segment and the same number of columns as the dense input.
+    """
+
+    if "matrix" in dense:
+        step, values = dense["matrix"]
+    elif "vector" in dense:
+        step, values = dense["vector"]
+    else:
+        raise Exception("Dense input must contain a vector or matrix result")
+
+    if isinstance(segments, dict):
+        if "list" not in segments:
+            raise Exception("Segment input must contain a list result")
+        segments = segments["list"]
+
+    step = float(step)
+    starts, ends = segment_times(segments, len(values) * step)
+
+    pooled = vampyhost.pool_segments(values, step, starts, ends, method)
+
+    return ([ f["timestamp"] for f in segments ], pooled)
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+import vamp.load
+from vamp.collect import deduce_shape
+
+import math
+import numpy as np
+
+class RollingProcessor(object):
+    """Run a Vamp plugin over a live stream of audio, keeping the
+    most recent features from one or more of its outputs available
+    at all times, in a fixed amount of memory.
+
+    Audio is supplied in pieces of any length through feed(), and
+    the last seconds of each output may be retrieved at any point
+    through snapshot(). Each output is held in a native ring buffer
+    of fixed capacity, so memory use does not grow however long the
+    stream runs.
+
+    The outputs argument gives the identifiers of the outputs to
+    keep; the empty string means the plugin's first output. The
+    capacity for each output is enough for the given number of
+    seconds of features at the output's step or sample rate. Outputs
+    with no fixed rate keep up to list_capacity features.
+
+    The transforms list, as for vamp.collect(), is applied to every
+    output that has the "vector" or "matrix" shape. The channels,
+    parameters, and keyword arguments (step_size, block_size,
+    process_timestamp_method) are as for vamp.collect().
+    """
+
+    def __init__(self, sample_rate, plugin_key, outputs = [ "" ], seconds = 30.0,
+                 channels = 1, parameters = {}, transforms = [],
+                 list_capacity = 1024, **kwargs):
+
+        self.sample_rate = sample_rate
+        self.channels = channels
+
+        shape_probe = np.zeros((channels, 0), dtype = np.float32)
+        self.plugin, self.step_size, self.block_size = vamp.load.load_and_configure(shape_probe, sample_rate, plugin_key, parameters, **kwargs)
+
+        self.outputs = {}
+        for output in outputs:
+            if output == "":
+                desc = self.plugin.get_output(0)
+            else:
+                desc = self.plugin.get_output(output)
+            shape = deduce_shape(desc)
+            if desc["sampleType"] == vampyhost.ONE_SAMPLE_PER_STEP:
+                capacity = int(math.ceil(seconds * sample_rate / self.step_size))
+            elif (desc["sampleType"] == vampyhost.FIXED_SAMPLE_RATE and
+                  desc["sampleRate"] > 0):
+                capacity = int(math.ceil(seconds * desc["sampleRate"]))
+            else:
+                capacity = list_capacity
+            index = desc["output_index"]
+            self.plugin.attach_rolling(index, max(capacity, 1),
+                                       [] if shape == "list" else transforms)
+            self.outputs[output] = (index, shape)
+
+        self.pending = np.zeros((channels, 0), dtype = np.float32)
+        self.frame = 0
+
+    def feed(self, data):
+        """Supply the next piece of the audio stream, a 1- or
+        2-dimensional array of samples (with one row per channel if
+        2-dimensional). Every complete processing block available is
+        processed; any remainder is kept until the next call.
+        """
+        data = np.asarray(data, dtype = np.float32)
+        if data.ndim == 1:
+            data = data.reshape((1, len(data)))
+        self.pending = np.concatenate((self.pending, data), axis = 1)
+        start = 0
+        while self.pending.shape[1] - start >= self.block_size:
+            block = self.pending[:, start : start + self.block_size]
+            timestamp = vampyhost.frame_to_realtime(self.frame, self.sample_rate)
+            self.plugin.process_block(block, timestamp)
+            start = start + self.step_size
+            self.frame = self.frame + self.step_size
+        self.pending = self.pending[:, start:]
+
+    def finish(self):
+        """End the stream: process any remaining audio, padded with
+        silence, until every remaining frame has started a block (as
+        vamp.collect() does), and collect any features the plugin
+        returns at the end of processing.
+        """
+        remaining = self.pending.shape[1]
+        if remaining > 0:
+            last = ((remaining - 1) // self.step_size) * self.step_size
+            padding = last + self.block_size - remaining
+            self.feed(np.zeros((self.channels, padding), dtype = np.float32))
+            self.pending = np.zeros((self.channels, 0), dtype = np.float32)
+        self.plugin.get_remaining_features()
+
+    def snapshot(self, output = "", contiguous = True):
+        """Return the features currently held for the given output,
+        oldest first, in a dictionary with a single element whose key
+        is "vector", "matrix", or "list" as for vamp.collect().
+
+        For the "vector" and "matrix" shapes, the element contains a
+        tuple of a NumPy array of timestamps in seconds, one per
+        feature, and an array of feature values. If contiguous is
+        False, it instead contains a list of one or two such tuples,
+        which together hold the features in order and whose arrays
+        are read-only views of the ring buffer without any copying.
+        Such views change as further audio is fed, so they should be
+        used or copied straight away.
+
+        For the "list" shape, the element contains a list of feature
+        dictionaries, each with a timestamp.
+        """
+        index, shape = self.outputs[output]
+        result = self.plugin.rolling_snapshot(index, contiguous)
+        if shape != "list":
+            values = result[1] if contiguous else result[0][1]
+            shape = "vector" if values.ndim == 1 else "matrix"
+        return { shape : result }
+
+    def reset(self):
+        """Discard all features held and any pending audio, and reset
+        the plugin, ready to start a new stream.
+        """
+        self.plugin.reset()
+        self.pending = np.zeros((self.channels, 0), dtype = np.float32)
+        self.frame = 0
+
+    def unload(self):
+        """Dispose of the plugin. Snapshots already taken remain valid.
+        """
+        self.plugin.unload()
@@ -0,0 +1,83 @@
+#!/usr/bin/env python
+
+#   Python Vamp Host
+#   Copyright (c) 2008-2015 Queen Mary, University of London
+#
+#   Permission is hereby granted, free of charge, to any person
+#   obtaining a copy of this software and associated documentation
+#   files (the "Software"), to deal in the Software without
+#   restriction, including without limitation the rights to use, copy,
+#   modify, merge, publish, distribute, sublicense, and/or sell copies
+#   of the Software, and to permit persons to whom the Software is
+#   furnished to do so, subject to the following conditions:
+#
+#   The above copyright notice and this permission notice shall be
+#   included in all copies or substantial portions of the Software.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+#   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+#   CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#   Except as contained in this notice, the names of the Centre for
+#   Digital Music and Queen Mary, University of London shall not be
+#   used in advertising or otherwise to promote the sale, use or other
+#   dealings in this Software without prior written authorization.
+
+'''A high-level interface to the vampyhost extension module, for quickly and easily running Vamp audio analysis plugins on audio files and buffers.'''
+
+import vampyhost
+
+import numpy as np
+
+def self_similarity(dense, metric = "cosine", band = None, dtype = np.float32, threads = 0):
+    """Compare every step of a dense feature output with every other,
+    e.g. to obtain a self-similarity matrix of chroma or MFCC
+    features for structural segmentation.
+
+    The dense argument should be a result returned by vamp.collect()
+    that contains a "vector" or "matrix" element, or a NumPy array
+    with one row per step.
+
+    The metric may be "cosine", for the cosine similarity between
+    rows (1 for rows pointing the same way, 0 for orthogonal or
+    all-zero rows), or "euclidean", for the Euclidean distance
+    between them.
+
+    By default the result is a square array with one row and column
+    per step. If band is given, only steps within band steps of one
+    another are compared, and the result has one row per step and
+    band + 1 columns, column k holding the value for the step k steps
+    later (or NaN past the end). This takes far less time and memory
+    for long inputs, where only the near-diagonal is wanted.
+
+    The dtype may be np.float32 or np.float16; half precision halves
+    the size of the result. The computation is shared across the
+    given number of threads, or one thread per core if threads is 0.
+    """
+
+    if isinstance(dense, dict):
+        if "matrix" in dense:
+            step, dense = dense["matrix"]
+        elif "vector" in dense:
+            step, dense = dense["vector"]
+        else:
+            raise Exception("Dense input must contain a vector or matrix result")
+
+    dtype = np.dtype(dtype)
+    if dtype == np.float16:
+        half = True
+    elif dtype == np.float32:
+        half = False
+    else:
+        raise ValueError("Result dtype must be float32 or float16")
+
+    if band is None:
+        band = -1
+    elif band < 0:
+        raise ValueError("Band must not be negative")
+
+    return vampyhost.self_similarity(dense, metric, band, half, threads)